@@ -0,0 +1,60 @@
+#include <core/world.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using boidsimulation::World;
+
+/**
+ * Times World::Update with adaptive update intervals from 1 (every Boid every
+ * step) to 8, at 10k and 100k Boids spread from visualizer density to far
+ * apart. Prints steps/sec, the share of Boid updates that were dead reckoned
+ * and the speedup over updating every step.
+ */
+int main() {
+  const size_t kBoidCounts[] = {10000, 100000};
+  //Area per Boid is the square of these, 30 being the visualizer's density
+  const double kPixelsPerBoid[] = {30, 100, 300};
+  const size_t kIntervals[] = {1, 2, 4, 8};
+  const size_t kPredatorRatio = 1000;
+
+  std::cout << "boids,pixels_per_boid,interval,steps,steps_per_sec,dead_reckoned,speedup"
+            << std::endl;
+  for(size_t boid_num : kBoidCounts) {
+    //Fewer steps for large worlds so every configuration takes similar time
+    size_t steps = std::max<size_t>(20, 2000000 / boid_num);
+    for(double pixels_per_boid : kPixelsPerBoid) {
+      double side = pixels_per_boid * std::sqrt((double)boid_num);
+      double every_step_rate = 0;
+
+      for(size_t interval : kIntervals) {
+        World world(0, 0, side, side, boid_num, boid_num / kPredatorRatio);
+        world.SetDoubleBuffered(true);
+        world.SetAdaptiveInterval(interval);
+        //Warm up caches and grid buffers, and let the schedule settle
+        for(size_t step = 0; step < interval; ++step) {
+          world.Update();
+        }
+
+        size_t dead_reckoned = 0, updates = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(size_t step = 0; step < steps; ++step) {
+          updates += world.GetBoids().Size() + world.GetPredators().Size();
+          world.Update();
+          dead_reckoned += world.GetDeadReckonedCount();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        double rate = steps / elapsed.count();
+        if(interval == 1) {
+          every_step_rate = rate;
+        }
+        std::cout << boid_num << "," << pixels_per_boid << "," << interval << "," << steps
+                  << "," << rate << "," << (double)dead_reckoned / updates << ","
+                  << rate / every_step_rate << std::endl;
+      }
+    }
+  }
+  return 0;
+}
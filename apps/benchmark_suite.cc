@@ -0,0 +1,294 @@
+#include <core/neighbor_kernel.h>
+#include <core/spatial_grid.h>
+#include <core/world.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using boidsimulation::Boid;
+using boidsimulation::FlockState;
+using boidsimulation::MathVector;
+using boidsimulation::Obstacle;
+using boidsimulation::SpatialGrid;
+using boidsimulation::World;
+
+#ifndef BOIDSIMULATION_BUILD_TYPE
+#define BOIDSIMULATION_BUILD_TYPE "unknown"
+#endif
+
+namespace {
+
+/**
+ * The world a group of benchmarks runs in.
+ */
+struct Scenario {
+  size_t boids;
+  double predator_ratio;
+  size_t obstacles;
+};
+
+/**
+ * Options of a run, set from --name=value arguments.
+ */
+struct Options {
+  size_t max_boids = 1000000;
+  double min_seconds = 0.25;
+  size_t threads = 1;
+};
+
+/**
+ * Boids are as dense as in the visualizer at every size.
+ */
+const double kPixelsPerBoid = 30;
+
+/**
+ * Per Boid benchmarks call the measured function on at most this many Boids
+ * per iteration, spread evenly over the flock.
+ */
+const size_t kMaxSampledBoids = 2000;
+
+const char* kSimdLevelNames[] = {"scalar", "sse2", "avx2"};
+
+/**
+ * Writes one JSON result object per measured benchmark.
+ */
+class JsonWriter {
+ public:
+  JsonWriter() {
+    std::cout << "{" << std::endl;
+    std::cout << "  \"context\": {\"build_type\": \"" << BOIDSIMULATION_BUILD_TYPE
+              << "\", \"hardware_threads\": " << std::thread::hardware_concurrency()
+              << ", \"simd_level\": \""
+              << kSimdLevelNames[(int)boidsimulation::DetectSimdLevel()] << "\"}," << std::endl;
+    std::cout << "  \"benchmarks\": [";
+  }
+
+  ~JsonWriter() {
+    std::cout << std::endl << "  ]" << std::endl << "}" << std::endl;
+  }
+
+  /**
+   * @param bytes_per_boid Memory a benchmark streams per Boid. If not 0, it
+   * and the resulting MB/s are written too.
+   */
+  void Write(const std::string& name, const Scenario& scenario, size_t threads,
+             size_t iterations, double ns_per_iteration, size_t boids_per_iteration,
+             size_t bytes_per_boid = 0) {
+    double ns_per_boid = ns_per_iteration / boids_per_iteration;
+    std::cout << (first_ ? "" : ",") << std::endl
+              << "    {\"name\": \"" << name << "\", \"boids\": " << scenario.boids
+              << ", \"predator_ratio\": " << scenario.predator_ratio
+              << ", \"obstacles\": " << scenario.obstacles
+              << ", \"threads\": " << threads
+              << ", \"iterations\": " << iterations
+              << ", \"ns_per_iteration\": " << ns_per_iteration
+              << ", \"ns_per_boid\": " << ns_per_boid;
+    if(bytes_per_boid > 0) {
+      std::cout << ", \"bytes_per_boid\": " << bytes_per_boid
+                << ", \"mb_per_sec\": " << bytes_per_boid * 1e3 / ns_per_boid;
+    }
+    std::cout << "}";
+    first_ = false;
+  }
+
+ private:
+  bool first_ = true;
+};
+
+/**
+ * Calls run until at least min_seconds have passed and at least once.
+ * @return The mean time of one call in nanoseconds.
+ */
+double Measure(double min_seconds, size_t& iterations, const std::function<void()>& run) {
+  iterations = 0;
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed(0);
+  do {
+    run();
+    ++iterations;
+    elapsed = std::chrono::steady_clock::now() - start;
+  } while(elapsed.count() < min_seconds);
+  return elapsed.count() * 1e9 / iterations;
+}
+
+/**
+ * Creates the World for scenario with the same seed every time.
+ */
+std::unique_ptr<World> MakeWorld(const Scenario& scenario) {
+  srand(1);
+  double side = kPixelsPerBoid * std::sqrt((double)std::max<size_t>(scenario.boids, 100));
+  size_t predators = (size_t)(scenario.boids * scenario.predator_ratio);
+  std::unique_ptr<World> world(new World(0, 0, side, side, scenario.boids, predators));
+  while(world->GetObstacles().size() < scenario.obstacles) {
+    world->AddObstacle(MathVector(rand() % (int)side, rand() % (int)side, 0));
+  }
+  return world;
+}
+
+/**
+ * Times the Boid rules, obstacle avoidance and catch detection on a sample of
+ * the Boids of scenario, and one full World::Update.
+ */
+void RunScenario(const Scenario& scenario, const Options& options, JsonWriter& writer) {
+  std::cerr << "boids=" << scenario.boids << " predator_ratio=" << scenario.predator_ratio
+            << " obstacles=" << scenario.obstacles << std::endl;
+  std::unique_ptr<World> world = MakeWorld(scenario);
+
+  //Array of structures copies for the per Boid methods
+  std::vector<Boid> flock, preds;
+  for(size_t index = 0; index < world->GetBoids().Size(); ++index) {
+    flock.push_back(world->GetBoids().GetBoid(index));
+  }
+  for(size_t index = 0; index < world->GetPredators().Size(); ++index) {
+    preds.push_back(world->GetPredators().GetBoid(index));
+  }
+  std::vector<Obstacle> obstacles = world->GetObstacles();
+  SpatialGrid flock_grid, pred_grid, obstacle_grid;
+  flock_grid.Rebuild(flock);
+  pred_grid.Rebuild(preds);
+  obstacle_grid.Rebuild(obstacles);
+
+  size_t stride = std::max<size_t>(1, flock.size() / kMaxSampledBoids);
+  size_t sampled = (flock.size() + stride - 1) / stride;
+  //Summed so the calls cannot be optimized away
+  MathVector total;
+  size_t iterations = 0;
+
+  auto per_boid = [&](const std::string& name,
+                      const std::function<MathVector(Boid&)>& method) {
+    double ns = Measure(options.min_seconds, iterations, [&]() {
+      for(size_t index = 0; index < flock.size(); index += stride) {
+        total += method(flock[index]);
+      }
+    });
+    writer.Write(name, scenario, 1, iterations, ns, sampled);
+  };
+
+  per_boid("rule/separation", [&](Boid& boid) { return boid.Separation(flock, &flock_grid); });
+  per_boid("rule/alignment", [&](Boid& boid) { return boid.Alignment(flock, &flock_grid); });
+  per_boid("rule/cohesion", [&](Boid& boid) { return boid.Cohesion(flock, &flock_grid); });
+  per_boid("rule/chase", [&](Boid& boid) { return boid.Chase(preds, &pred_grid); });
+  per_boid("rule/flocking_behavior", [&](Boid& boid) {
+    return boid.FlockingBehavior(flock, preds, &flock_grid, &pred_grid);
+  });
+  per_boid("rule/avoid_obstacles", [&](Boid& boid) {
+    return boid.AvoidObstacles(obstacles, &obstacle_grid);
+  });
+  per_boid("boid/update", [&](Boid& boid) {
+    //Updates a copy so the flock and its grid stay as they were
+    Boid copy = boid;
+    copy.Update(flock, preds, obstacles, &flock_grid, &pred_grid, &obstacle_grid);
+    return copy.GetVelocity();
+  });
+
+  //One pass reading every Boid's position and velocity, as the neighbor loops
+  //do. A Boid object pulls its tunables and color through the cache with
+  //them; the FlockState arrays hold nothing else
+  const FlockState& state = world->GetBoids();
+  auto scan = [&](const std::string& name, size_t bytes_per_boid,
+                  const std::function<MathVector()>& pass) {
+    double ns = Measure(options.min_seconds, iterations, [&]() { total += pass(); });
+    writer.Write(name, scenario, 1, iterations, ns, std::max<size_t>(1, flock.size()),
+                 bytes_per_boid);
+  };
+  scan("layout/boid_scan", sizeof(Boid), [&]() {
+    MathVector sum;
+    for(const Boid& boid : flock) {
+      sum += boid.GetPosition() + boid.GetVelocity();
+    }
+    return sum;
+  });
+  scan("layout/flock_state_scan", 2 * sizeof(MathVector), [&]() {
+    MathVector sum;
+    for(size_t index = 0; index < state.Size(); ++index) {
+      sum += state.positions_[index] + state.velocities_[index];
+    }
+    return sum;
+  });
+
+  //Later iterations find nothing left to catch, so this mostly times the search
+  double ns = Measure(options.min_seconds, iterations, [&]() { world->CheckPredatorCatch(); });
+  writer.Write("world/check_predator_catch", scenario, 1, iterations, ns,
+               std::max<size_t>(1, scenario.boids));
+
+  world = MakeWorld(scenario);
+  world->SetThreadCount(options.threads);
+  ns = Measure(options.min_seconds, iterations, [&]() { world->Update(); });
+  writer.Write("world/update", scenario, world->GetThreadCount(), iterations, ns,
+               std::max<size_t>(1, scenario.boids));
+
+  if(total.Length() < 0) {
+    std::cerr << "unreachable" << std::endl;
+  }
+}
+
+void PrintUsage() {
+  std::cerr << "usage: boid-simulation-benchmark-suite [--max-boids=N] [--min-seconds=S]"
+            << " [--threads=N]" << std::endl;
+}
+
+/**
+ * Reads arguments into options.
+ * @return False if an argument is not recognized.
+ */
+bool ParseOptions(int argc, char** argv, Options& options) {
+  for(int arg = 1; arg < argc; ++arg) {
+    std::string option = argv[arg];
+    size_t equals = option.find('=');
+    std::string name = option.substr(0, equals);
+    const char* value = equals == std::string::npos ? "" : argv[arg] + equals + 1;
+
+    if(name == "--max-boids") {
+      options.max_boids = strtoul(value, nullptr, 10);
+    } else if(name == "--min-seconds") {
+      options.min_seconds = strtod(value, nullptr);
+    } else if(name == "--threads") {
+      options.threads = strtoul(value, nullptr, 10);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+/**
+ * Times the simulation step and its parts over boid counts from 1k to 1M, then
+ * over predator ratios and obstacle counts at 10k Boids. Prints the results as
+ * JSON on stdout and progress on stderr.
+ */
+int main(int argc, char** argv) {
+  Options options;
+  if(!ParseOptions(argc, argv, options)) {
+    PrintUsage();
+    return 1;
+  }
+
+  std::vector<Scenario> scenarios;
+  for(size_t boids : {1000, 10000, 100000, 1000000}) {
+    scenarios.push_back({boids, 0.001, 10});
+  }
+  for(double predator_ratio : {0.0, 0.01, 0.05}) {
+    scenarios.push_back({10000, predator_ratio, 10});
+  }
+  for(size_t obstacles : {0, 50, 200}) {
+    scenarios.push_back({10000, 0.001, obstacles});
+  }
+
+  JsonWriter writer;
+  for(auto& scenario : scenarios) {
+    if(scenario.boids <= options.max_boids) {
+      RunScenario(scenario, options, writer);
+    }
+  }
+  return 0;
+}
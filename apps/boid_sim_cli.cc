@@ -0,0 +1,173 @@
+#include <core/profiler.h>
+#include <core/trajectory_recorder.h>
+#include <core/world.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctype.h>
+#include <iostream>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+
+using boidsimulation::World;
+
+namespace {
+
+/**
+ * Options of a run, set from --name=value arguments.
+ */
+struct Options {
+  size_t boids = 10000;
+  size_t predators = 10;
+  size_t steps = 1000;
+  size_t threads = 1;
+  //Zero sizes the World so the Boids are as dense as in the visualizer
+  double width = 0;
+  double height = 0;
+  bool double_buffered = false;
+  //Same results for any thread count and CPU, see World::SetDeterministic
+  bool deterministic = false;
+  //Steps between full updates of quiet Boids, see World::SetAdaptiveInterval
+  size_t adaptive_interval = 1;
+  uint64_t seed = 1;
+  //Trajectory file written every step, none if empty
+  std::string record;
+  //Chrome trace of the run, none if empty
+  std::string profile;
+};
+
+void PrintUsage() {
+  std::cerr << "usage: boid-sim-cli [--boids=N] [--predators=N] [--steps=N] [--threads=N]"
+            << std::endl
+            << "                    [--width=X] [--height=Y] [--double-buffered] [--seed=N]"
+            << std::endl
+            << "                    [--deterministic]"
+            << std::endl
+            << "                    [--adaptive-interval=N] [--record=PATH] [--profile=PATH]"
+            << std::endl
+            << "threads=0 uses one thread per hardware core." << std::endl;
+}
+
+/**
+ * Reads arguments into options.
+ * @return False if an argument is not recognized.
+ */
+bool ParseOptions(int argc, char** argv, Options& options) {
+  for(int arg = 1; arg < argc; ++arg) {
+    std::string option = argv[arg];
+    size_t equals = option.find('=');
+    std::string name = option.substr(0, equals);
+    const char* value = equals == std::string::npos ? "" : argv[arg] + equals + 1;
+
+    if(name == "--boids") {
+      options.boids = strtoul(value, nullptr, 10);
+    } else if(name == "--predators") {
+      options.predators = strtoul(value, nullptr, 10);
+    } else if(name == "--steps") {
+      options.steps = strtoul(value, nullptr, 10);
+    } else if(name == "--threads") {
+      options.threads = strtoul(value, nullptr, 10);
+    } else if(name == "--width") {
+      options.width = strtod(value, nullptr);
+    } else if(name == "--height") {
+      options.height = strtod(value, nullptr);
+    } else if(name == "--double-buffered") {
+      options.double_buffered = true;
+    } else if(name == "--deterministic") {
+      options.deterministic = true;
+    } else if(name == "--adaptive-interval") {
+      options.adaptive_interval = strtoul(value, nullptr, 10);
+    } else if(name == "--seed") {
+      options.seed = strtoull(value, nullptr, 10);
+    } else if(name == "--record") {
+      options.record = value;
+    } else if(name == "--profile") {
+      options.profile = value;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+/**
+ * Steps a World without rendering as fast as possible and reports steps/sec.
+ */
+int main(int argc, char** argv) {
+  Options options;
+  if(!ParseOptions(argc, argv, options)) {
+    PrintUsage();
+    return 1;
+  }
+  const double kPixelsPerBoid = 30;
+  double side = kPixelsPerBoid * std::sqrt((double)std::max<size_t>(options.boids, 100));
+  double width = options.width > 0 ? options.width : side;
+  double height = options.height > 0 ? options.height : side;
+
+  //Spawned after the thread count is set so large flocks fill in parallel
+  World world(0, 0, width, height, 0, 0, boidsimulation::WorldParameters(), options.seed);
+  world.SetThreadCount(options.threads);
+  world.SetDoubleBuffered(options.double_buffered);
+  world.SetDeterministic(options.deterministic);
+  world.SetAdaptiveInterval(options.adaptive_interval);
+  world.InitializeBoids(options.boids, options.predators);
+
+  boidsimulation::TrajectoryRecorder recorder;
+  if(!options.record.empty() && !recorder.Open(options.record)) {
+    std::cerr << "cannot write " << options.record << std::endl;
+    return 1;
+  }
+
+  boidsimulation::Profiler& profiler = boidsimulation::Profiler::Get();
+  profiler.SetEnabled(!options.profile.empty());
+
+  auto start = std::chrono::steady_clock::now();
+  for(size_t step = 0; step < options.steps; ++step) {
+    world.Update();
+    if(recorder.IsOpen()) {
+      recorder.Record(world);
+    }
+    if(profiler.IsEnabled()) {
+      profiler.EndFrame();
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  if(!recorder.Close()) {
+    std::cerr << "cannot write " << options.record << std::endl;
+    return 1;
+  }
+
+  double rate = options.steps / elapsed.count();
+  std::cout << "boids=" << options.boids << " predators=" << options.predators
+            << " threads=" << world.GetThreadCount() << " steps=" << options.steps
+            << std::endl;
+  std::cout << "seconds=" << elapsed.count() << " steps_per_sec=" << rate
+            << " boid_updates_per_sec=" << rate * options.boids
+            << " prey_remaining=" << world.GetBoids().Size()
+            << " state_hash=" << world.GetStateHash() << std::endl;
+  if(!options.profile.empty()) {
+    //Averages over the last steps, keyed like the other output
+    for(const boidsimulation::ProfileSummary& entry : profiler.GetSummary()) {
+      std::string key = entry.name;
+      std::transform(key.begin(), key.end(), key.begin(), [](char c) {
+        return c == ' ' ? '_' : (char)tolower(c);
+      });
+      std::cout << key << (entry.timer ? "_ms=" : "=") << entry.per_frame << " ";
+    }
+    std::cout << std::endl;
+    if(!profiler.WriteChromeTrace(options.profile)) {
+      std::cerr << "cannot write " << options.profile << std::endl;
+      return 1;
+    }
+  }
+  if(!options.record.empty()) {
+    boidsimulation::RecorderStats stats = recorder.GetStats();
+    std::cout << "frames_written=" << stats.frames_written << " frames_dropped=" << stats.dropped
+              << " bytes_written=" << stats.bytes_written << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,99 @@
+#include <core/parameter_sweep.h>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+
+using boidsimulation::ParameterSweep;
+using boidsimulation::SweepSpec;
+
+namespace {
+
+/**
+ * Options of a sweep, set from --name=value arguments.
+ */
+struct Options {
+  //Sweep spec file, see SweepSpec::Parse
+  std::string spec;
+  //CSV file rows are appended to
+  std::string output;
+  size_t threads = 0;
+};
+
+void PrintUsage() {
+  std::cerr << "usage: boid-sweep --spec=PATH --output=PATH [--threads=N]" << std::endl
+            << "threads=0, the default, uses one thread per hardware core. Runs already"
+            << std::endl
+            << "in the output are skipped, so an interrupted sweep resumes when rerun."
+            << std::endl;
+}
+
+/**
+ * Reads arguments into options.
+ * @return False if an argument is not recognized or a path is missing.
+ */
+bool ParseOptions(int argc, char** argv, Options& options) {
+  for(int arg = 1; arg < argc; ++arg) {
+    std::string option = argv[arg];
+    size_t equals = option.find('=');
+    std::string name = option.substr(0, equals);
+    const char* value = equals == std::string::npos ? "" : argv[arg] + equals + 1;
+
+    if(name == "--spec") {
+      options.spec = value;
+    } else if(name == "--output") {
+      options.output = value;
+    } else if(name == "--threads") {
+      options.threads = strtoul(value, nullptr, 10);
+    } else {
+      return false;
+    }
+  }
+  return !options.spec.empty() && !options.output.empty();
+}
+
+}  // namespace
+
+/**
+ * Runs every configuration of a sweep spec headless and streams their metrics
+ * to a CSV file.
+ */
+int main(int argc, char** argv) {
+  Options options;
+  if(!ParseOptions(argc, argv, options)) {
+    PrintUsage();
+    return 1;
+  }
+
+  std::ifstream spec_file(options.spec);
+  if(!spec_file) {
+    std::cerr << "cannot read " << options.spec << std::endl;
+    return 1;
+  }
+  std::stringstream text;
+  text << spec_file.rdbuf();
+  SweepSpec spec;
+  std::string error;
+  if(!SweepSpec::Parse(text.str(), spec, error)) {
+    std::cerr << "invalid spec line: " << error << std::endl;
+    return 1;
+  }
+
+  ParameterSweep sweep(spec);
+  auto start = std::chrono::steady_clock::now();
+  if(!sweep.Run(options.output, options.threads)) {
+    std::cerr << "cannot write " << options.output
+              << ", or it holds the rows of another sweep" << std::endl;
+    return 1;
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::cout << "configs=" << spec.ConfigCount() << " skipped=" << sweep.GetSkippedCount()
+            << " run=" << sweep.GetRunCount() << " steps=" << spec.steps << std::endl;
+  std::cout << "seconds=" << elapsed.count()
+            << " runs_per_sec=" << sweep.GetRunCount() / elapsed.count() << std::endl;
+  return 0;
+}
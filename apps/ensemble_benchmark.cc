@@ -0,0 +1,63 @@
+#include <core/ensemble.h>
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using boidsimulation::Ensemble;
+using boidsimulation::EnsembleMember;
+
+/**
+ * Steps an Ensemble of 256 Worlds of 500 Boids, each with its own seed and
+ * separation, alignment, cohesion and chase values, for thread counts from 1
+ * up to the number of hardware cores. Prints World steps/sec, Boid updates/sec
+ * and the speedup over a single thread.
+ */
+int main() {
+  const size_t kWorlds = 256;
+  const size_t kBoidsPerWorld = 500;
+  const size_t kSteps = 20;
+  //The visualizer's density of one Boid per 30 x 30 pixels
+  const double kSide = 30 * 22.4;
+  const double kScales[] = {0.5, 1, 1.5, 2};
+  const double kChases[] = {5, 10, 20, 40};
+
+  std::vector<size_t> thread_counts;
+  size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  for(size_t threads = 1; threads < max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(max_threads);
+
+  std::cout << "worlds,boids_per_world,threads,steps,world_steps_per_sec,"
+            << "boid_updates_per_sec,speedup" << std::endl;
+  double single_thread_rate = 0;
+  for(size_t threads : thread_counts) {
+    Ensemble ensemble(kSide, kSide, threads);
+    for(size_t index = 0; index < kWorlds; ++index) {
+      EnsembleMember member;
+      member.seed = index + 1;
+      member.boid_num = kBoidsPerWorld;
+      member.parameters.separation = kScales[index % 4];
+      member.parameters.alignment = kScales[index / 4 % 4];
+      member.parameters.cohesion = kScales[index / 16 % 4];
+      member.parameters.chase = kChases[index / 64 % 4];
+      ensemble.AddWorld(member);
+    }
+    //Warm up caches and grid buffers
+    ensemble.Step();
+    ensemble.ResetStats();
+
+    ensemble.Step(kSteps);
+    const boidsimulation::EnsembleStats& stats = ensemble.GetStats();
+    double rate = stats.WorldStepsPerSecond();
+    if(threads == 1) {
+      single_thread_rate = rate;
+    }
+    std::cout << kWorlds << "," << kBoidsPerWorld << "," << ensemble.GetThreadCount() << ","
+              << kSteps << "," << rate << "," << stats.BoidUpdatesPerSecond() << ","
+              << rate / single_thread_rate << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,131 @@
+#include <core/flock_state.h>
+#include <core/spatial_grid.h>
+
+#include <chrono>
+#include <iostream>
+
+using boidsimulation::BasicBoid;
+using boidsimulation::BasicFlockState;
+using boidsimulation::BasicVector;
+using boidsimulation::SimdLevel;
+using boidsimulation::SpatialGrid;
+
+namespace {
+
+const size_t kBoidNum = 20000;
+const double kSide = 1500;
+const size_t kRepeats = 20;
+
+/**
+ * Times each supported kernel for one precision and dimension and prints a CSV
+ * row per kernel. Every instantiation sees the same flock.
+ * @return False if the results were unexpectedly empty.
+ */
+template <typename T, size_t N>
+bool BenchmarkKernels(const char* name) {
+  srand(1);
+  BasicFlockState<T, N> flock, preds;
+  for(size_t current = 0; current < kBoidNum; ++current) {
+    BasicVector<double, 3> position(rand() % (int)kSide, rand() % (int)kSide, 0);
+    BasicVector<double, 3> velocity(rand() % 16 - 8, rand() % 16 - 8, 0);
+    flock.Add(BasicBoid<T, N>(BasicVector<T, N>(position), BasicVector<T, N>(velocity),
+                              10, 50, 8));
+  }
+  SpatialGrid grid, pred_grid;
+  grid.Rebuild(flock);
+  pred_grid.Rebuild(preds);
+
+  const SimdLevel kLevels[] = {SimdLevel::kScalar, SimdLevel::kSse2, SimdLevel::kAvx2};
+  const char* kLevelNames[] = {"scalar", "sse2", "avx2"};
+
+  //Neighbor batches packed up front so the kernel can be timed on its own
+  std::vector<boidsimulation::NeighborBatch<T, N>> batches(flock.Size());
+  for(size_t index = 0; index < flock.Size(); ++index) {
+    grid.ForEachCandidate(flock.positions_[index], 50, [&](size_t boid_index) {
+      batches[index].Add(flock.positions_[boid_index], flock.velocities_[boid_index]);
+    });
+  }
+
+  //Speedups are over the scalar kernel packing candidates, the deterministic path
+  double scalar_kernel_time = 0, scalar_flocking_time = 0;
+  for(size_t level = 0; level < 3; ++level) {
+    if(!boidsimulation::IsSimdLevelSupported(kLevels[level])) {
+      continue;
+    }
+    flock.SetSimdLevel(kLevels[level]);
+    boidsimulation::NeighborKernel<T, N> kernel =
+        boidsimulation::GetNeighborKernel<T, N>(kLevels[level]);
+
+    //Summed so the calls cannot be optimized away
+    boidsimulation::NeighborSums<T, N> sums;
+    auto start = std::chrono::steady_clock::now();
+    for(size_t repeat = 0; repeat < kRepeats; ++repeat) {
+      for(size_t index = 0; index < flock.Size(); ++index) {
+        kernel(batches[index].Range(), flock.positions_[index], 625, 2500, sums);
+      }
+    }
+    std::chrono::duration<double, std::nano> kernel_elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    //Rebuilt so FlockingBehavior packs each Boid's candidates, as it does
+    //when positions change during the step
+    grid.Rebuild(flock);
+    BasicVector<T, N> total;
+    start = std::chrono::steady_clock::now();
+    for(size_t repeat = 0; repeat < kRepeats; ++repeat) {
+      for(size_t index = 0; index < flock.Size(); ++index) {
+        total += flock.FlockingBehavior(index, preds, grid, pred_grid);
+      }
+    }
+    std::chrono::duration<double, std::nano> flocking_elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    //Copied in cell order once per step, as double buffered Updates do, so
+    //the kernel reads candidates in place. The copy is part of the time
+    start = std::chrono::steady_clock::now();
+    for(size_t repeat = 0; repeat < kRepeats; ++repeat) {
+      flock.PackByCell(grid);
+      for(size_t index = 0; index < flock.Size(); ++index) {
+        total += flock.FlockingBehavior(index, preds, grid, pred_grid);
+      }
+    }
+    std::chrono::duration<double, std::nano> in_place_elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    double kernel_time = kernel_elapsed.count() / (kRepeats * flock.Size());
+    double flocking_time = flocking_elapsed.count() / (kRepeats * flock.Size());
+    double in_place_time = in_place_elapsed.count() / (kRepeats * flock.Size());
+    if(level == 0) {
+      scalar_kernel_time = kernel_time;
+      scalar_flocking_time = flocking_time;
+    }
+    std::cout << name << "," << kLevelNames[level] << "," << kernel_time << ","
+              << scalar_kernel_time / kernel_time << "," << flocking_time << ","
+              << scalar_flocking_time / flocking_time << "," << in_place_time << ","
+              << scalar_flocking_time / in_place_time << std::endl;
+    if(total.Length() < 0 || sums.count == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+/**
+ * Times each neighbor kernel the CPU supports over a dense flock, both on
+ * prepacked neighbor batches and inside FlockingBehavior, for 3D double and
+ * 2D float flocks. FlockingBehavior is timed packing each Boid's candidates
+ * and reading them in place from a copy in cell order; the scalar kernel
+ * always packs, so its two times match. Prints ns per Boid and speedup over
+ * the scalar kernel.
+ */
+int main() {
+  std::cout << "precision,kernel,kernel_ns_per_boid,kernel_speedup,"
+            << "flocking_ns_per_boid,flocking_speedup,in_place_ns_per_boid,in_place_speedup"
+            << std::endl;
+  if(!BenchmarkKernels<double, 3>("3d_double") || !BenchmarkKernels<float, 2>("2d_float")) {
+    return 1;
+  }
+  return 0;
+}
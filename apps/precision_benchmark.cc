@@ -0,0 +1,77 @@
+#include <core/world.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdint.h>
+#include <string>
+
+using boidsimulation::World;
+using boidsimulation::World2f;
+
+namespace {
+
+/**
+ * Times Update of a WorldType with boid_num Boids over steps steps.
+ * @return Steps per second.
+ */
+template <typename WorldType>
+double TimeWorld(size_t boid_num, double side, size_t steps) {
+  const size_t kPredatorRatio = 1000;
+  WorldType world(0, 0, side, side, boid_num, boid_num / kPredatorRatio);
+  world.SetDoubleBuffered(true);
+  //Warm up caches and grid buffers
+  world.Update();
+
+  auto start = std::chrono::steady_clock::now();
+  for(size_t step = 0; step < steps; ++step) {
+    world.Update();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return steps / elapsed.count();
+}
+
+/**
+ * @return Bytes of per Boid state a WorldType keeps: position, velocity and
+ * species index.
+ */
+template <typename WorldType>
+size_t StateBytes() {
+  return 2 * sizeof(typename WorldType::VectorType) + sizeof(uint8_t);
+}
+
+}  // namespace
+
+/**
+ * Times World (3D double) against World2f (2D float) at 10k, 100k and 1M
+ * Boids spread at the visualizer's density and sparser. Prints the per Boid
+ * state each keeps, steps/sec, the state bytes streamed per second and the
+ * speedup of single precision.
+ */
+int main() {
+  const size_t kBoidCounts[] = {10000, 100000, 1000000};
+  //Area per Boid is the square of these, 30 being the visualizer's density
+  const double kPixelsPerBoid[] = {30, 100};
+
+  std::cout << "boids,pixels_per_boid,precision,state_bytes_per_boid,steps,steps_per_sec,"
+            << "state_mb_per_sec,speedup" << std::endl;
+  for(size_t boid_num : kBoidCounts) {
+    //Fewer steps for large worlds so every configuration takes similar time
+    size_t steps = std::max<size_t>(5, 1000000 / boid_num);
+    for(double pixels_per_boid : kPixelsPerBoid) {
+      double side = pixels_per_boid * std::sqrt((double)boid_num);
+      double double_rate = TimeWorld<World>(boid_num, side, steps);
+      double float_rate = TimeWorld<World2f>(boid_num, side, steps);
+
+      auto print = [&](const std::string& precision, size_t bytes, double rate) {
+        std::cout << boid_num << "," << pixels_per_boid << "," << precision << "," << bytes
+                  << "," << steps << "," << rate << "," << bytes * boid_num * rate / 1e6
+                  << "," << rate / double_rate << std::endl;
+      };
+      print("double", StateBytes<World>(), double_rate);
+      print("float", StateBytes<World2f>(), float_rate);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,57 @@
+#include <core/world.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+using boidsimulation::World;
+
+/**
+ * Times World::Update at 10k, 100k and 1M Boids for thread counts from 1
+ * up to the number of hardware cores, and prints steps/sec and speedup over
+ * a single thread. Worlds keep the same Boid density at every size.
+ */
+int main() {
+  const size_t kBoidCounts[] = {10000, 100000, 1000000};
+  const double kPixelsPerBoid = 30;
+  const size_t kPredatorRatio = 1000;
+
+  std::vector<size_t> thread_counts;
+  size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  for(size_t threads = 1; threads < max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(max_threads);
+
+  std::cout << "boids,threads,steps,steps_per_sec,boid_updates_per_sec,speedup" << std::endl;
+  for(size_t boid_num : kBoidCounts) {
+    double side = kPixelsPerBoid * sqrt((double)boid_num);
+    //Fewer steps for large worlds so every configuration takes similar time
+    size_t steps = std::max<size_t>(3, 2000000 / boid_num);
+    double single_thread_rate = 0;
+
+    for(size_t threads : thread_counts) {
+      srand(1);
+      World world(0, 0, side, side, boid_num, boid_num / kPredatorRatio);
+      world.SetThreadCount(threads);
+      world.SetDoubleBuffered(true);
+      //Warm up caches and grid buffers
+      world.Update();
+
+      auto start = std::chrono::steady_clock::now();
+      for(size_t step = 0; step < steps; ++step) {
+        world.Update();
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+      double rate = steps / elapsed.count();
+      if(threads == 1) {
+        single_thread_rate = rate;
+      }
+      std::cout << boid_num << "," << threads << "," << steps << "," << rate << ","
+                << rate * boid_num << "," << rate / single_thread_rate << std::endl;
+    }
+  }
+  return 0;
+}
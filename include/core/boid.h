@@ -1,68 +1,98 @@
 #pragma once
 
+#include <core/color.h>
 #include <core/math_vector.h>
 #include <core/obstacle.h>
-#include "cinder/gl/gl.h"
 #include <vector>
 
 namespace boidsimulation {
 
-using boidsimulation::MathVector;
+class SpatialGrid;
 
-class Boid {
+/**
+ * A flocking creature. Templated on the scalar type and number of dimensions
+ * of its vectors, with Boid (3D double) and Boid2f (2D float) instantiated.
+ */
+template <typename T, size_t N>
+class BasicBoid {
  public:
-  Boid() = default;
+  typedef BasicVector<T, N> VectorType;
+
+  BasicBoid() = default;
 
   /**
    * Constructor that takes in optional position, velocity, and acceleration parameters.
-   * @param position The MathVector value of position.
-   * @param velocity The MathVector value of velocity.
-   * @param mass The double value of mass.
+   * @param position The value of position.
+   * @param velocity The value of velocity.
+   * @param mass The value of mass.
    */
-  Boid(const MathVector& position, const MathVector& velocity,
-       double size = 10, double vision = 50, double max_speed = 8, bool is_pred = false,
-       ci::Color8u color = ci::Color8u(255,255,255)) :
-        position_(position), velocity_(velocity),
-        size_(size), vision_(vision), max_speed_(max_speed),
-        predator_(is_pred), color_(color) {};
+  BasicBoid(const VectorType& position, const VectorType& velocity,
+       T size = 10, T vision = 50, T max_speed = 8, bool is_pred = false,
+       Color color = Color(255,255,255)) :
+        position_(position), velocity_(velocity), size_(size), color_(color),
+        max_speed_(max_speed), vision_(vision), predator_(is_pred) {}
 
   /**
    * Adds current velocity to the current position.
+   * The optional grids index flock, preds and obstacles. Without them every
+   * Boid and Obstacle is scanned.
    */
-  void Update(std::vector<Boid>& flock, std::vector<Boid>& preds,
-              std::vector<Obstacle>& obstacles);
+  void Update(std::vector<BasicBoid>& flock, std::vector<BasicBoid>& preds,
+              std::vector<Obstacle>& obstacles,
+              const SpatialGrid* flock_grid = nullptr,
+              const SpatialGrid* pred_grid = nullptr,
+              const SpatialGrid* obstacle_grid = nullptr);
 
   /**
    * Returns velocity change vector based on the 3 rules of flocking behavior.
+   * Visits each nearby Boid once, accumulating Separation, Alignment, Cohesion
+   * and Chase together using squared distances.
    */
-  MathVector FlockingBehavior(std::vector<Boid>& flock, std::vector<Boid>& preds);
+  VectorType FlockingBehavior(std::vector<BasicBoid>& flock, std::vector<BasicBoid>& preds,
+                              const SpatialGrid* flock_grid = nullptr,
+                              const SpatialGrid* pred_grid = nullptr);
 
   /**
-   * @return A MathVector representing the force applied due to Separation.
+   * Reference version of FlockingBehavior that calls each rule separately.
+   * Slower, but kept to check FlockingBehavior against.
+   */
+  VectorType FlockingBehaviorReference(std::vector<BasicBoid>& flock, std::vector<BasicBoid>& preds,
+                                       const SpatialGrid* flock_grid = nullptr,
+                                       const SpatialGrid* pred_grid = nullptr);
+
+  /**
+   * @return A vector representing the force applied due to Separation.
    * i.e. moving away from local flockmates to not crowd them.
+   * @param grid Optional SpatialGrid of flock used to find nearby Boids.
    */
-  MathVector Separation(std::vector<Boid>& flock);
+  VectorType Separation(std::vector<BasicBoid>& flock, const SpatialGrid* grid = nullptr);
   /**
-   * @return A MathVector representing the force applied due to Alignment.
+   * @return A vector representing the force applied due to Alignment.
    * i.e. facing the average direction of the flock.
+   * @param grid Optional SpatialGrid of flock used to find nearby Boids.
    */
-  MathVector Alignment(std::vector<Boid>& flock);
+  VectorType Alignment(std::vector<BasicBoid>& flock, const SpatialGrid* grid = nullptr);
   /**
-   * @return A MathVector representing the force applied due to Cohesion.
+   * @return A vector representing the force applied due to Cohesion.
    * i.e. moving towards the center of the flock.
+   * @param grid Optional SpatialGrid of flock used to find nearby Boids.
    */
-  MathVector Cohesion(std::vector<Boid>& flock);
+  VectorType Cohesion(std::vector<BasicBoid>& flock, const SpatialGrid* grid = nullptr);
   /**
-   * @return A MathVector representing the force applied to a Predator Boid in
+   * @return A vector representing the force applied to a Predator Boid in
    * order to chase prey or prey boid to run away from Predators.
+   * @param grid Optional SpatialGrid of flock used to find nearby Boids.
    */
-  MathVector Chase(std::vector<Boid>& flock);
+  VectorType Chase(std::vector<BasicBoid>& flock, const SpatialGrid* grid = nullptr);
 
   /**
-   * Returns a MathVector indicating acceleration away from Obstacles in obstacle.
+   * Returns a vector indicating acceleration away from Obstacles in obstacle.
    * @param obstacles Obstacles to steer away from.
+   * @param grid Optional SpatialGrid of obstacles used to find the Obstacles
+   * near the Boid's line of motion.
    */
-  MathVector AvoidObstacles(std::vector<Obstacle>& obstacles);
+  VectorType AvoidObstacles(std::vector<Obstacle>& obstacles,
+                            const SpatialGrid* grid = nullptr);
 
   /**
    * Negates Particle's velocity in x,y, or z axis.
@@ -70,56 +100,69 @@ class Boid {
    */
   void WallCollide(int axis = 0);
 
+  //Getters & Setters
+  const VectorType& GetPosition() const;
+  const VectorType& GetVelocity() const;
+  void SetVelocity(const VectorType& velocity);
   /**
-   * Draws the Boid
+   * Sets the velocity components. z is ignored by 2D Boids.
    */
-  void Draw() const;
+  void SetVelocity(T x, T y, T z = 0);
 
-  //Getters & Setters
-  const boidsimulation::MathVector& GetPosition() const;
-  const boidsimulation::MathVector& GetVelocity() const;
-  void SetVelocity(MathVector& velocity);
-  void SetVelocity(double x, double y, double z);
-
-  double GetSize() const;
-  void SetSize(double size);
-  const ci::Color8u& GetColor() const;
+  T GetSize() const;
+  void SetSize(T size);
+  T GetVision() const;
+  const Color& GetColor() const;
   const bool IsPredator() const;
 
-  double GetSeparationScale() const;
-  double GetAlignmentScale() const;
-  double GetCohesionScale() const;
-  double GetChaseScale() const;
-  void SetSeparationScale(double separation_scale);
-  void SetAlignmentScale(double alignment_scale);
-  void SetCohesionScale(double cohesion_scale);
-  void SetChaseScale(double chase_scale);
+  T GetSeparationScale() const;
+  T GetAlignmentScale() const;
+  T GetCohesionScale() const;
+  T GetChaseScale() const;
+  void SetSeparationScale(T separation_scale);
+  void SetAlignmentScale(T alignment_scale);
+  void SetCohesionScale(T cohesion_scale);
+  void SetChaseScale(T chase_scale);
+  T GetObstacleScale() const;
+  void SetObstacleScale(T obstacle_scale);
 
-  double GetMaxSpeed() const;
-  void SetMaxSpeed(double max_speed);
+  T GetMaxSpeed() const;
+  void SetMaxSpeed(T max_speed);
 
  private:
   /**
    * Returns true if Boid is heading into Obstacle. Helper method for
    * AvoidObstacles.
    */
-  bool HeadingTowards(MathVector& ray, MathVector& ray_small, Obstacle& obstacle);
+  bool HeadingTowards(VectorType& ray, VectorType& ray_small, Obstacle& obstacle);
 
-  boidsimulation::MathVector position_;
-  boidsimulation::MathVector velocity_;
-  double size_;
-  ci::Color8u color_;
+  /**
+   * Returns the offset from position_ to the closest Boid in flock that is
+   * visible and of the opposite type, or a zero vector if there is none.
+   * Helper method for FlockingBehavior.
+   */
+  VectorType ClosestOpponentOffset(const std::vector<BasicBoid>& flock, const SpatialGrid* grid) const;
 
-  double max_speed_;
-  double vision_;
+  VectorType position_;
+  VectorType velocity_;
+  T size_;
+  Color color_;
+
+  T max_speed_;
+  T vision_;
 
   bool predator_ = false;
 
-  double separation_scale_ = 1;
-  double alignment_scale_ = 1;
-  double cohesion_scale_ = 1;
-  double chase_scale_ = 20; //affects predator and prey movement
-  double obstacle_scale_ = 25;
+  T separation_scale_ = 1;
+  T alignment_scale_ = 1;
+  T cohesion_scale_ = 1;
+  T chase_scale_ = 20; //affects predator and prey movement
+  T obstacle_scale_ = 25;
 };
 
+//3D double precision Boid used by the simulation
+using Boid = BasicBoid<double, 3>;
+//2D single precision Boid for the fast path
+using Boid2f = BasicBoid<float, 2>;
+
 }  // namespace idealgas
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace boidsimulation {
+
+/**
+ * An 8 bit per channel RGB color. Kept free of any graphics library so the
+ * simulation core can be built without one; the visualizer converts it when
+ * drawing.
+ */
+struct Color {
+  constexpr Color(uint8_t r = 255, uint8_t g = 255, uint8_t b = 255) :
+        r_(r), g_(g), b_(b) {}
+
+  constexpr bool operator==(const Color& other) const {
+    return r_ == other.r_ && g_ == other.g_ && b_ == other.b_;
+  }
+  constexpr bool operator!=(const Color& other) const {
+    return !(*this == other);
+  }
+
+  uint8_t r_;
+  uint8_t g_;
+  uint8_t b_;
+};
+
+}  // namespace boidsimulation
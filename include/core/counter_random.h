@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace boidsimulation {
+
+/**
+ * Counter based random numbers. Every draw is a hash of the seed and a counter
+ * rather than the next step of a shared state, so any thread can make draw
+ * number n without making the draws before it, and the same seed always gives
+ * the same values however the draws are split between threads.
+ */
+class CounterRandom {
+ public:
+  explicit CounterRandom(uint64_t seed = 1) : seed_(seed) {}
+
+  /**
+   * @return 64 random bits for draw number counter.
+   */
+  uint64_t Bits(uint64_t counter) const {
+    //SplitMix64 finalizer over a seed dependent Weyl sequence
+    uint64_t z = Mix(seed_) + (counter + 1) * 0x9E3779B97F4A7C15ull;
+    return Mix(z);
+  }
+
+  /**
+   * @return A double from [0, 1) for draw number counter.
+   */
+  double Uniform(uint64_t counter) const {
+    return (Bits(counter) >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  /**
+   * @return A double from [min, max) for draw number counter.
+   */
+  double Uniform(uint64_t counter, double min, double max) const {
+    return min + (max - min) * Uniform(counter);
+  }
+
+  uint64_t GetSeed() const {
+    return seed_;
+  }
+
+ private:
+  static uint64_t Mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+
+  uint64_t seed_;
+};
+
+}  // namespace boidsimulation
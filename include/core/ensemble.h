@@ -0,0 +1,99 @@
+#pragma once
+
+#include <core/thread_pool.h>
+#include <core/world.h>
+
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+namespace boidsimulation {
+
+/**
+ * Settings of one World of an Ensemble.
+ */
+struct EnsembleMember {
+  WorldParameters parameters;
+  uint64_t seed = 1;
+  size_t boid_num = 500;
+  size_t pred_num = 2;
+};
+
+/**
+ * Steps counted by an Ensemble since it was created or its stats were reset.
+ */
+struct EnsembleStats {
+  //Updates of single Worlds
+  uint64_t world_steps = 0;
+  //Boid and Predator updates summed over every World
+  uint64_t boid_updates = 0;
+  //Wall clock time spent in Step
+  double seconds = 0;
+
+  double WorldStepsPerSecond() const {
+    return seconds > 0 ? world_steps / seconds : 0;
+  }
+  double BoidUpdatesPerSecond() const {
+    return seconds > 0 ? boid_updates / seconds : 0;
+  }
+};
+
+/**
+ * Many independent Worlds of the same size stepped concurrently, for parameter
+ * studies whose Worlds are each too small to keep several cores busy. Every
+ * World updates on one thread at a time; the Ensemble's thread pool hands out
+ * whole Worlds instead of chunks of Boids.
+ *
+ * Worlds share the per thread scratch of whichever thread steps them, such as
+ * the grid sort buffers and neighbor batches, and a single threaded Update
+ * allocates nothing once its arrays have grown, so Worlds on different cores
+ * do not contend in the heap.
+ */
+class Ensemble {
+ public:
+  /**
+   * Creates an Ensemble with no Worlds.
+   * @param width The x length of every World.
+   * @param height The y length of every World.
+   * @param thread_count Number of threads stepping Worlds. 1 steps them on the
+   * calling thread only, 0 uses one thread per hardware core.
+   */
+  Ensemble(double width, double height, size_t thread_count = 0);
+
+  /**
+   * Adds a World spawned from member's seed with member's parameters.
+   * @return The index of the World.
+   */
+  size_t AddWorld(const EnsembleMember& member);
+
+  /**
+   * Updates every World steps times, spread across the thread pool. Each
+   * thread takes one World at a time and steps it steps times before taking
+   * the next, so a World stays in one core's cache while it runs.
+   */
+  void Step(size_t steps = 1);
+
+  size_t Size() const;
+  World& GetWorld(size_t index);
+  const World& GetWorld(size_t index) const;
+
+  /**
+   * @return Throughput of every Step since the Ensemble was created or
+   * ResetStats was called.
+   */
+  const EnsembleStats& GetStats() const;
+  void ResetStats();
+
+  size_t GetThreadCount() const;
+
+ private:
+  double width_;
+  double height_;
+  std::vector<std::unique_ptr<World>> worlds_;
+
+  //Null when stepping on the calling thread only
+  std::unique_ptr<ThreadPool> thread_pool_;
+  EnsembleStats stats_;
+};
+
+}  // namespace boidsimulation
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <core/flock_state.h>
+#include <core/math_vector.h>
+#include <core/obstacle.h>
+#include <vector>
+
+namespace boidsimulation {
+
+/**
+ * CPU side vertex data for drawing Boids and Obstacles in one batched draw
+ * call. Every Boid becomes one triangle pointing along its velocity and every
+ * Obstacle a fan of triangles. The buffers keep their size between frames, so
+ * rebuilding allocates nothing once they have grown to fit the largest frame.
+ * Only vertices [0, GetVertexCount()) belong to the current frame.
+ */
+class FlockGeometry {
+ public:
+  //Red, green and blue from 0 to 1
+  typedef BasicVector<float, 3> VertexColor;
+
+  //Number of triangles each Obstacle circle is made of
+  static const size_t kCircleSegments = 24;
+
+  FlockGeometry() = default;
+
+  /**
+   * Starts a new frame. Keeps the buffers for reuse.
+   */
+  void Clear();
+
+  /**
+   * Appends one triangle per Boid of flock, 1.5 sizes long in front of the
+   * Boid and 1.5 sizes wide behind it.
+   */
+  void AddFlock(const FlockState& flock);
+
+  /**
+   * Appends a solid circle of kCircleSegments triangles per Obstacle.
+   */
+  void AddObstacles(const std::vector<Obstacle>& obstacles);
+
+  size_t GetVertexCount() const;
+  size_t GetTriangleCount() const;
+
+  /**
+   * @return Three positions per triangle. May be longer than GetVertexCount.
+   */
+  const std::vector<Vector2f>& GetPositions() const;
+
+  /**
+   * @return One color per position. May be longer than GetVertexCount.
+   */
+  const std::vector<VertexColor>& GetColors() const;
+
+ private:
+  /**
+   * Makes room for vertices more vertices, growing the buffers if needed.
+   * @return The index of the first new vertex.
+   */
+  size_t Reserve(size_t vertices);
+
+  std::vector<Vector2f> positions_;
+  std::vector<VertexColor> colors_;
+  size_t vertex_count_ = 0;
+};
+
+}  // namespace boidsimulation
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <core/boid.h>
+#include <core/color.h>
+#include <core/math_vector.h>
+#include <core/neighbor_kernel.h>
+#include <core/obstacle.h>
+#include <core/species.h>
+#include <stdint.h>
+#include <vector>
+
+namespace boidsimulation {
+
+class SpatialGrid;
+
+/**
+ * Structure-of-arrays storage for a flock. Each Boid is an index into
+ * contiguous arrays of state, so the neighbor loops only pull in the
+ * positions and velocities they read. Tunables such as size and max speed live
+ * in a shared species table, and each Boid only stores its species' index.
+ * Templated like BasicBoid, with FlockState (3D double) and FlockState2f
+ * (2D float) instantiated.
+ */
+template <typename T, size_t N>
+class BasicFlockState {
+ public:
+  typedef BasicVector<T, N> VectorType;
+  typedef BasicBoid<T, N> BoidType;
+  typedef BasicSpecies<T> SpeciesType;
+
+  //Species a FlockState can hold, bounded by the one byte index of each Boid
+  static const size_t kMaxSpecies = 256;
+
+  BasicFlockState() = default;
+
+  /**
+   * Appends a copy of boid's state to the flock. Its tunables join the species
+   * with the same values, which is added if there is none.
+   * @return False, adding nothing, if boid needs a new species and kMaxSpecies
+   * already exist.
+   */
+  bool Add(const BoidType& boid);
+  /**
+   * Appends count copies of boid's state to the flock, growing each array once.
+   * @return False, adding nothing, if boid needs a new species and kMaxSpecies
+   * already exist.
+   */
+  bool Add(const BoidType& boid, size_t count);
+  /**
+   * Appends count Boids of species at position with velocity, growing each
+   * array once.
+   * @param species An index into species_table_.
+   */
+  void Add(const VectorType& position, const VectorType& velocity, uint8_t species,
+           size_t count = 1);
+
+  /**
+   * Finds the species equal to species, adding it if there is none.
+   * @param index Set to the species' index into species_table_.
+   * @return False if there is no equal species and kMaxSpecies already exist.
+   */
+  bool AddSpecies(const SpeciesType& species, uint8_t& index);
+
+  /**
+   * Sets the tunables of every Boid of species index, adding default species
+   * up to index if needed.
+   */
+  void SetSpecies(uint8_t index, const SpeciesType& species);
+
+  /**
+   * @return The species of the Boid at index.
+   */
+  const SpeciesType& SpeciesOf(size_t index) const {
+    return species_table_[species_[index]];
+  }
+
+  /**
+   * @return A Boid holding a copy of the state and tunables at index.
+   */
+  BoidType GetBoid(size_t index) const;
+
+  /**
+   * Removes every Boid whose entry in marked is true, keeping the order of the rest.
+   * @param marked One entry per Boid in the flock.
+   */
+  void RemoveMarked(const std::vector<char>& marked);
+
+  /**
+   * Sets the instruction set FlockingBehavior accumulates neighbors with.
+   * Defaults to the best one the CPU supports.
+   * @param level A SimdLevel supported by the CPU.
+   */
+  void SetSimdLevel(SimdLevel level);
+  SimdLevel GetSimdLevel() const;
+
+  /**
+   * Copies every position and velocity into one array per component in the
+   * cell order of grid, so FlockingBehavior's SIMD kernels read each row of
+   * candidate cells in place instead of packing candidates one at a time.
+   * The copy is used until grid is rebuilt or Boids are added or removed, and
+   * positions_ and velocities_ must not change meanwhile. Does nothing for the
+   * scalar kernel, which reads neighbors in index order.
+   * @param grid SpatialGrid of this FlockState, rebuilt from its current positions.
+   */
+  void PackByCell(const SpatialGrid& grid);
+
+  void Reserve(size_t capacity);
+  /**
+   * Removes every Boid, keeping the species table.
+   */
+  void Clear();
+  size_t Size() const;
+  bool Empty() const;
+
+  /**
+   * Returns velocity change vector for the Boid at index based on the flocking
+   * rules. Flockmates are read from this FlockState and Boids of the other
+   * type from opponents.
+   * @param grid SpatialGrid of this FlockState.
+   * @param opponent_grid SpatialGrid of opponents.
+   */
+  VectorType FlockingBehavior(size_t index, const BasicFlockState& opponents,
+                              const SpatialGrid& grid,
+                              const SpatialGrid& opponent_grid) const;
+
+  /**
+   * Returns a VectorType indicating acceleration of the Boid at index away from
+   * obstacles when moving with velocity.
+   * @param obstacle_grid SpatialGrid of obstacles.
+   */
+  VectorType AvoidObstacles(size_t index, const VectorType& velocity,
+                            const std::vector<Obstacle>& obstacles,
+                            const SpatialGrid& obstacle_grid) const;
+
+  /**
+   * Moves the Boid at index one step and writes its new position and velocity
+   * into next_position and next_velocity. These may refer to the Boid's own
+   * entries to update it in place.
+   */
+  void UpdateBoid(size_t index, const BasicFlockState& opponents,
+                  const std::vector<Obstacle>& obstacles, const SpatialGrid& obstacle_grid,
+                  const SpatialGrid& grid, const SpatialGrid& opponent_grid,
+                  VectorType& next_position, VectorType& next_velocity) const;
+
+  std::vector<VectorType> positions_;
+  std::vector<VectorType> velocities_;
+  //Index into species_table_ of each Boid
+  std::vector<uint8_t> species_;
+
+  std::vector<SpeciesType> species_table_;
+
+ private:
+  /**
+   * Returns the offset from the Boid at index to the closest visible Boid of
+   * the other type in flock, or a zero vector if there is none.
+   */
+  VectorType ClosestOpponentOffset(size_t index, const BasicFlockState& flock,
+                                   const SpatialGrid& grid) const;
+
+  SimdLevel simd_level_ = DetectSimdLevel();
+  NeighborKernel<T, N> neighbor_kernel_ = GetNeighborKernel<T, N>(DetectSimdLevel());
+
+  //Positions and velocities in the cell order of the grid with build id
+  //packed_build_id_, or 0 if there is no current copy
+  NeighborBatch<T, N> cell_neighbors_;
+  uint64_t packed_build_id_ = 0;
+};
+
+//3D double precision flock used by the simulation
+using FlockState = BasicFlockState<double, 3>;
+//2D single precision flock for the fast path
+using FlockState2f = BasicFlockState<float, 2>;
+
+}  // namespace boidsimulation
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace boidsimulation {
+
+/**
+ * A file mapped into memory with mmap, unmapped when closed or destroyed.
+ * Reads and writes go straight to the page cache, so large files are copied
+ * once and only the pages touched are loaded. Only supported on POSIX
+ * systems; elsewhere opening always fails.
+ */
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   * Maps the existing file at path read only.
+   * @return False if the file cannot be opened or is empty.
+   */
+  bool OpenRead(const std::string& path);
+
+  /**
+   * Creates or truncates the file at path to size bytes and maps it for writing.
+   * @return False if the file cannot be created or sized.
+   */
+  bool Create(const std::string& path, size_t size);
+
+  /**
+   * Unmaps the file. Written pages reach the file when it is closed.
+   */
+  void Close();
+
+  bool IsOpen() const;
+  const uint8_t* GetData() const;
+  uint8_t* GetData();
+  size_t GetSize() const;
+
+ private:
+  /**
+   * Maps size bytes of the open descriptor fd_. Helper for OpenRead and Create.
+   */
+  bool Map(size_t size, bool writable);
+
+  int fd_ = -1;
+  uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace boidsimulation
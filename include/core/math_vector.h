@@ -1,158 +1,315 @@
 #ifndef MATH_VECTOR_H
 #define MATH_VECTOR_H
 
-#include <math.h>
+#include <cmath>
+#include <stddef.h>
+#include <stdexcept>
+#include <type_traits>
 
 namespace boidsimulation {
 
-class MathVector {
- public:
-  double x_ = 0, y_ = 0, z_ = 0;
+/**
+ * Named components of a BasicVector. Specialized for 2 and 3 dimensions so
+ * 2D vectors carry no z_ component at all.
+ */
+template <typename T, size_t N>
+struct VectorComponents;
 
-  MathVector() = default;
-  MathVector(double x, double y, double z) : x_(x), y_(y), z_(z) {};
+template <typename T>
+struct VectorComponents<T, 2> {
+  T x_ = 0, y_ = 0;
 
-  void Set(const MathVector& other);
-  void Zero();
+  constexpr T& Component(size_t index) {
+    return index == 0 ? x_ : y_;
+  }
+  constexpr T Component(size_t index) const {
+    return index == 0 ? x_ : y_;
+  }
+};
+
+template <typename T>
+struct VectorComponents<T, 3> {
+  T x_ = 0, y_ = 0, z_ = 0;
+
+  constexpr T& Component(size_t index) {
+    return index == 0 ? x_ : (index == 1 ? y_ : z_);
+  }
+  constexpr T Component(size_t index) const {
+    return index == 0 ? x_ : (index == 1 ? y_ : z_);
+  }
+};
+
+/**
+ * An N dimensional vector of T. Trivially copyable and header-only so copies
+ * are plain memory copies and every operator can be inlined into the hot loops.
+ * Everything except the sqrt based methods can be used in constant expressions.
+ */
+template <typename T, size_t N>
+class BasicVector : public VectorComponents<T, N> {
+ public:
+  typedef T Scalar;
+  static constexpr size_t kDimensions = N;
+
+  constexpr BasicVector() = default;
+  template <size_t M = N, typename std::enable_if<M == 2, int>::type = 0>
+  constexpr BasicVector(T x, T y) : VectorComponents<T, N>{x, y} {}
+  template <size_t M = N, typename std::enable_if<M == 3, int>::type = 0>
+  constexpr BasicVector(T x, T y, T z) : VectorComponents<T, N>{x, y, z} {}
 
-  //Rule of 5
-  /**
-   * Copy assignment operator. Performs a deep copy.
-   */
-  MathVector &operator=(const MathVector& other);
-  /**
-   * Copy constructor. Performs a deep copy.
-   */
-  MathVector(const MathVector& other);
-  /**
-   * Move assignment operator.
-   */
-  MathVector& operator=(MathVector&& other);
-  /**
-   * Move constructor.
-   */
-  MathVector(MathVector&& other) noexcept;
   /**
-   * Destructor.
+   * Converts a vector of another precision or dimension. Shared components are
+   * copied and any extra components are zero.
    */
-  ~MathVector();
+  template <typename U, size_t M>
+  constexpr explicit BasicVector(const BasicVector<U, M>& other) : BasicVector() {
+    for(size_t index = 0; index < N && index < M; ++index) {
+      this->Component(index) = static_cast<T>(other.Component(index));
+    }
+  }
+
+  constexpr void Set(const BasicVector& other) {
+    *this = other;
+  }
+  constexpr void Zero() {
+    *this = BasicVector();
+  }
 
   //Vector magnitude related methods
   /**
    * @return The magnitude of the vector
    */
-  double Length() const;
+  T Length() const {
+    return std::sqrt(LengthSquared());
+  }
+  /**
+   * @return The squared magnitude of the vector. Cheaper than Length when
+   * only comparing magnitudes.
+   */
+  constexpr T LengthSquared() const {
+    return *this * *this;
+  }
   /**
    * Normalizes the vector. Divides each component by the magnitude.
    */
-  void Normalize();
+  void Normalize() {
+    T magnitude = Length();
+    for(size_t index = 0; index < N; ++index) {
+      this->Component(index) /= magnitude;
+    }
+  }
   /**
    * Changes the magnitude of the vector to the provided value while keeping the
    * direction the same.
    * @param magnitude The new magnitude of the vector.
    */
-  void ChangeMagnitude(double magnitude);
+  void ChangeMagnitude(T magnitude) {
+    Normalize();
+    *this *= magnitude;
+  }
   /**
    * Copies the magnitude of the provided vector while keeping the direction the
    * same.
    * @param other_vector The vector to copy the magnitude from.
    */
-  void ChangeMagnitude(const MathVector& other_vector);
+  void ChangeMagnitude(const BasicVector& other_vector) {
+    ChangeMagnitude(other_vector.Length());
+  }
   /**
    * Copies the direction of the provided vector while keeping the magnitude the
    * same.
    * @param other_vector The vector to copy the direction from.
    */
-  void ChangeDirection(const MathVector& other_vector);
+  void ChangeDirection(const BasicVector& other_vector) {
+    T magnitude = Length();
+    *this = other_vector;
+    ChangeMagnitude(magnitude);
+  }
 
   /**
    * Calculates the length of the vector minus the other vector.
    * @param other_vector The vector to calculate distance to.
    */
-  double Distance(const MathVector& other_vector);
+  T Distance(const BasicVector& other_vector) const {
+    return std::sqrt(DistanceSquared(other_vector));
+  }
+  /**
+   * Calculates the squared length of the vector minus the other vector.
+   * Cheaper than Distance when only comparing distances.
+   * @param other_vector The vector to calculate distance to.
+   */
+  constexpr T DistanceSquared(const BasicVector& other_vector) const {
+    return (*this - other_vector).LengthSquared();
+  }
 
   /**
    * Returns the angle between the vector and the other_vector in radians.
    * @param other_vector The vector to calculate the angle to.
    */
-  double Angle(const MathVector& other_vector);
+  T Angle(const BasicVector& other_vector) const {
+    T dot_product = *this * other_vector;
+    return std::acos(dot_product / (Length() * other_vector.Length()));
+  }
 
   //Operator Overloads
   /**
    * @return Vector component corresponding to the provided index.
-   * Vector is 0-indexed.
+   * Vector is 0-indexed. Throws std::out_of_range for other indices.
    */
-  double &operator[](size_t index);
+  constexpr T& operator[](size_t index) {
+    if(index >= N) {
+      throw std::out_of_range("Index out of bounds");
+    }
+    return this->Component(index);
+  }
+  constexpr T operator[](size_t index) const {
+    if(index >= N) {
+      throw std::out_of_range("Index out of bounds");
+    }
+    return this->Component(index);
+  }
   //Equality operator
-  bool operator==(const MathVector& other);
+  constexpr bool operator==(const BasicVector& other) const {
+    for(size_t index = 0; index < N; ++index) {
+      if(this->Component(index) != other.Component(index)) {
+        return false;
+      }
+    }
+    return true;
+  }
   //Inequality operator
-  bool operator!=(const MathVector& other);
+  constexpr bool operator!=(const BasicVector& other) const {
+    return !(*this == other);
+  }
 
   //Addition and Subtraction
   /**
    * Vector addition and assignment.
-   * Adds components of other to the current MathVector.
-   * @param other MathVector to add to the current MathVector.
+   * Adds components of other to the current vector.
+   * @param other Vector to add to the current vector.
    */
-  MathVector& operator+=(const MathVector& other);
+  constexpr BasicVector& operator+=(const BasicVector& other) {
+    for(size_t index = 0; index < N; ++index) {
+      this->Component(index) += other.Component(index);
+    }
+    return *this;
+  }
   /**
    * Vector subtraction and assignment.
-   * Subtracts components of other from the current MathVector.
-   * @param other MathVector to subtract from the current MathVector.
+   * Subtracts components of other from the current vector.
+   * @param other Vector to subtract from the current vector.
    */
-  MathVector& operator-=(const MathVector& other);
+  constexpr BasicVector& operator-=(const BasicVector& other) {
+    for(size_t index = 0; index < N; ++index) {
+      this->Component(index) -= other.Component(index);
+    }
+    return *this;
+  }
   /**
    * Vector addition. Adds components of first and second.
    */
-  friend MathVector operator+(const MathVector& first, const MathVector& second);
+  friend constexpr BasicVector operator+(const BasicVector& first, const BasicVector& second) {
+    BasicVector sum = first;
+    sum += second;
+    return sum;
+  }
   /**
    * Vector subtraction. Subtracts components of second from first.
    */
-  friend MathVector operator-(const MathVector& first, const MathVector& second);
+  friend constexpr BasicVector operator-(const BasicVector& first, const BasicVector& second) {
+    BasicVector difference = first;
+    difference -= second;
+    return difference;
+  }
 
   //Scalar multiplication and division
   /**
    * Scalar multiplication and assignment.
-   * @param scalar Scalar value to multiply the MathVector by.
+   * @param scalar Scalar value to multiply the vector by.
    */
-  MathVector& operator*=(double scalar);
+  constexpr BasicVector& operator*=(T scalar) {
+    for(size_t index = 0; index < N; ++index) {
+      this->Component(index) *= scalar;
+    }
+    return *this;
+  }
   /**
    * Scalar Multiplication.
-   * @param scalar Scalar value to multiply the MathVector by.
-   * @param vector MathVector to be multiplied by the scalar.
+   * @param scalar Scalar value to multiply the vector by.
+   * @param vector Vector to be multiplied by the scalar.
    */
-  friend MathVector operator*(const double& scalar, const MathVector& vector);
+  friend constexpr BasicVector operator*(T scalar, const BasicVector& vector) {
+    BasicVector product = vector;
+    product *= scalar;
+    return product;
+  }
   /**
    * Scalar Multiplication.
-   * @param vector MathVector to be multiplied by the scalar.
-   * @param scalar Scalar value to multiply the MathVector by.
+   * @param vector Vector to be multiplied by the scalar.
+   * @param scalar Scalar value to multiply the vector by.
    */
-  friend MathVector operator*(const MathVector& vector, const double& scalar);
-  //Negates components.
-  MathVector& operator-();
+  friend constexpr BasicVector operator*(const BasicVector& vector, T scalar) {
+    BasicVector product = vector;
+    product *= scalar;
+    return product;
+  }
   /**
-   * Scalar division and assignment.
-   * @param scalar Scalar value to divide the MathVector by.
+   * @return A copy of the vector with negated components.
    */
-  MathVector& operator/=(double scalar);
+  constexpr BasicVector operator-() const {
+    return *this * T(-1);
+  }
   /**
-   * Scalar Division.
-   * @param vector MathVector to be divided by the scalar.
-   * @param scalar Scalar value to divide the MathVector by.
+   * Scalar division and assignment. Division by zero leaves the vector unchanged.
+   * @param scalar Scalar value to divide the vector by.
    */
-  friend MathVector operator/(const MathVector& vector, const double& scalar);
-
-  //Dot and Cross product
+  constexpr BasicVector& operator/=(T scalar) {
+    if(scalar != 0) {
+      for(size_t index = 0; index < N; ++index) {
+        this->Component(index) /= scalar;
+      }
+    }
+    return *this;
+  }
   /**
-   * Dot product. Sum of products of components of first and second.
+   * Scalar Division. Division by zero returns the vector unchanged.
+   * @param vector Vector to be divided by the scalar.
+   * @param scalar Scalar value to divide the vector by.
    */
-  friend double operator*(const MathVector& first, const MathVector& second);
+  friend constexpr BasicVector operator/(const BasicVector& vector, T scalar) {
+    BasicVector quotient = vector;
+    quotient /= scalar;
+    return quotient;
+  }
+
+  //Dot product
   /**
-   * Cross product.
+   * Dot product. Sum of products of components of first and second.
    */
-  friend MathVector operator%(const MathVector& first, const MathVector& second);
+  friend constexpr T operator*(const BasicVector& first, const BasicVector& second) {
+    T dot = 0;
+    for(size_t index = 0; index < N; ++index) {
+      dot += first.Component(index) * second.Component(index);
+    }
+    return dot;
+  }
 };
 
+/**
+ * Cross product. Only defined for 3 dimensional vectors.
+ */
+template <typename T>
+constexpr BasicVector<T, 3> operator%(const BasicVector<T, 3>& first,
+                                      const BasicVector<T, 3>& second) {
+  return BasicVector<T, 3>(first.y_*second.z_ - first.z_*second.y_,
+                           first.z_*second.x_ - first.x_*second.z_,
+                           first.x_*second.y_ - first.y_*second.x_);
+}
+
+//3D double precision vector used throughout the simulation
+using MathVector = BasicVector<double, 3>;
+//2D single precision vector for the fast path
+using Vector2f = BasicVector<float, 2>;
+
 }
 
 #endif  //MATH_VECTOR_H
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <core/math_vector.h>
+#include <vector>
+
+namespace boidsimulation {
+
+/**
+ * Instruction sets the neighbor accumulation kernel can be run with.
+ */
+enum class SimdLevel { kScalar, kSse2, kAvx2 };
+
+/**
+ * Neighbors the kernel reads in place: size_ entries from one contiguous
+ * array per component of their positions and velocities.
+ */
+template <typename T, size_t N>
+struct NeighborRange {
+  const T* positions_[N];
+  const T* velocities_[N];
+  size_t size_ = 0;
+};
+
+/**
+ * Candidate neighbors of one Boid, packed into one contiguous array per
+ * component so the kernel can load several neighbors at once.
+ */
+template <typename T, size_t N>
+struct NeighborBatch {
+  void Clear();
+  void Add(const BasicVector<T, N>& position, const BasicVector<T, N>& velocity);
+  size_t Size() const;
+
+  /**
+   * @return The neighbors [begin, end) of the batch.
+   */
+  NeighborRange<T, N> Range(size_t begin, size_t end) const;
+  /**
+   * @return Every neighbor in the batch.
+   */
+  NeighborRange<T, N> Range() const;
+
+  std::vector<T> positions_[N];
+  std::vector<T> velocities_[N];
+};
+
+/**
+ * Sums over the neighbors of one Boid used by Separation, Alignment and Cohesion.
+ */
+template <typename T, size_t N>
+struct NeighborSums {
+  BasicVector<T, N> separation;
+  BasicVector<T, N> heading;
+  BasicVector<T, N> center;
+  size_t count = 0;
+};
+
+/**
+ * Accumulates into sums every neighbor in neighbors that is not at position:
+ * neighbors within separation_radius_sq push away from position, and
+ * neighbors within vision_sq add their velocity, position and one to count.
+ */
+template <typename T, size_t N>
+using NeighborKernel = void (*)(const NeighborRange<T, N>& neighbors,
+                                const BasicVector<T, N>& position,
+                                T separation_radius_sq, T vision_sq,
+                                NeighborSums<T, N>& sums);
+
+/**
+ * @return The best SimdLevel supported by the CPU running the program.
+ */
+SimdLevel DetectSimdLevel();
+
+/**
+ * @return True if the CPU running the program supports level.
+ */
+bool IsSimdLevelSupported(SimdLevel level);
+
+/**
+ * @return The kernel for level. level should be supported by the CPU.
+ * Instantiated for 3D double and 2D float vectors.
+ */
+template <typename T, size_t N>
+NeighborKernel<T, N> GetNeighborKernel(SimdLevel level);
+
+}  // namespace boidsimulation
@@ -1,7 +1,7 @@
 #pragma once
 
+#include <core/color.h>
 #include <core/math_vector.h>
-#include "cinder/gl/gl.h"
 #include <vector>
 
 namespace boidsimulation {
@@ -19,25 +19,27 @@ class Obstacle {
    * @param mass The double value of mass.
    */
   Obstacle(const MathVector& position, double size = 25,
-       ci::Color8u color = ci::Color8u(10,10,255)) :
+       Color color = Color(10,10,255)) :
         position_(position), size_(size), color_(color) { is_wall_ = false; };
 
-  /**
-   * Draws the Obstacle
-   */
-  void Draw() const;
-
   //Getters & Setters
   const boidsimulation::MathVector& GetPosition() const;
   double GetSize() const;
-  const ci::Color8u& GetColor() const;
+  const Color& GetColor() const;
 
  private:
   boidsimulation::MathVector position_;
   double size_;
-  ci::Color8u color_;
+  Color color_;
 
   bool is_wall_ = false;
 };
 
+/**
+ * Returns distance^1.35 + 1, the amount the force steering a Boid away from an
+ * Obstacle is divided by, without calling pow. Relative error is below 2e-6.
+ * @param distance Distance from the Boid to the Obstacle's center.
+ */
+double AvoidanceFalloff(double distance);
+
 }  // namespace idealgas
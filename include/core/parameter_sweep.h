@@ -0,0 +1,176 @@
+#pragma once
+
+#include <core/world.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace boidsimulation {
+
+/**
+ * Where a sweep places Obstacles before its first step.
+ */
+enum class ObstacleLayout {
+  kNone,
+  //One Obstacle in the middle of the World
+  kCenter,
+  //3 x 3 Obstacles at the quarter points of the World
+  kGrid,
+  //8 Obstacles on a circle around the middle, with a radius of a third of
+  //the World's shorter side
+  kRing
+};
+
+/**
+ * One run of a ParameterSweep.
+ */
+struct SweepConfig {
+  //Position in the sweep, which identifies the run in the output
+  size_t index = 0;
+  WorldParameters parameters;
+  size_t boid_num = 0;
+  size_t pred_num = 0;
+  ObstacleLayout obstacle_layout = ObstacleLayout::kNone;
+  uint64_t seed = 1;
+};
+
+/**
+ * Summary of a run, measured on the prey left after its last step.
+ */
+struct SweepMetrics {
+  //Prey not caught by any CheckPredatorCatch
+  size_t survivors = 0;
+  size_t caught = 0;
+  double mean_speed = 0;
+  //Length of the mean unit velocity: 0 for prey heading every way, 1 for
+  //prey all heading the same way
+  double polarization = 0;
+  //Root mean square distance of the prey from their center
+  double spread = 0;
+  //Wall clock time of the run
+  double seconds = 0;
+};
+
+/**
+ * The values a ParameterSweep tries. Every combination of the listed values
+ * is one configuration, run once per seed. Defaults are a single run with
+ * WorldParameters' defaults.
+ */
+struct SweepSpec {
+  //Settings shared by every run
+  double width = 800;
+  double height = 600;
+  size_t steps = 1000;
+
+  std::vector<size_t> boid_nums = {500};
+  std::vector<size_t> pred_nums = {6};
+  std::vector<ObstacleLayout> obstacle_layouts = {ObstacleLayout::kNone};
+  std::vector<double> separations = {1};
+  std::vector<double> alignments = {1};
+  std::vector<double> cohesions = {1};
+  std::vector<double> chases = {20};
+  std::vector<double> boid_max_speeds = {8};
+  std::vector<double> pred_max_speeds = {5};
+  std::vector<uint64_t> seeds = {1};
+
+  /**
+   * Reads a spec from lines of "name = values", where values is a comma
+   * separated list or an inclusive start:stop:step range, and "#" starts a
+   * comment. Names are width, height and steps, which take one value, and
+   * boids, predators, obstacles (none, center, grid or ring), separation,
+   * alignment, cohesion, chase, boid_max_speed, pred_max_speed and seeds.
+   * Names left out keep their defaults. Steps, boids, predators and seeds
+   * take whole numbers up to 2^53, and a range expands to at most 100000
+   * values.
+   * @param text The spec.
+   * @param spec Set from text. Unchanged if text is invalid.
+   * @param error Set to the offending line if text is invalid.
+   * @return False if a line is not understood, a list is empty or the sweep
+   * would have more than 2^53 runs.
+   */
+  static bool Parse(const std::string& text, SweepSpec& spec, std::string& error);
+
+  /**
+   * @return Number of runs, the product of the list lengths.
+   */
+  size_t ConfigCount() const;
+
+  /**
+   * @return Run index, from 0 to ConfigCount() - 1. Seeds vary fastest, so
+   * the repetitions of one configuration are neighbors, then pred_max_speed,
+   * and so on back to boids.
+   */
+  SweepConfig GetConfig(size_t index) const;
+};
+
+/**
+ * Runs every configuration of a SweepSpec headless and streams one CSV row of
+ * SweepMetrics per run to a file as runs finish, so a sweep of thousands of
+ * runs can be left overnight. Runs are spread across a thread pool one World
+ * at a time, like an Ensemble's, and are deterministic, so every column but
+ * the wall clock seconds is the same for any thread count or machine.
+ *
+ * Sweeps are resumable: rows already in the file are kept and their runs
+ * skipped, so an interrupted sweep continues where it stopped when run again
+ * with the same spec and path. Rows are in the order runs finish; the index
+ * column gives their place in the sweep.
+ */
+class ParameterSweep {
+ public:
+  explicit ParameterSweep(const SweepSpec& spec);
+
+  /**
+   * Runs one configuration on the calling thread.
+   */
+  SweepMetrics RunConfig(const SweepConfig& config) const;
+
+  /**
+   * Runs every configuration missing from the CSV file at path, appending a
+   * row and flushing after each. A partly written last row, left by a killed
+   * sweep, is dropped and its run repeated.
+   * @param path The CSV file. Created with a header row if it does not exist.
+   * @param thread_count Number of threads running configurations. 1 runs them
+   * on the calling thread only, 0 uses one thread per hardware core.
+   * @return False if path cannot be read or written, or holds anything but
+   * this sweep's header and rows.
+   */
+  bool Run(const std::string& path, size_t thread_count = 0);
+
+  /**
+   * @return Runs the last Run found already in its file.
+   */
+  size_t GetSkippedCount() const;
+
+  /**
+   * @return Runs the last Run ran and wrote.
+   */
+  size_t GetRunCount() const;
+
+  /**
+   * @return The header row of the CSV output, without a line break.
+   */
+  static std::string CsvHeader();
+
+  /**
+   * @return The row of a run, without a line break.
+   */
+  static std::string CsvRow(const SweepConfig& config, size_t steps,
+                            const SweepMetrics& metrics);
+
+ private:
+  /**
+   * Reads the rows of a CSV file and marks their runs done.
+   * @param text The file's complete lines.
+   * @param done Set to whether each run has a row.
+   * @return False if the header differs or a row does not match this sweep's
+   * run of the same index.
+   */
+  bool ReadDone(const std::string& text, std::vector<char>& done) const;
+
+  SweepSpec spec_;
+  size_t skipped_count_ = 0;
+  size_t run_count_ = 0;
+};
+
+}  // namespace boidsimulation
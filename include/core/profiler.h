@@ -0,0 +1,237 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//Set to 0 by the BOIDSIMULATION_PROFILING CMake option to compile every
+//profiling macro out
+#ifndef BOIDSIMULATION_PROFILING
+#define BOIDSIMULATION_PROFILING 1
+#endif
+
+namespace boidsimulation {
+
+/**
+ * Average cost of one timer or counter over the frames in the summary window.
+ */
+struct ProfileSummary {
+  std::string name;
+  //True for timers, false for counters
+  bool timer = false;
+  //Milliseconds for timers, summed over threads, or the counted total
+  double per_frame = 0;
+  double calls_per_frame = 0;
+};
+
+/**
+ * Collects scoped timers and counters from every thread. Recording is off
+ * until SetEnabled(true), and costs one relaxed load per timer or counter
+ * while off. Each thread records into its own buffer, so timers and counters
+ * in parallel loops do not contend with each other.
+ *
+ * Timers made with BOIDSIMULATION_PROFILE_SCOPE also keep a trace event for
+ * the Chrome trace export; those made with BOIDSIMULATION_PROFILE_TIME only
+ * add to the totals, and are meant for code that runs once per Boid. EndFrame
+ * closes a frame and folds its totals into a rolling summary.
+ */
+class Profiler {
+ public:
+  //Frames averaged by GetSummary
+  static const size_t kSummaryFrames = 60;
+  //Trace events kept per thread. Older events are overwritten
+  static const size_t kMaxEvents = 1 << 16;
+
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * @return The Profiler shared by the whole program.
+   */
+  static Profiler& Get() {
+    static Profiler profiler;
+    return profiler;
+  }
+
+  Profiler(const Profiler& other) = delete;
+  Profiler& operator=(const Profiler& other) = delete;
+
+  void SetEnabled(bool enabled);
+  bool IsEnabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Adds the time from start to end to the timer name of the calling thread.
+   * @param name A string literal, which must outlive the Profiler.
+   * @param trace Whether to also keep a trace event.
+   */
+  void AddTime(const char* name, Clock::time_point start, Clock::time_point end, bool trace);
+
+  /**
+   * Adds value to the counter name of the calling thread.
+   */
+  void AddCount(const char* name, uint64_t value);
+
+  /**
+   * Ends a frame: folds every thread's totals since the last EndFrame into the
+   * summary window, and keeps the counters as trace counter events.
+   */
+  void EndFrame();
+
+  /**
+   * @return Per frame averages over the last kSummaryFrames frames, timers
+   * first, each group in order of first use.
+   */
+  std::vector<ProfileSummary> GetSummary() const;
+
+  /**
+   * Writes every kept event as Chrome trace-event JSON, which chrome://tracing
+   * and Perfetto open.
+   * @return False if the file could not be written.
+   */
+  bool WriteChromeTrace(const std::string& path) const;
+
+  /**
+   * Drops every event, total and summary frame.
+   */
+  void Clear();
+
+ private:
+  struct Event {
+    const char* name;
+    //Microseconds since the Profiler was created
+    double start;
+    double duration;
+    //Counter value; duration is negative for counter events
+    uint64_t value;
+  };
+
+  /**
+   * Running total of one timer or counter on one thread. Only the owning
+   * thread adds to it; EndFrame takes the values with exchanges.
+   */
+  struct Total {
+    const char* name = nullptr;
+    bool timer = false;
+    std::atomic<uint64_t> value{0};
+    std::atomic<uint64_t> calls{0};
+  };
+
+  /**
+   * Everything one thread records. Reused by a later thread once its owner exits.
+   */
+  struct ThreadBuffer {
+    static const size_t kMaxTotals = 64;
+
+    size_t lane = 0;
+    Total totals[kMaxTotals];
+    //Entries of totals in use. Only the owning thread adds entries
+    std::atomic<size_t> total_count{0};
+
+    //Guards the events, which the export reads from another thread
+    std::mutex mutex;
+    std::vector<Event> events;
+    size_t next_event = 0;
+  };
+
+  /**
+   * Releases a thread's buffer when the thread exits.
+   */
+  struct ThreadRegistration {
+    ThreadBuffer* buffer = nullptr;
+    ~ThreadRegistration();
+  };
+
+  /**
+   * Totals of one timer or counter for one frame, merged across threads.
+   */
+  struct FrameTotal {
+    const char* name;
+    bool timer;
+    uint64_t value;
+    uint64_t calls;
+  };
+
+  Profiler();
+
+  /**
+   * @return The calling thread's buffer, taking a free one on first use.
+   */
+  ThreadBuffer& GetThreadBuffer();
+
+  /**
+   * @return The calling thread's total for name, added on first use. Null if
+   * the buffer has no room left.
+   */
+  Total* FindTotal(ThreadBuffer& buffer, const char* name, bool timer);
+
+  void AddEvent(ThreadBuffer& buffer, const Event& event);
+  double Microseconds(Clock::time_point time) const;
+
+  std::atomic<bool> enabled_{false};
+  Clock::time_point epoch_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+  std::vector<ThreadBuffer*> free_buffers_;
+  std::deque<std::vector<FrameTotal>> frames_;
+  //Counter events recorded by EndFrame
+  std::vector<Event> counter_events_;
+};
+
+/**
+ * Times the enclosing scope into a Profiler timer.
+ */
+class ProfileScope {
+ public:
+  ProfileScope(const char* name, bool trace) : name_(name), trace_(trace) {
+    if(Profiler::Get().IsEnabled()) {
+      start_ = Profiler::Clock::now();
+      timing_ = true;
+    }
+  }
+
+  ~ProfileScope() {
+    if(timing_) {
+      Profiler::Get().AddTime(name_, start_, Profiler::Clock::now(), trace_);
+    }
+  }
+
+  ProfileScope(const ProfileScope& other) = delete;
+  ProfileScope& operator=(const ProfileScope& other) = delete;
+
+ private:
+  const char* name_;
+  bool trace_;
+  bool timing_ = false;
+  Profiler::Clock::time_point start_;
+};
+
+}  // namespace boidsimulation
+
+#define BOIDSIMULATION_PROFILE_CONCAT_INNER(a, b) a##b
+#define BOIDSIMULATION_PROFILE_CONCAT(a, b) BOIDSIMULATION_PROFILE_CONCAT_INNER(a, b)
+
+#if BOIDSIMULATION_PROFILING
+//Times the rest of the enclosing scope and keeps a trace event for it
+#define BOIDSIMULATION_PROFILE_SCOPE(name) \
+  ::boidsimulation::ProfileScope BOIDSIMULATION_PROFILE_CONCAT(profile_scope_, __LINE__)(name, true)
+//Times the rest of the enclosing scope into the totals only
+#define BOIDSIMULATION_PROFILE_TIME(name) \
+  ::boidsimulation::ProfileScope BOIDSIMULATION_PROFILE_CONCAT(profile_scope_, __LINE__)(name, false)
+#define BOIDSIMULATION_PROFILE_COUNT(name, value) \
+  do { \
+    if(::boidsimulation::Profiler::Get().IsEnabled()) { \
+      ::boidsimulation::Profiler::Get().AddCount(name, value); \
+    } \
+  } while(false)
+#else
+#define BOIDSIMULATION_PROFILE_SCOPE(name) do {} while(false)
+#define BOIDSIMULATION_PROFILE_TIME(name) do {} while(false)
+#define BOIDSIMULATION_PROFILE_COUNT(name, value) do { (void)sizeof(value); } while(false)
+#endif
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <core/flock_geometry.h>
+#include <core/triple_buffer.h>
+#include <core/world.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace boidsimulation {
+
+/**
+ * One finished step of a World, ready to draw.
+ */
+struct SimulationFrame {
+  //Steps taken since the SimulationThread was created
+  uint64_t step = 0;
+  FlockGeometry geometry;
+  //Also in geometry; kept apart so they can be drawn under a replay
+  std::vector<Obstacle> obstacles;
+  CatchStats catch_stats;
+  size_t boid_count = 0;
+  size_t predator_count = 0;
+};
+
+/**
+ * Steps a World on its own thread at a fixed rate, independent of how fast
+ * it is drawn. After every step the thread builds the frame's geometry and
+ * publishes it through a TripleBuffer, so the renderer always draws the latest
+ * complete frame and never waits on a step in progress.
+ *
+ * While running, the World belongs to the simulation thread. Other threads
+ * change it only through Post, which runs the change between two steps.
+ */
+class SimulationThread {
+ public:
+  /**
+   * @param world The World to step. Must outlive the SimulationThread.
+   */
+  explicit SimulationThread(World& world);
+
+  /**
+   * Stops the thread.
+   */
+  ~SimulationThread();
+
+  SimulationThread(const SimulationThread& other) = delete;
+  SimulationThread& operator=(const SimulationThread& other) = delete;
+
+  /**
+   * Starts stepping the World.
+   * @param steps_per_second Target step rate. 0 steps as fast as possible.
+   */
+  void Start(double steps_per_second);
+
+  /**
+   * Runs the changes still posted, then stops and joins the thread. The World
+   * may be used directly again once this returns.
+   */
+  void Stop();
+
+  bool IsRunning() const;
+
+  /**
+   * Queues command to be run on the World before the next step. Runs it
+   * right away when the thread is not running.
+   */
+  void Post(const std::function<void(World&)>& command);
+
+  /**
+   * Stops or resumes stepping. Posted changes still run, and still publish a
+   * frame, while paused.
+   */
+  void SetPaused(bool paused);
+  bool IsPaused() const;
+
+  /**
+   * Swaps in the newest published frame, if there is one. Call from the one
+   * thread that draws.
+   * @return The latest complete frame. Empty before the first publish.
+   */
+  const SimulationFrame& AcquireFrame();
+
+ private:
+  /**
+   * Runs posted commands and steps the World until Stop. Runs on thread_.
+   */
+  void Run(double steps_per_second);
+
+  /**
+   * Runs and clears the posted commands.
+   * @return True if there were any.
+   */
+  bool RunCommands();
+
+  /**
+   * Fills the write buffer from the World and publishes it.
+   */
+  void PublishFrame();
+
+  World& world_;
+  std::thread thread_;
+  uint64_t step_ = 0;
+
+  std::mutex mutex_;
+  //Signaled by Stop, Post and SetPaused
+  std::condition_variable wake_condition_;
+  bool stopping_ = false;
+  std::atomic<bool> paused_{false};
+  std::vector<std::function<void(World&)>> commands_;
+  //Swapped with commands_ so they run without holding mutex_
+  std::vector<std::function<void(World&)>> running_commands_;
+
+  TripleBuffer<SimulationFrame> frames_;
+};
+
+}  // namespace boidsimulation
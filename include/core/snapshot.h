@@ -0,0 +1,39 @@
+#pragma once
+
+#include <core/world.h>
+
+#include <stdint.h>
+#include <string>
+
+namespace boidsimulation {
+
+/**
+ * Saves and restores the full state of a World as a versioned binary file:
+ * bounds, parameters, random state, step count, catch totals, Boids,
+ * Predators and Obstacles. Each FlockState array is stored exactly as it is
+ * held in memory and the file is accessed through mmap, so saving or loading
+ * is one copy per array. The small species tables are written field by field
+ * so their padding cannot make identical Worlds save differently.
+ */
+class Snapshot {
+ public:
+  //Bumped whenever the file layout changes. Other versions are rejected
+  static const uint32_t kVersion = 3;
+
+  /**
+   * Writes world to path. An existing file at path is only replaced once the
+   * new snapshot has been written completely.
+   * @return False if the file could not be written.
+   */
+  static bool Save(const World& world, const std::string& path);
+
+  /**
+   * Replaces the state of world with the snapshot at path. The thread count
+   * is kept. world is left unchanged if the file is missing, truncated, or
+   * of another version or precision.
+   * @return False if the snapshot could not be loaded.
+   */
+  static bool Load(const std::string& path, World& world);
+};
+
+}  // namespace boidsimulation
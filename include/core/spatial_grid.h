@@ -0,0 +1,214 @@
+#pragma once
+
+#include <core/boid.h>
+#include <core/flock_state.h>
+#include <core/math_vector.h>
+#include <core/obstacle.h>
+#include <stdint.h>
+#include <vector>
+
+namespace boidsimulation {
+
+/**
+ * Uniform grid over the x-y plane used to find the Boids near a position
+ * without scanning the whole flock. Rebuilt once per frame from the flock's
+ * current positions, with a cell size equal to the largest vision_ in the flock.
+ * Works with flocks of any precision and dimension; only x and y are binned.
+ * Can also index Obstacles, which change rarely, for line queries.
+ */
+class SpatialGrid {
+ public:
+  SpatialGrid() = default;
+
+  /**
+   * Bins every Boid of flock into the grid by its current position.
+   * @param flock The Boids to index. Indices returned by queries refer to this flock.
+   * @param padding Distance every query is widened by. Should be at least how
+   * far any Boid in flock can move between the rebuild and the query.
+   */
+  template <typename T, size_t N>
+  void Rebuild(const BasicFlockState<T, N>& flock, double padding = 0);
+  template <typename T, size_t N>
+  void Rebuild(const std::vector<BasicBoid<T, N>>& flock, double padding = 0);
+
+  /**
+   * Bins every Obstacle by its center. Queries are widened by the largest
+   * Obstacle size so they find every Obstacle reaching within the query distance.
+   * @param obstacles The Obstacles to index. Indices returned by queries refer
+   * to this vector.
+   */
+  void Rebuild(const std::vector<Obstacle>& obstacles);
+
+  /**
+   * Removes all Boids from the grid.
+   */
+  void Clear();
+
+  /**
+   * Appends the indices of every Boid that may lie within radius of position.
+   * Indices are appended in ascending order so that callers visit neighbors in
+   * the same order as a scan over the whole flock.
+   * @param position The center of the query.
+   * @param radius The query distance.
+   * @param candidates Vector to append the candidate indices to.
+   */
+  template <typename T, size_t N>
+  void QueryCandidates(const BasicVector<T, N>& position, double radius,
+                       std::vector<size_t>& candidates) const {
+    QueryCandidates(position.x_, position.y_, radius, candidates);
+  }
+  /**
+   * Same as above for a query centered on the point (x, y).
+   */
+  void QueryCandidates(double x, double y, double radius,
+                       std::vector<size_t>& candidates) const;
+
+  /**
+   * Calls visit with the index of every Boid that may lie within radius of
+   * position, in ascending order. visit must not query the grid itself.
+   */
+  template <typename T, size_t N, typename Visitor>
+  void ForEachCandidate(const BasicVector<T, N>& position, double radius,
+                        Visitor visit) const {
+    thread_local std::vector<size_t> candidates;
+    candidates.clear();
+    QueryCandidates(position, radius, candidates);
+    for(size_t boid_index : candidates) {
+      visit(boid_index);
+    }
+  }
+
+  /**
+   * Calls visit(begin, end) with the entries [begin, end) of GetCellOrder()
+   * that may lie within radius of position, one contiguous run per row of
+   * cells, so data laid out in cell order can be read in place. Together the
+   * runs hold the same Boids as ForEachCandidate, in cell order.
+   */
+  template <typename T, size_t N, typename Visitor>
+  void ForEachCandidateRun(const BasicVector<T, N>& position, double radius,
+                           Visitor visit) const {
+    size_t first_x, last_x, first_y, last_y;
+    if(!CellRange(position.x_, position.y_, radius, first_x, last_x, first_y, last_y)) {
+      return;
+    }
+    for(size_t cell_y = first_y; cell_y <= last_y; ++cell_y) {
+      size_t row = cell_y * cells_x_;
+      if(cell_start_[row + first_x] < cell_start_[row + last_x + 1]) {
+        visit(cell_start_[row + first_x], cell_start_[row + last_x + 1]);
+      }
+    }
+  }
+
+  /**
+   * Calls visit with the index of Boids that may lie within radius of
+   * position, in no particular order, until visit returns true. Cheaper than
+   * ForEachCandidate when any match will do.
+   * @return True if visit returned true.
+   */
+  template <typename T, size_t N, typename Visitor>
+  bool AnyCandidate(const BasicVector<T, N>& position, double radius, Visitor visit) const {
+    size_t first_x, last_x, first_y, last_y;
+    if(!CellRange(position.x_, position.y_, radius, first_x, last_x, first_y, last_y)) {
+      return false;
+    }
+    for(size_t cell_y = first_y; cell_y <= last_y; ++cell_y) {
+      size_t row = cell_y * cells_x_;
+      for(size_t entry = cell_start_[row + first_x]; entry < cell_start_[row + last_x + 1];
+          ++entry) {
+        if(visit(indices_[entry])) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Appends the indices of every entry that may lie within distance of the
+   * infinite line through position along direction, in ascending order.
+   * Only the x and y components are used. A direction with no x or y
+   * component returns every entry.
+   */
+  template <typename T, size_t N>
+  void QueryLine(const BasicVector<T, N>& position, const BasicVector<T, N>& direction,
+                 double distance, std::vector<size_t>& candidates) const {
+    QueryLine(position.x_, position.y_, direction.x_, direction.y_, distance, candidates);
+  }
+  /**
+   * Same as above for the line through (x, y) along (dx, dy).
+   */
+  void QueryLine(double x, double y, double dx, double dy, double distance,
+                 std::vector<size_t>& candidates) const;
+
+  /**
+   * Calls visit with the index of every entry that may lie within distance of
+   * the line through position along direction, in ascending order. visit must
+   * not query the grid itself.
+   */
+  template <typename T, size_t N, typename Visitor>
+  void ForEachOnLine(const BasicVector<T, N>& position, const BasicVector<T, N>& direction,
+                     double distance, Visitor visit) const {
+    thread_local std::vector<size_t> candidates;
+    candidates.clear();
+    QueryLine(position, direction, distance, candidates);
+    for(size_t index : candidates) {
+      visit(index);
+    }
+  }
+
+  double GetCellSize() const;
+  size_t GetCellCount() const;
+
+  /**
+   * @return Every indexed Boid, sorted by cell.
+   */
+  const std::vector<size_t>& GetCellOrder() const;
+
+  /**
+   * @return An id no other Rebuild of any grid shares, or 0 if the grid is
+   * empty, so data copied in cell order can tell whether it is still current.
+   */
+  uint64_t GetBuildId() const;
+
+ private:
+  /**
+   * Bins positions into cells of at least cell_size. Helper for Rebuild.
+   */
+  template <typename T, size_t N>
+  void Build(const std::vector<BasicVector<T, N>>& positions, double cell_size,
+             double padding);
+
+  /**
+   * Appends the indices in column cell_x from row first_y to row last_y.
+   * Helper for QueryLine.
+   */
+  void AppendColumn(size_t cell_x, size_t first_y, size_t last_y,
+                    std::vector<size_t>& candidates) const;
+
+  /**
+   * Finds the cells overlapping the square of half width radius, widened by
+   * padding_, around (x, y).
+   * @return False if the square is entirely off the grid.
+   */
+  bool CellRange(double x, double y, double radius, size_t& first_x, size_t& last_x,
+                 size_t& first_y, size_t& last_y) const;
+
+  /**
+   * Returns the cell column/row containing coordinate, clamped to the grid.
+   */
+  size_t CellCoordinate(double coordinate, double min, size_t cells) const;
+
+  double cell_size_ = 0;
+  double padding_ = 0;
+  double min_x_ = 0;
+  double min_y_ = 0;
+  size_t cells_x_ = 0;
+  size_t cells_y_ = 0;
+  uint64_t build_id_ = 0;
+
+  //Boid indices sorted by cell. Cell i owns indices_[cell_start_[i], cell_start_[i+1])
+  std::vector<size_t> cell_start_;
+  std::vector<size_t> indices_;
+};
+
+}  // namespace boidsimulation
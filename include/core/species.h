@@ -0,0 +1,45 @@
+#pragma once
+
+#include <core/color.h>
+
+namespace boidsimulation {
+
+/**
+ * Tunables shared by every Boid of one species. A FlockState keeps a small
+ * table of these and each of its Boids stores only an index into it, so
+ * changing a tunable is one write however many Boids share it. Defaults match
+ * BasicBoid's.
+ */
+template <typename T>
+struct BasicSpecies {
+  T size = 10;
+  T vision = 50;
+  T max_speed = 8;
+
+  T separation_scale = 1;
+  T alignment_scale = 1;
+  T cohesion_scale = 1;
+  //Affects predator and prey movement
+  T chase_scale = 20;
+  T obstacle_scale = 25;
+
+  Color color = Color(255,255,255);
+  bool predator = false;
+
+  bool operator==(const BasicSpecies& other) const {
+    return size == other.size && vision == other.vision && max_speed == other.max_speed &&
+           separation_scale == other.separation_scale &&
+           alignment_scale == other.alignment_scale &&
+           cohesion_scale == other.cohesion_scale && chase_scale == other.chase_scale &&
+           obstacle_scale == other.obstacle_scale && color == other.color &&
+           predator == other.predator;
+  }
+  bool operator!=(const BasicSpecies& other) const {
+    return !(*this == other);
+  }
+};
+
+//Species of the double precision simulation
+using Species = BasicSpecies<double>;
+
+}  // namespace boidsimulation
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace boidsimulation {
+
+/**
+ * A fixed set of worker threads that stay alive between simulation steps and
+ * split loops over Boids into chunks.
+ */
+class ThreadPool {
+ public:
+  /**
+   * Starts the worker threads.
+   * @param thread_count Total number of threads working on a loop, including
+   * the calling thread. 0 uses one thread per hardware core.
+   */
+  explicit ThreadPool(size_t thread_count = 0);
+
+  /**
+   * Stops and joins the worker threads.
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool& other) = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  /**
+   * Calls task(begin, end) for consecutive chunks of [0, count) across all
+   * threads, and returns once every chunk is done. The calling thread works
+   * on chunks too.
+   * @param count Number of items to process.
+   * @param chunk_size Maximum number of items handed to one call of task.
+   * @param task Function processing the items in [begin, end).
+   */
+  void ParallelFor(size_t count, size_t chunk_size,
+                   const std::function<void(size_t, size_t)>& task);
+
+  /**
+   * @return Number of threads working on a loop, including the calling thread.
+   */
+  size_t GetThreadCount() const;
+
+ private:
+  /**
+   * Waits for loops to be posted and works on them until the pool is destroyed.
+   */
+  void WorkerLoop();
+
+  /**
+   * Claims and runs chunks of the current loop until none are left.
+   */
+  void RunChunks();
+
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable start_condition_;
+  std::condition_variable done_condition_;
+  size_t generation_ = 0;
+  size_t busy_workers_ = 0;
+  bool stopping_ = false;
+
+  //Loop currently being processed
+  const std::function<void(size_t, size_t)>* task_ = nullptr;
+  size_t count_ = 0;
+  size_t chunk_size_ = 1;
+  std::atomic<size_t> next_chunk_;
+};
+
+}  // namespace boidsimulation
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace boidsimulation {
+
+/**
+ * Layout of a trajectory file written by TrajectoryRecorder:
+ *
+ *   TrajectoryHeader
+ *   per recorded frame: TrajectoryFrameHeader, then payload_bytes of values
+ *   per recorded frame: uint64_t file offset of its TrajectoryFrameHeader
+ *   TrajectoryFooter
+ *
+ * A frame's payload holds x, y, velocity x and velocity y of every prey Boid
+ * then every Predator, each quantized to a whole number of resolution steps
+ * and stored as a zigzag varint. Keyframes store the quantized values
+ * themselves; other frames store the difference from the previous recorded
+ * frame, which always has the same Boid counts. Values are in host byte order.
+ */
+const char kTrajectoryMagic[8] = {'B', 'O', 'I', 'D', 'T', 'R', 'A', 'J'};
+const char kTrajectoryIndexMagic[8] = {'B', 'O', 'I', 'D', 'I', 'D', 'X', '1'};
+const uint32_t kTrajectoryVersion = 1;
+
+//Quantized values stored per Boid: x, y, velocity x, velocity y
+const size_t kTrajectoryValuesPerBoid = 4;
+
+struct TrajectoryHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t keyframe_interval;
+  double position_resolution;
+  double velocity_resolution;
+};
+
+struct TrajectoryFrameHeader {
+  //Number of the World step the frame was taken at, counting dropped frames
+  uint64_t step;
+  uint32_t boid_count;
+  uint32_t predator_count;
+  //0 for keyframes, otherwise how many frames back the last keyframe is
+  uint32_t since_keyframe;
+  uint32_t payload_bytes;
+};
+
+struct TrajectoryFooter {
+  uint64_t frame_count;
+  uint64_t index_offset;
+  char magic[8];
+};
+
+/**
+ * Appends value to bytes as a zigzag varint: small magnitudes of either sign
+ * take few bytes.
+ */
+inline void AppendVarint(int64_t value, std::vector<uint8_t>& bytes) {
+  uint64_t zigzag = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+  while(zigzag >= 0x80) {
+    bytes.push_back((uint8_t)(zigzag | 0x80));
+    zigzag >>= 7;
+  }
+  bytes.push_back((uint8_t)zigzag);
+}
+
+/**
+ * Reads a zigzag varint written by AppendVarint from data, advancing data
+ * past it. The caller makes sure data holds a whole varint. Reads at most the
+ * 10 bytes of the longest 64 bit value, so damaged data cannot shift past 63.
+ */
+inline int64_t ReadVarint(const uint8_t*& data) {
+  uint64_t zigzag = 0;
+  int shift = 0;
+  while((*data & 0x80) && shift < 63) {
+    zigzag |= (uint64_t)(*data++ & 0x7F) << shift;
+    shift += 7;
+  }
+  zigzag |= (uint64_t)*data++ << shift;
+  return (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+}
+
+}  // namespace boidsimulation
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <core/flock_state.h>
+#include <core/mapped_file.h>
+#include <core/trajectory_format.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace boidsimulation {
+
+/**
+ * Plays back a trajectory file written by TrajectoryRecorder. The file is
+ * mapped rather than read, so only the frames visited are loaded. Any frame
+ * is found in O(1) through the frame index at the end of the file and decoded
+ * from its keyframe; stepping forward one frame decodes only its deltas.
+ */
+class TrajectoryPlayer {
+ public:
+  TrajectoryPlayer() = default;
+
+  /**
+   * Maps the trajectory at path and shows its first frame. Recordings that
+   * were never closed have no index; one is built by walking the frame
+   * headers.
+   * @return False if the file is missing or not a trajectory of this version.
+   */
+  bool Open(const std::string& path);
+  void Close();
+  bool IsOpen() const;
+
+  size_t GetFrameCount() const;
+
+  /**
+   * Decodes frame into GetBoids and GetPredators.
+   * @return False if frame is out of range or damaged.
+   */
+  bool SeekFrame(size_t frame);
+  size_t GetCurrentFrame() const;
+
+  /**
+   * @return The World step the current frame was recorded at.
+   */
+  uint64_t GetStep() const;
+
+  /**
+   * Sets the sizes the played back Boids are drawn with, which trajectories
+   * do not store. Applies from the next frame decoded.
+   */
+  void SetSizes(double boid_size, double predator_size);
+
+  /**
+   * Returns the prey and Predators of the current frame. Only positions and
+   * velocities come from the trajectory.
+   */
+  const FlockState& GetBoids() const;
+  const FlockState& GetPredators() const;
+
+ private:
+  /**
+   * @return The file offset of frame's TrajectoryFrameHeader.
+   */
+  uint64_t FrameOffset(size_t frame) const;
+  TrajectoryFrameHeader ReadFrameHeader(size_t frame) const;
+
+  /**
+   * Adds frame's stored values to values_, or replaces them for a keyframe,
+   * and copies them into the flocks.
+   * @return False if the frame does not fit its payload.
+   */
+  bool DecodeFrame(size_t frame);
+
+  /**
+   * Walks the frame headers from the start of the file to index a recording
+   * that was not closed. Helper for Open.
+   */
+  void ScanFrames();
+
+  MappedFile file_;
+  TrajectoryHeader header_ = TrajectoryHeader();
+  //Offset of the footer's frame index, 0 when frames were scanned instead
+  uint64_t index_offset_ = 0;
+  std::vector<uint64_t> scanned_offsets_;
+  size_t frame_count_ = 0;
+  size_t current_frame_ = 0;
+  bool decoded_ = false;
+
+  std::vector<int64_t> values_;
+  FlockState boids_;
+  FlockState predators_;
+  double boid_size_ = 10;
+  double predator_size_ = 15;
+};
+
+}  // namespace boidsimulation
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <core/world.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace boidsimulation {
+
+/**
+ * What Record does when every frame buffer is still waiting to be written.
+ */
+enum class BackpressurePolicy {
+  //Drop the frame being recorded
+  kDropNewest,
+  //Drop the oldest frame still waiting, keeping the recording as recent as possible
+  kDropOldest
+};
+
+struct RecorderOptions {
+  //Preallocated frame buffers. Memory use is bounded by this many frames
+  size_t frame_buffers = 8;
+  BackpressurePolicy policy = BackpressurePolicy::kDropNewest;
+  //Frames between keyframes, which replay can start decoding from
+  uint32_t keyframe_interval = 30;
+  //Smallest position and velocity steps kept, in World units
+  double position_resolution = 1.0 / 64;
+  double velocity_resolution = 1.0 / 256;
+};
+
+struct RecorderStats {
+  //Frames passed to Record, including dropped ones
+  size_t steps = 0;
+  size_t dropped = 0;
+  size_t frames_written = 0;
+  //Bytes that reached the file, not counting those of a failed write
+  size_t bytes_written = 0;
+  //Set once a write fails, after which no more frames are written
+  bool write_failed = false;
+};
+
+/**
+ * Records the positions and velocities of a World's Boids every step into a
+ * compact trajectory file (see trajectory_format.h). Record only copies the
+ * flock into a preallocated frame buffer; a background thread quantizes,
+ * delta encodes and writes the frames, so the step loop never waits on the
+ * disk. When the writer falls behind, frames are dropped by the
+ * BackpressurePolicy.
+ */
+class TrajectoryRecorder {
+ public:
+  explicit TrajectoryRecorder(const RecorderOptions& options = RecorderOptions());
+
+  /**
+   * Writes every queued frame and closes the file.
+   */
+  ~TrajectoryRecorder();
+
+  TrajectoryRecorder(const TrajectoryRecorder& other) = delete;
+  TrajectoryRecorder& operator=(const TrajectoryRecorder& other) = delete;
+
+  /**
+   * Creates the trajectory file at path and starts the writer thread.
+   * @return False if the file could not be created.
+   */
+  bool Open(const std::string& path);
+
+  /**
+   * Queues the current positions and velocities of world's Boids and
+   * Predators to be written. Never waits for the writer.
+   * @return False if this frame was dropped or no file is open. Dropping an
+   * older frame under kDropOldest still returns true.
+   */
+  bool Record(const World& world);
+
+  /**
+   * Writes every queued frame and the frame index, then closes the file.
+   * @return False if any write to the file failed, such as on a full disk,
+   * which leaves the recording truncated. True if no file is open.
+   */
+  bool Close();
+
+  bool IsOpen() const;
+  RecorderStats GetStats() const;
+
+ private:
+  /**
+   * A copy of one step of the World, reused between frames.
+   */
+  struct Frame {
+    uint64_t step = 0;
+    size_t boid_count = 0;
+    //Prey Boids followed by Predators
+    std::vector<MathVector> positions;
+    std::vector<MathVector> velocities;
+  };
+
+  /**
+   * Writes queued frames until Close. Runs on writer_.
+   */
+  void WriterLoop();
+
+  /**
+   * Quantizes frame, encodes it against the previously written frame and
+   * appends it to the file. Does nothing once a write has failed. Called on
+   * the writer thread only.
+   */
+  void WriteFrame(const Frame& frame);
+
+  RecorderOptions options_;
+  FILE* file_ = nullptr;
+  std::thread writer_;
+
+  std::vector<Frame> frames_;
+  mutable std::mutex mutex_;
+  std::condition_variable queued_condition_;
+  //Indices into frames_
+  std::deque<size_t> free_frames_;
+  std::deque<size_t> queued_frames_;
+  bool closing_ = false;
+  RecorderStats stats_;
+
+  //Writer thread state
+  std::vector<int64_t> previous_values_;
+  uint32_t previous_boid_count_ = 0;
+  uint32_t previous_predator_count_ = 0;
+  uint32_t since_keyframe_ = 0;
+  std::vector<int64_t> values_;
+  std::vector<uint8_t> payload_;
+  std::vector<uint64_t> frame_offsets_;
+  uint64_t offset_ = 0;
+  bool write_failed_ = false;
+};
+
+}  // namespace boidsimulation
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+namespace boidsimulation {
+
+/**
+ * Hands values from one writer thread to one reader thread without locks.
+ * The writer fills the write buffer and publishes it; the reader acquires the
+ * most recently published buffer. Neither side ever waits on the other: the
+ * writer always has a free buffer to fill, and the reader keeps its current
+ * buffer until a newer one is published. Values published between two
+ * acquires are skipped.
+ */
+template <typename T>
+class TripleBuffer {
+ public:
+  TripleBuffer() = default;
+
+  TripleBuffer(const TripleBuffer& other) = delete;
+  TripleBuffer& operator=(const TripleBuffer& other) = delete;
+
+  /**
+   * @return The buffer the writer fills next. Writer thread only.
+   */
+  T& GetWriteBuffer() {
+    return buffers_[write_];
+  }
+
+  /**
+   * Makes the write buffer the newest value and takes back a free buffer to
+   * write into. The new write buffer holds an older value. Writer thread only.
+   */
+  void Publish() {
+    write_ = middle_.exchange(write_ | kFresh, std::memory_order_acq_rel) & kIndexMask;
+  }
+
+  /**
+   * Swaps in the newest published value if there is one the reader has not
+   * seen. Reader thread only.
+   * @return True if the read buffer changed.
+   */
+  bool Acquire() {
+    if(!(middle_.load(std::memory_order_relaxed) & kFresh)) {
+      return false;
+    }
+    read_ = middle_.exchange(read_, std::memory_order_acq_rel) & kIndexMask;
+    return true;
+  }
+
+  /**
+   * @return The value swapped in by the last Acquire. Reader thread only.
+   */
+  const T& GetReadBuffer() const {
+    return buffers_[read_];
+  }
+
+ private:
+  static const uint8_t kIndexMask = 3;
+  //Set in middle_ when it holds a value the reader has not acquired
+  static const uint8_t kFresh = 4;
+
+  T buffers_[3];
+  uint8_t write_ = 0;
+  //Index of the buffer neither side owns, plus kFresh
+  std::atomic<uint8_t> middle_{1};
+  uint8_t read_ = 2;
+};
+
+}  // namespace boidsimulation
@@ -0,0 +1,391 @@
+#pragma once
+
+#include <core/boid.h>
+#include <core/counter_random.h>
+#include <core/flock_state.h>
+#include <core/obstacle.h>
+#include <core/spatial_grid.h>
+#include <core/thread_pool.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace boidsimulation {
+
+/**
+ * Tunable behavior of the Boids in a World. Changes are written into the prey
+ * and Predator species at the start of the next Update.
+ */
+struct WorldParameters {
+  double boid_size = 10;
+  double boid_max_speed = 8;
+  double separation = 1;
+  double alignment = 1;
+  double cohesion = 1;
+
+  double pred_size = 15;
+  double pred_max_speed = 5;
+  double chase = 20;
+
+  double obstacle_size = 25;
+
+  bool operator==(const WorldParameters& other) const {
+    return boid_size == other.boid_size && boid_max_speed == other.boid_max_speed &&
+           separation == other.separation && alignment == other.alignment &&
+           cohesion == other.cohesion && pred_size == other.pred_size &&
+           pred_max_speed == other.pred_max_speed && chase == other.chase &&
+           obstacle_size == other.obstacle_size;
+  }
+  bool operator!=(const WorldParameters& other) const {
+    return !(*this == other);
+  }
+};
+
+/**
+ * How SpawnBulk places Boids inside its region.
+ */
+enum class SpawnDistribution {
+  //Evenly over the region
+  kUniform,
+  //Normally around the region's center with a standard deviation of a sixth
+  //of its size, clamped to the region
+  kNormal
+};
+
+/**
+ * An axis aligned rectangle in World coordinates.
+ */
+struct SpawnRegion {
+  double min_x;
+  double min_y;
+  double width;
+  double height;
+};
+
+/**
+ * Predator catches counted by CheckPredatorCatch.
+ */
+struct CatchStats {
+  //Prey caught by the last CheckPredatorCatch
+  size_t caught = 0;
+  //Prey distance checks made by the last CheckPredatorCatch
+  size_t candidates = 0;
+  //Prey caught since the World was created or cleared
+  size_t total_caught = 0;
+};
+
+/**
+ * A rectangular region of prey, Predators and Obstacles and the rules that
+ * move them. Has no rendering or windowing dependencies, so it can be stepped
+ * headless; the visualizer's Environment wraps one for display. Templated on
+ * the scalar type and number of dimensions of the Boids' state like
+ * BasicFlockState, with World (3D double) and World2f (2D float) instantiated.
+ * Parameters, bounds and random draws stay double in both, so a World2f
+ * spawns the same Boids as a World, rounded to float.
+ */
+template <typename T, size_t N>
+class BasicWorld {
+  friend class Snapshot;
+
+ public:
+  typedef BasicVector<T, N> VectorType;
+  typedef BasicFlockState<T, N> FlockStateType;
+  typedef BasicSpecies<T> SpeciesType;
+
+  /**
+   * Creates a World.
+   * @param min_x The smallest x coordinate inside the World.
+   * @param min_y The smallest y coordinate inside the World.
+   * @param width The x length of the World.
+   * @param height The y length of the World.
+   * @param boid_num The initial number of prey Boids.
+   * @param pred_num The initial number of Predator Boids.
+   * @param parameters The initial Boid parameters.
+   * @param seed Seed of the random positions and velocities of spawned Boids.
+   */
+  BasicWorld(double min_x, double min_y, double width, double height,
+             size_t boid_num = 50, size_t pred_num = 6,
+             const WorldParameters& parameters = WorldParameters(), uint64_t seed = 1);
+
+  /**
+   * Spawns Boids at random positions inside the World with random velocities.
+   * Helper function to the constructor.
+   * @param boid_num Number of regular boids to spawn.
+   * @param pred_num Number of predator boids to spawn.
+   */
+  void InitializeBoids(size_t boid_num, size_t pred_num);
+
+  /**
+   * Spawns count Boids at random positions in region with random velocities
+   * from -max speed to +max speed, filled across the thread pool. The Boids
+   * only depend on the seed and on how many Boids were spawned before them,
+   * not on the thread count.
+   * @param count Number of Boids to spawn.
+   * @param region Where to place the Boids.
+   * @param distribution How to spread the Boids over region.
+   * @param predator Whether to spawn Predators rather than prey.
+   */
+  void SpawnBulk(size_t count, const SpawnRegion& region,
+                 SpawnDistribution distribution = SpawnDistribution::kUniform,
+                 bool predator = false);
+
+  /**
+   * Restarts the random draws of spawned Boids from seed, so the Boids spawned
+   * next repeat those spawned after an earlier SetSeed(seed) or construction
+   * with seed.
+   */
+  void SetSeed(uint64_t seed);
+  uint64_t GetSeed() const;
+
+  /**
+   * Performs wall collisions and updates Boid velocities.
+   */
+  void Update();
+
+  /**
+   * Sets whether Update reads every Boid's state from the previous frame and
+   * writes the new frame into a separate buffer (true), or updates Boids in
+   * place so later Boids see earlier Boids' new state (false, the default).
+   * Double buffered results do not depend on the order of the Boids.
+   */
+  void SetDoubleBuffered(bool double_buffered);
+  bool IsDoubleBuffered() const;
+
+  /**
+   * Sets whether Update gives bit for bit the same results for any thread
+   * count and CPU. Deterministic Updates are always double buffered, and
+   * accumulate neighbors with the scalar kernel in grid order instead of the
+   * best SIMD kernel the CPU supports, whose lanes sum in another order.
+   * Caught prey are always removed in index order and spawned Boids only
+   * depend on the seed, so those need no change. Normally distributed spawns
+   * use the C library's log, sin and cos, which other platforms may round
+   * differently.
+   */
+  void SetDeterministic(bool deterministic);
+  bool IsDeterministic() const;
+
+  /**
+   * @return A hash of every Boid's and Obstacle's state, the species
+   * tunables, the step count and the random draws taken. Parameters are
+   * hashed once an Update has written them into the species. Worlds with the
+   * same hash are, barring collisions, bit for bit the same.
+   */
+  uint64_t GetStateHash() const;
+
+  /**
+   * Sets how many threads Update splits the Boids across. More than one thread
+   * always updates double buffered.
+   * @param thread_count Number of threads. 1 updates on the calling thread
+   * only, 0 uses one thread per hardware core.
+   */
+  void SetThreadCount(size_t thread_count);
+  size_t GetThreadCount() const;
+
+  /**
+   * Sets how often Boids in quiet regions are fully updated. A Boid is quiet
+   * when no Obstacle lies on its path and no other Boid can come within its
+   * sight for a few steps, however the others move. Quiet Boids keep their
+   * velocity for up to interval - 1 steps, as far as the nearest Boid allows,
+   * which is exactly what a full update would do while nothing is in range.
+   * Positions therefore match an every-step update; only the sign of zero
+   * velocity components may differ. Boids near others, Predators, Obstacles
+   * or walls still update every step.
+   * @param interval Steps between full updates of quiet Boids. 1, the
+   * default, fully updates every Boid every step.
+   */
+  void SetAdaptiveInterval(size_t interval);
+  size_t GetAdaptiveInterval() const;
+
+  /**
+   * @return Boid updates the last Update skipped because the Boid was quiet.
+   */
+  size_t GetDeadReckonedCount() const;
+
+  /**
+   * Checks if the Predator Boids have caught any prey Boids and
+   * deletes Prey boids accordingly. Helper function for Update method.
+   * Only prey in grid cells around each Predator are checked, and all caught
+   * prey are removed together in one pass.
+   */
+  void CheckPredatorCatch();
+
+  /**
+   * @return Catches made by the last Update and since the World was created
+   * or cleared.
+   */
+  const CatchStats& GetCatchStats() const;
+
+  /**
+   * Adds a Boid at position with a randomized velocity from -max speed to
+   * +max speed. Positions outside the World are ignored.
+   * @param position Where to spawn the Boid.
+   * @param predator Whether to spawn a Predator rather than prey.
+   */
+  void AddBoid(const VectorType& position, bool predator = false);
+
+  /**
+   * Adds an Obstacle at position if it fits entirely inside the World.
+   * The Obstacle grid is rebuilt only here and in Clear.
+   */
+  void AddObstacle(const VectorType& position);
+
+  /**
+   * Remove all Boids and Obstacles from the World.
+   */
+  void Clear();
+
+  WorldParameters& GetParameters();
+  const WorldParameters& GetParameters() const;
+
+  /**
+   * Returns the prey Boids in the World.
+   */
+  const FlockStateType& GetBoids() const;
+
+  /**
+   * Returns the Predator Boids in the World.
+   */
+  const FlockStateType& GetPredators() const;
+
+  const std::vector<Obstacle>& GetObstacles() const;
+
+  double GetMinX() const;
+  double GetMinY() const;
+  double GetWidth() const;
+  double GetHeight() const;
+
+ private:
+  /**
+   * Checks if a Boid at position is out of bounds and updates its
+   * velocity to return back in bounds. Helper function for Update method.
+   * @param position The Boid's position.
+   * @param velocity The Boid's velocity, updated in place.
+   * @param max_speed The Boid's max speed.
+   */
+  void WallBound(const VectorType& position, VectorType& velocity, double max_speed) const;
+
+  /**
+   * Writes the current prey and predator parameters into their species, which
+   * every Boid of the type shares. Helper function for Update method.
+   */
+  void ApplyParameters();
+
+  /**
+   * Moves every Boid of flock one step, writing the results into
+   * next_positions and next_velocities. These may be flock's own arrays to
+   * update in place. Helper function for Update method.
+   * @param flock The Boids to move.
+   * @param opponents The Boids of the other type.
+   * @param grid SpatialGrid of flock.
+   * @param opponent_grid SpatialGrid of opponents.
+   */
+  void StepFlock(const FlockStateType& flock, const FlockStateType& opponents,
+                 const SpatialGrid& grid, const SpatialGrid& opponent_grid,
+                 std::vector<VectorType>& next_positions,
+                 std::vector<VectorType>& next_velocities,
+                 std::vector<uint64_t>& quiet_until);
+
+  /**
+   * @return How many of the next steps the Boid at index of flock, moving with
+   * velocity, can skip keeping that velocity, up to one less than the adaptive
+   * interval. See SetAdaptiveInterval.
+   */
+  size_t QuietSteps(const FlockStateType& flock, size_t index, const FlockStateType& opponents,
+                    const SpatialGrid& grid, const SpatialGrid& opponent_grid,
+                    const VectorType& velocity) const;
+
+  /**
+   * Fully updates every Boid on the next step. Called whenever Boids, Obstacles
+   * or the parameters that bound how far Boids see and move change.
+   */
+  void ResetSchedule();
+
+  /**
+   * Calls task(begin, end) over chunks of [0, count), spread across the thread
+   * pool when there is one. Without one task is called directly, so single
+   * threaded Updates allocate nothing for it. Helper function for Update.
+   */
+  template <typename Task>
+  void ForEachChunk(size_t count, const Task& task);
+
+  /**
+   * @return A velocity with random components from -max_speed to max_speed,
+   * using random draws draw and draw + 1.
+   */
+  VectorType RandomVelocity(double max_speed, uint64_t draw) const;
+
+  /**
+   * @return A position in region spread by distribution, using random draws
+   * draw and draw + 1.
+   */
+  VectorType RandomPosition(const SpawnRegion& region, SpawnDistribution distribution,
+                            uint64_t draw) const;
+
+  /**
+   * @return The species of the given type with the current parameters. Boids
+   * see five times their size.
+   */
+  SpeciesType MakeSpecies(bool predator) const;
+
+  /**
+   * @return A vector with components x and y and any others zero.
+   */
+  static VectorType MakeVector(double x, double y);
+
+  double min_x_;
+  double min_y_;
+  double width_;
+  double height_;
+  double spawn_margin_ = 10;
+
+  //Random draws of spawned Boids. Each Boid takes kDrawsPerBoid draws starting
+  //at spawn_draw_, which then advances past them
+  static const uint64_t kDrawsPerBoid = 4;
+  CounterRandom random_;
+  uint64_t spawn_draw_ = 0;
+
+  WorldParameters parameters_;
+  //Prey and Predators each have one species, written by ApplyParameters
+  static const uint8_t kSpecies = 0;
+  FlockStateType boids_;
+  FlockStateType predators_;
+  std::vector<Obstacle> obstacles_;
+
+  //Frame N+1 motion written by a double buffered Update before being swapped in
+  bool double_buffered_ = false;
+  bool deterministic_ = false;
+  std::vector<VectorType> next_boid_positions_;
+  std::vector<VectorType> next_boid_velocities_;
+  std::vector<VectorType> next_predator_positions_;
+  std::vector<VectorType> next_predator_velocities_;
+
+  //Adaptive update schedule. A Boid is dead reckoned while its entry in
+  //quiet_until is greater than step_
+  size_t adaptive_interval_ = 1;
+  uint64_t step_ = 0;
+  std::vector<uint64_t> boid_quiet_until_;
+  std::vector<uint64_t> predator_quiet_until_;
+  //Parameters the schedule was made with
+  WorldParameters scheduled_parameters_;
+  size_t dead_reckoned_ = 0;
+
+  //Worker threads for parallel updates, null when updating on one thread
+  const size_t kChunkSize = 256;
+  std::unique_ptr<ThreadPool> thread_pool_;
+  std::vector<char> caught_;
+  CatchStats catch_stats_;
+
+  //Neighbor lookup grids, rebuilt at the start of every Update
+  SpatialGrid boid_grid_;
+  SpatialGrid predator_grid_;
+  //Obstacle lookup grid, rebuilt when the Obstacles change
+  SpatialGrid obstacle_grid_;
+};
+
+//3D double precision World used by the visualizer, snapshots and trajectories
+using World = BasicWorld<double, 3>;
+//2D single precision World, which moves a third of the bytes per Boid
+using World2f = BasicWorld<float, 2>;
+
+}  // namespace boidsimulation
@@ -6,6 +6,9 @@
 #include "cinder/params/Params.h"
 #include "environment.h"
 
+#include <string>
+#include <vector>
+
 namespace boidsimulation {
 
 namespace visualizer {
@@ -30,10 +33,35 @@ class BoidSimApp : public ci::app::App {
   const double kMargin = 75;
   const double kHistSizeX = 275;
   const double kHistSizeY = 125;
+  //Where the Save and Load Snapshot buttons write and read the simulation
+  const std::string kSnapshotPath = "boids.snapshot";
+  //Trajectory played back by the Replay button, as written by boid-sim-cli --record
+  const std::string kTrajectoryPath = "boids.trajectory";
+  //Frames the arrow keys move a replay by
+  const long kReplaySeekFrames = 30;
+  //Step rate of the simulation thread when it is switched on
+  const double kSimulationStepsPerSecond = 60;
+  //Where the Export Trace button writes the Chrome trace
+  const std::string kTracePath = "boids.trace.json";
+  //Profiler timers and counters shown in the panel, averaged over recent frames
+  const std::vector<std::string> kProfiledTimers = {
+      "Environment Update", "World Update", "Rules", "Obstacle Avoidance",
+      "Wall Bounding", "Catch Check", "Draw"};
+  const std::vector<std::string> kProfiledCounters = {
+      "Neighbor Candidates", "Neighbors Accepted", "Catch Candidates"};
 
  private:
+  /**
+   * Ends the Profiler's frame and refreshes the averages shown in the panel.
+   */
+  void UpdateProfileSummary();
+
   Environment environment_;
   ci::params::InterfaceGl ui;
+  //Shown by the UI, since the World may be on the simulation thread
+  bool double_buffered_ = false;
+  //Per frame averages of kProfiledTimers then kProfiledCounters
+  std::vector<float> profile_values_;
 };
 
 }  // namespace visualizer
@@ -1,9 +1,11 @@
 #pragma once
 
-#include <core/boid.h>
-#include <core/obstacle.h>
+#include <core/flock_geometry.h>
+#include <core/simulation_thread.h>
+#include <core/trajectory_player.h>
+#include <core/world.h>
 
-#include <vector>
+#include <string>
 
 #include "cinder/gl/gl.h"
 
@@ -13,7 +15,8 @@ namespace visualizer {
 
 /**
  * An Environment for Boids which will be displayed in the Cinder application
- * and respond to mouse events.
+ * and respond to mouse events. The simulation itself is a World; the
+ * Environment maps screen coordinates onto it and draws it.
  */
 class Environment {
   friend class BoidSimApp;
@@ -25,43 +28,38 @@ class Environment {
    * @param pixels_x The X length of the Environment measured in screen pixels.
    * @param pixels_y The Y length of the Environment measured in screen pixels.
    * @param boid_num The initial numbers of Boids.
-   * @param mass The mass of the Boids.
-   * @param size The size of the Boids.
+   * @param boid_speed The max speed of the Boids.
+   * @param boid_size The size of the Boids.
+   * @param pred_num The initial numbers of Predator Boids.
+   * @param pred_speed The max speed of the Predator Boids.
+   * @param pred_size The size of the Predator Boids.
    */
   Environment(const glm::vec2& top_left_corner, double pixels_x, double pixels_y,
               size_t boid_num = 50, double boid_speed = 8, double boid_size = 10,
               size_t pred_num = 6, double pred_speed = 5, double pred_size = 15);
 
   /**
-   * Initializes Boids in the Environment based on the constructor parameters.
-   * Helper function to the constructor.
-   * @param boid_num Number of regular boids to spawn.
-   * @param pred_num Number of predator boids to spawn.
-   */
-  void InitializeBoids(size_t boid_num, size_t pred_num);
-
-  /**
-   * Performs wall collisions and updates Boid velocities.
+   * Applies parameter changes and moves the World one step, or the replay one
+   * frame while replaying. While threaded, only passes changed parameters on to
+   * the simulation thread.
    */
   void Update();
 
   /**
-   * Checks if the current Boid is out of bounds and updates its
-   * velocity to return back in bounds. Helper function for Update method.
-   * @param current_boid The current Boid.
+   * Displays the current state of the Environment in the Cinder application
+   * with a single batched draw call. While threaded, draws the latest frame
+   * the simulation thread has finished.
    */
-  void WallBound(boidsimulation::Boid& current_boid);
-
-  /**
-   * Checks if the Predator Boids have caught any prey Boids and
-   * deletes Prey boids accordingly. Helper function for Update method.
-   */
-  void CheckPredatorCatch();
+  void Draw() const;
 
   /**
-   * Displays the current state of the Environment in the Cinder application.
+   * Moves stepping the World onto its own thread, decoupled from Update and
+   * Draw, or back onto the caller's. While threaded, every change to the
+   * World is posted to the simulation thread.
+   * @param steps_per_second Step rate of the simulation thread.
    */
-  void Draw() const;
+  void SetThreaded(bool threaded, double steps_per_second = 60);
+  bool IsThreaded() const;
 
   /**
    * Adds a Boid at the brush's location with a randomized velocity from
@@ -70,6 +68,13 @@ class Environment {
    */
   void AddBoid(const glm::vec2& brush_screen_coords);
 
+  /**
+   * Spawns count Boids of the current brush type in region, which is in
+   * screen coordinates. See World::SpawnBulk.
+   */
+  void SpawnBulk(size_t count, const SpawnRegion& region,
+                 SpawnDistribution distribution = SpawnDistribution::kUniform);
+
   /**
    * Adds an Obstacle at the click location.
    * @param brush_screen_coords
@@ -87,30 +92,73 @@ class Environment {
   void Clear();
 
   /**
-   * Returns a vector of the Boids in the tank.
+   * Writes the whole simulation to a snapshot file at path.
+   * @return False if the file could not be written.
    */
-  const std::vector<boidsimulation::Boid>& GetBoids() const;
+  bool SaveSnapshot(const std::string& path) const;
 
- private:
-  glm::vec2 top_left_corner_;
-  double spawn_margin = 10;
-  double pixels_x_;
-  double pixels_y_;
+  /**
+   * Replaces the simulation with the snapshot at path.
+   * @return False if the snapshot could not be loaded.
+   */
+  bool LoadSnapshot(const std::string& path);
 
-  bool spawn_predator_ = false;
+  /**
+   * Shows the trajectory at path instead of the World, which is paused until
+   * StopReplay. Each Update advances one recorded frame, looping at the end.
+   * @return False if the trajectory could not be opened.
+   */
+  bool StartReplay(const std::string& path);
+  void StopReplay();
+  bool IsReplaying() const;
 
-  std::vector<boidsimulation::Boid> boids_;
-  double boid_size_ = 10;
-  double boid_max_speed_ = 8;
-  double separation_ = 1, alignment_ = 1, cohesion_ = 1;
+  /**
+   * Moves the replay by frames, which may be negative, stopping at the first
+   * and last frames.
+   */
+  void SeekReplay(long frames);
+
+  /**
+   * Returns the World being displayed. Must not be used while threaded.
+   */
+  World& GetWorld();
+  const World& GetWorld() const;
+
+  /**
+   * Returns how many prey were caught in the last frame and in total. While
+   * threaded, these are from the latest finished frame.
+   */
+  const CatchStats& GetCatchStats() const;
 
-  std::vector<boidsimulation::Boid> predators_;
-  double pred_size_ = 15;
-  double pred_max_speed_ = 5;
-  double chase_ = 50;
+ private:
+  /**
+   * Builds the parameters of the World from the constructor arguments.
+   */
+  static WorldParameters MakeParameters(double boid_speed, double boid_size,
+                                        double pred_speed, double pred_size);
+
+  /**
+   * Uploads geometry into the GPU buffers and draws it.
+   */
+  void DrawGeometry(const FlockGeometry& geometry) const;
+
+  bool spawn_predator_ = false;
 
-  std::vector<boidsimulation::Obstacle> obstacles_;
-  double obstacle_size_ = 25;
+  World world_;
+  //Edited by the UI and copied into the World by Update, so the UI never
+  //writes to the World while the simulation thread reads it
+  WorldParameters parameters_;
+  //The parameters last posted to the simulation thread
+  WorldParameters posted_parameters_;
+  TrajectoryPlayer replay_;
+  //Destroyed before world_, which it steps
+  mutable SimulationThread simulation_;
+  double steps_per_second_ = 60;
+
+  //Reused every frame so drawing allocates nothing once the buffers fit
+  mutable FlockGeometry geometry_;
+  mutable ci::gl::VboMeshRef mesh_;
+  mutable ci::gl::BatchRef batch_;
 };
 
 }  // namespace visualizer
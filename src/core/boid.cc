@@ -1,134 +1,252 @@
 #include <core/boid.h>
+#include <core/profiler.h>
+#include <core/spatial_grid.h>
+#include <algorithm>
 #include <limits>
 
 namespace boidsimulation {
 
-void Boid::Update(std::vector<Boid>& flock, std::vector<Boid>& preds,
-                  std::vector<Obstacle>& obstacles) {
-  velocity_ += FlockingBehavior(flock, preds);
-  velocity_ += obstacle_scale_*AvoidObstacles(obstacles);
+namespace {
+
+/**
+ * Calls visit with the index of every Boid in flock that may lie within radius
+ * of position, in ascending order. Scans the whole flock when grid is null.
+ */
+template <typename BoidType, typename Visitor>
+void ForEachCandidate(const std::vector<BoidType>& flock, const SpatialGrid* grid,
+                      const typename BoidType::VectorType& position, double radius,
+                      Visitor visit) {
+  if(grid == nullptr) {
+    for(size_t boid_index = 0; boid_index < flock.size(); ++boid_index) {
+      visit(boid_index);
+    }
+    return;
+  }
+  grid->ForEachCandidate(position, radius, visit);
+}
+
+}  // namespace
+
+template <typename T, size_t N>
+void BasicBoid<T, N>::Update(std::vector<BasicBoid>& flock, std::vector<BasicBoid>& preds,
+                             std::vector<Obstacle>& obstacles,
+                             const SpatialGrid* flock_grid, const SpatialGrid* pred_grid,
+                             const SpatialGrid* obstacle_grid) {
+  velocity_ += FlockingBehavior(flock, preds, flock_grid, pred_grid);
+  velocity_ += obstacle_scale_*AvoidObstacles(obstacles, obstacle_grid);
   if(velocity_.Length() > max_speed_) {
     velocity_.ChangeMagnitude(max_speed_);
   }
   position_ += velocity_;
 }
 
-MathVector Boid::FlockingBehavior(std::vector<Boid>& flock, std::vector<Boid>& preds) {
-  MathVector flocking;
+template <typename T, size_t N>
+typename BasicBoid<T, N>::VectorType BasicBoid<T, N>::FlockingBehavior(
+    std::vector<BasicBoid>& flock, std::vector<BasicBoid>& preds,
+    const SpatialGrid* flock_grid, const SpatialGrid* pred_grid) {
+  BOIDSIMULATION_PROFILE_TIME("Rules");
+  VectorType flocking;
+  if(predator_) {
+    flocking += chase_scale_ * ClosestOpponentOffset(flock, flock_grid);
+    return flocking;
+  }
+
+  T separation_radius = T(2.5) * size_;
+  T separation_radius_sq = separation_radius * separation_radius;
+  T vision_sq = vision_ * vision_;
+  VectorType separation, heading, center;
+  size_t count = 0, candidates = 0;
+
+  const BasicBoid* boids = flock.data();
+  ForEachCandidate(flock, flock_grid, position_, std::max(separation_radius, vision_),
+                   [&](size_t boid_index) {
+    ++candidates;
+    const BasicBoid& other = boids[boid_index];
+    //Only calculating for same type of boid (predator/prey)
+    if(other.predator_) {
+      return;
+    }
+    VectorType difference = other.position_ - position_;
+    T distance_sq = difference.LengthSquared();
+    if(distance_sq <= 0) {
+      return;
+    }
+    if(distance_sq <= separation_radius_sq) {
+      separation -= difference;
+    }
+    if(distance_sq <= vision_sq) {
+      heading += other.velocity_;
+      center += other.position_;
+      ++count;
+    }
+  });
+  BOIDSIMULATION_PROFILE_COUNT("Neighbor Candidates", candidates);
+  BOIDSIMULATION_PROFILE_COUNT("Neighbors Accepted", count);
+
+  flocking += separation_scale_ * separation;
+  if(count > 0) {
+    heading /= count;
+    center /= count;
+    flocking += alignment_scale_ * ((heading - velocity_) / 4);
+    flocking += cohesion_scale_ * ((center - position_) / 35);
+  }
+  flocking -= (chase_scale_ * 2) * ClosestOpponentOffset(preds, pred_grid);
+  return flocking;
+}
+
+template <typename T, size_t N>
+typename BasicBoid<T, N>::VectorType BasicBoid<T, N>::FlockingBehaviorReference(
+    std::vector<BasicBoid>& flock, std::vector<BasicBoid>& preds,
+    const SpatialGrid* flock_grid, const SpatialGrid* pred_grid) {
+  VectorType flocking;
   if(!predator_) {
-    flocking += (separation_scale_ * Separation(flock));
-    flocking += (alignment_scale_ * Alignment(flock));
-    flocking += (cohesion_scale_ * Cohesion(flock));
-    flocking += (chase_scale_ * Chase(preds));
+    flocking += (separation_scale_ * Separation(flock, flock_grid));
+    flocking += (alignment_scale_ * Alignment(flock, flock_grid));
+    flocking += (cohesion_scale_ * Cohesion(flock, flock_grid));
+    flocking += (chase_scale_ * Chase(preds, pred_grid));
   } else {
-    flocking += (chase_scale_ * Chase(flock));
+    flocking += (chase_scale_ * Chase(flock, flock_grid));
   }
   return flocking;
 }
-MathVector Boid::Separation(std::vector<Boid>& flock) {
-  MathVector separation;
-  for(size_t boid_index = 0; boid_index < flock.size(); ++boid_index) {
+
+template <typename T, size_t N>
+typename BasicBoid<T, N>::VectorType BasicBoid<T, N>::ClosestOpponentOffset(
+    const std::vector<BasicBoid>& flock, const SpatialGrid* grid) const {
+  const BasicBoid* boids = flock.data();
+  const BasicBoid* closest = nullptr;
+  T closest_distance_sq = vision_ * vision_;
+  ForEachCandidate(flock, grid, position_, vision_, [&](size_t boid_index) {
+    const BasicBoid& other = boids[boid_index];
+    if(other.predator_ == predator_) {
+      return;
+    }
+    T distance_sq = other.position_.DistanceSquared(position_);
+    //Strictly closer so ties go to the lowest index, as in Chase
+    if(distance_sq > 0 && (distance_sq < closest_distance_sq ||
+        (closest == nullptr && distance_sq == closest_distance_sq))) {
+      closest_distance_sq = distance_sq;
+      closest = &other;
+    }
+  });
+  if(closest == nullptr) {
+    return VectorType();
+  }
+  return closest->position_ - position_;
+}
+template <typename T, size_t N>
+typename BasicBoid<T, N>::VectorType BasicBoid<T, N>::Separation(
+    std::vector<BasicBoid>& flock, const SpatialGrid* grid) {
+  VectorType separation;
+  T separation_radius = T(2.5) * size_;
+  ForEachCandidate(flock, grid, position_, separation_radius, [&](size_t boid_index) {
     //Only calculating for same type of boid (predator/prey)
-    if((!predator_ && !flock.at(boid_index).predator_) ||
-        (predator_ && flock.at(boid_index).predator_)) {
+    if((!predator_ && !flock[boid_index].predator_) ||
+        (predator_ && flock[boid_index].predator_)) {
       //checking if other Boid is visible to current Boid
-      double distance = position_.Distance(flock.at(boid_index).position_);
-      if(distance > 0 && distance <= 2.5 * size_) {
-        MathVector difference = flock.at(boid_index).position_ - position_;
+      T distance = position_.Distance(flock[boid_index].position_);
+      if(distance > 0 && distance <= separation_radius) {
+        VectorType difference = flock[boid_index].position_ - position_;
         separation -= difference;
       }
     }
-  }
+  });
   return separation;
 }
-MathVector Boid::Alignment(std::vector<Boid>& flock) {
-  MathVector heading;
+template <typename T, size_t N>
+typename BasicBoid<T, N>::VectorType BasicBoid<T, N>::Alignment(
+    std::vector<BasicBoid>& flock, const SpatialGrid* grid) {
+  VectorType heading;
   size_t count = 0;
-  for(size_t boid_index = 0; boid_index < flock.size(); ++boid_index) {
+  ForEachCandidate(flock, grid, position_, vision_, [&](size_t boid_index) {
     //Only calculating for same type of boid (predator/prey)
-    if((!predator_ && !flock.at(boid_index).predator_) ||
-       (predator_ && flock.at(boid_index).predator_)) {
+    if((!predator_ && !flock[boid_index].predator_) ||
+       (predator_ && flock[boid_index].predator_)) {
       //checking if other Boid is visible to current Boid
-      double distance = position_.Distance(flock.at(boid_index).position_);
+      T distance = position_.Distance(flock[boid_index].position_);
       if(distance > 0 && distance <= vision_) {
-        heading += flock.at(boid_index).velocity_;
+        heading += flock[boid_index].velocity_;
         ++count;
       }
     }
-  }
+  });
   //calculating average heading of flock
   if (count > 0) {
     heading /= count;
     //vector pointing from velocity to avg heading of visible flock
-    MathVector alignment_force = (heading - velocity_) / 4;
+    VectorType alignment_force = (heading - velocity_) / 4;
     return alignment_force;
   } else {
     return heading;
   }
 }
-MathVector Boid::Cohesion(std::vector<Boid>& flock) {
-  MathVector center;
-  double count = 0;
-  for(size_t boid_index = 0; boid_index < flock.size(); ++boid_index) {
+template <typename T, size_t N>
+typename BasicBoid<T, N>::VectorType BasicBoid<T, N>::Cohesion(
+    std::vector<BasicBoid>& flock, const SpatialGrid* grid) {
+  VectorType center;
+  T count = 0;
+  ForEachCandidate(flock, grid, position_, vision_, [&](size_t boid_index) {
     //Only calculating for same type of boid (predator/prey)
-    if((!predator_ && !flock.at(boid_index).predator_) ||
-       (predator_ && flock.at(boid_index).predator_)) {
+    if((!predator_ && !flock[boid_index].predator_) ||
+       (predator_ && flock[boid_index].predator_)) {
       //checking if other Boid is visible to current Boid
-      double distance = position_.Distance(flock.at(boid_index).position_);
+      T distance = position_.Distance(flock[boid_index].position_);
       if(distance > 0 && distance <= vision_) {
-        center += flock.at(boid_index).position_;
+        center += flock[boid_index].position_;
         ++count;
       }
     }
-  }
+  });
   //calculating average position of flock
   if(count > 0) {
     center /= count;
     //vector pointing from position to center of visible flock
-    MathVector cohesion_force = (center - position_) / 35;
+    VectorType cohesion_force = (center - position_) / 35;
     return cohesion_force;
   } else {
     return center;
   }
 }
-MathVector Boid::Chase(std::vector<Boid>& flock) {
-  MathVector chase;
+template <typename T, size_t N>
+typename BasicBoid<T, N>::VectorType BasicBoid<T, N>::Chase(
+    std::vector<BasicBoid>& flock, const SpatialGrid* grid) {
+  VectorType chase;
   if(!predator_) {
     //Flees from closest Predator boid
-    size_t chase_index = -1;
-    double closest_distance = std::numeric_limits<double>::max();
-    for(size_t boid_index = 0; boid_index < flock.size(); ++boid_index) {
+    size_t chase_index = flock.size();
+    T closest_distance = std::numeric_limits<T>::max();
+    ForEachCandidate(flock, grid, position_, vision_, [&](size_t boid_index) {
       //checking if Predator Boid is visible to current Boid and is the closest to it
-      double distance = position_.Distance(flock.at(boid_index).position_);
-      if(distance > 0 && distance <= vision_ && flock.at(boid_index).predator_
+      T distance = position_.Distance(flock[boid_index].position_);
+      if(distance > 0 && distance <= vision_ && flock[boid_index].predator_
           && distance < closest_distance) {
         closest_distance = distance;
         chase_index = boid_index;
       }
-    }
+    });
 
-    if(chase_index != -1) {
-      MathVector difference = flock.at(chase_index).position_ - position_;
+    if(chase_index != flock.size()) {
+      VectorType difference = flock.at(chase_index).position_ - position_;
       chase -= 2*difference;
     }
   }
 
   if(predator_) {
     //Chooses one prey boid to chase
-    size_t chase_index = -1;
-    double closest_distance = std::numeric_limits<double>::max();
-    for(size_t boid_index = 0; boid_index < flock.size(); ++boid_index) {
+    size_t chase_index = flock.size();
+    T closest_distance = std::numeric_limits<T>::max();
+    ForEachCandidate(flock, grid, position_, vision_, [&](size_t boid_index) {
       //checking if prey Boid is visible to current Boid and is the closest to it
-      double distance = position_.Distance(flock.at(boid_index).position_);
-      if(distance > 0 && distance <= vision_ && !flock.at(boid_index).predator_
+      T distance = position_.Distance(flock[boid_index].position_);
+      if(distance > 0 && distance <= vision_ && !flock[boid_index].predator_
           && distance < closest_distance) {
         closest_distance = distance;
         chase_index = boid_index;
       }
-    }
+    });
 
-    if(chase_index != -1) {
-      MathVector difference = flock.at(chase_index).position_ - position_;
+    if(chase_index != flock.size()) {
+      VectorType difference = flock.at(chase_index).position_ - position_;
       chase += difference;
     }
   }
@@ -138,117 +256,140 @@ MathVector Boid::Chase(std::vector<Boid>& flock) {
 /* Code based on mathematical formulas provided in Potential Collision Detection
  * Procedure given on this website:
  * http://www2.cs.uregina.ca/~anima/408/Notes/ControllingGroups/Flocking.htm */
-MathVector Boid::AvoidObstacles(std::vector<Obstacle>& obstacles) {
-  MathVector avoidance;
-  for(auto& obstacle : obstacles) {
+template <typename T, size_t N>
+typename BasicBoid<T, N>::VectorType BasicBoid<T, N>::AvoidObstacles(
+    std::vector<Obstacle>& obstacles, const SpatialGrid* grid) {
+  VectorType avoidance;
+  T speed_sq = velocity_.LengthSquared(); // |V|^2
+  if(speed_sq <= 0) {
+    return avoidance;
+  }
+
+  auto avoid = [&](size_t obstacle_index) {
+    const Obstacle& obstacle = obstacles[obstacle_index];
     //Checking if Boid will collide
-    MathVector difference = obstacle.GetPosition() - position_; // C-P
-    double s = difference.Length(); // |C-P|
-    double k = (difference * velocity_) / velocity_.Length(); // (C-P) * V/|V|
-    double t = sqrt(pow(s,2) - pow(k,2)); // (s^2 - k^2)^1/2
-    double r = obstacle.GetSize() + size_;
-    bool will_collide = t < r; // if t < r, will collide
+    VectorType obstacle_position(obstacle.GetPosition());
+    VectorType difference = obstacle_position - position_; // C-P
+    T s_sq = difference.LengthSquared(); // |C-P|^2
+    T k = difference * velocity_; // (C-P) * V
+    T r = T(obstacle.GetSize()) + size_;
+    //t^2 = s^2 - (k/|V|)^2 < r^2, multiplied through by |V|^2
+    bool will_collide = (s_sq - r * r) * speed_sq < k * k;
 
     if(will_collide) {
-      MathVector force_away = obstacle.GetPosition() - (velocity_ + position_);
-      force_away /= (pow(difference.Length(),1.35) + 1);
+      VectorType force_away = obstacle_position - (velocity_ + position_);
+      force_away /= T(AvoidanceFalloff(std::sqrt(s_sq)));
       avoidance -= force_away;
     }
+  };
+  if(grid == nullptr) {
+    for(size_t obstacle_index = 0; obstacle_index < obstacles.size(); ++obstacle_index) {
+      avoid(obstacle_index);
+    }
+  } else {
+    grid->ForEachOnLine(position_, velocity_, size_, avoid);
   }
   return avoidance;
 }
 
-void Boid::WallCollide(int axis) {
-  if(axis == 0) {
-    velocity_.x_ = -velocity_.x_;
-  } else if (axis == 1) {
-    velocity_.y_ = -velocity_.y_;
-  } else if (axis == 2) {
-    velocity_.z_ = -velocity_.z_;
+template <typename T, size_t N>
+void BasicBoid<T, N>::WallCollide(int axis) {
+  if(axis >= 0 && (size_t)axis < N) {
+    velocity_[axis] = -velocity_[axis];
   }
 }
 
-void Boid::Draw() const {
-  ci::gl::color(color_);
-
-  //Creating triangle for current boid
-  ci::PolyLine2f triangle;
-
-  //Vertex that points in the direction the boid is moving.
-  MathVector velocity_direction = velocity_ / velocity_.Length();
-  MathVector to_vertex = size_ * velocity_direction;
-  MathVector head = position_ + 1.5 * to_vertex;
-  triangle.push_back(glm::vec2(head.x_, head.y_));
-
-  //Rotate to_vertex clockwise and counterclockwise to get other two vertices
-  MathVector left_tail = position_ + 0.75 * MathVector(to_vertex.y_, -to_vertex.x_, position_.z_);
-  MathVector right_tail = position_ + 0.75 * MathVector(-to_vertex.y_, to_vertex.x_, position_.z_);
-  triangle.push_back(glm::vec2(left_tail.x_, left_tail.y_));
-  triangle.push_back(glm::vec2(right_tail.x_, right_tail.y_));
-
-  triangle.push_back(glm::vec2(head.x_, head.y_));
-
-  ci::gl::drawSolid(triangle);
-}
-
 //Getters & Setters
-const MathVector& Boid::GetPosition() const {
+template <typename T, size_t N>
+const typename BasicBoid<T, N>::VectorType& BasicBoid<T, N>::GetPosition() const {
   return position_;
 }
-const MathVector& Boid::GetVelocity() const {
+template <typename T, size_t N>
+const typename BasicBoid<T, N>::VectorType& BasicBoid<T, N>::GetVelocity() const {
   return velocity_;
 }
-void Boid::SetVelocity(MathVector& velocity) {
+template <typename T, size_t N>
+void BasicBoid<T, N>::SetVelocity(const VectorType& velocity) {
   velocity_ = velocity;
 }
-void Boid::SetVelocity(double x, double y, double z) {
-  velocity_ = MathVector(x,y,z);
+template <typename T, size_t N>
+void BasicBoid<T, N>::SetVelocity(T x, T y, T z) {
+  velocity_ = VectorType(BasicVector<T, 3>(x,y,z));
 }
 
-double Boid::GetSize() const {
+template <typename T, size_t N>
+T BasicBoid<T, N>::GetSize() const {
   return size_;
 }
-void Boid::SetSize(double size) {
+template <typename T, size_t N>
+void BasicBoid<T, N>::SetSize(T size) {
   size_ = size;
 }
-const ci::Color8u& Boid::GetColor() const {
+template <typename T, size_t N>
+T BasicBoid<T, N>::GetVision() const {
+  return vision_;
+}
+template <typename T, size_t N>
+const Color& BasicBoid<T, N>::GetColor() const {
   return color_;
 }
-const bool Boid::IsPredator() const {
+template <typename T, size_t N>
+const bool BasicBoid<T, N>::IsPredator() const {
   return predator_;
 }
 
-double Boid::GetSeparationScale() const {
+template <typename T, size_t N>
+T BasicBoid<T, N>::GetSeparationScale() const {
   return separation_scale_;
 }
-double Boid::GetAlignmentScale() const {
+template <typename T, size_t N>
+T BasicBoid<T, N>::GetAlignmentScale() const {
   return alignment_scale_;
 }
-double Boid::GetCohesionScale() const {
+template <typename T, size_t N>
+T BasicBoid<T, N>::GetCohesionScale() const {
   return cohesion_scale_;
 }
-double Boid::GetChaseScale() const {
+template <typename T, size_t N>
+T BasicBoid<T, N>::GetChaseScale() const {
   return chase_scale_;
 }
-void Boid::SetSeparationScale(double separation_scale) {
+template <typename T, size_t N>
+void BasicBoid<T, N>::SetSeparationScale(T separation_scale) {
   separation_scale_ = separation_scale;
 }
-void Boid::SetAlignmentScale(double alignment_scale) {
+template <typename T, size_t N>
+void BasicBoid<T, N>::SetAlignmentScale(T alignment_scale) {
   alignment_scale_ = alignment_scale;
 }
-void Boid::SetCohesionScale(double cohesion_scale) {
+template <typename T, size_t N>
+void BasicBoid<T, N>::SetCohesionScale(T cohesion_scale) {
   cohesion_scale_ = cohesion_scale;
 }
-void Boid::SetChaseScale(double chase_scale) {
+template <typename T, size_t N>
+void BasicBoid<T, N>::SetChaseScale(T chase_scale) {
   chase_scale_ = chase_scale;
 }
+template <typename T, size_t N>
+T BasicBoid<T, N>::GetObstacleScale() const {
+  return obstacle_scale_;
+}
+template <typename T, size_t N>
+void BasicBoid<T, N>::SetObstacleScale(T obstacle_scale) {
+  obstacle_scale_ = obstacle_scale;
+}
 
-double Boid::GetMaxSpeed() const {
+template <typename T, size_t N>
+T BasicBoid<T, N>::GetMaxSpeed() const {
   return max_speed_;
 }
-void Boid::SetMaxSpeed(double max_speed) {
+template <typename T, size_t N>
+void BasicBoid<T, N>::SetMaxSpeed(T max_speed) {
   max_speed_ = max_speed;
 }
 
+template class BasicBoid<double, 3>;
+template class BasicBoid<float, 2>;
+
 }  // namespace idealgas
 
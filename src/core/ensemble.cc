@@ -0,0 +1,73 @@
+#include <core/ensemble.h>
+#include <core/profiler.h>
+
+#include <atomic>
+#include <chrono>
+
+namespace boidsimulation {
+
+Ensemble::Ensemble(double width, double height, size_t thread_count) :
+      width_(width), height_(height) {
+  if(thread_count != 1) {
+    thread_pool_.reset(new ThreadPool(thread_count));
+  }
+}
+
+size_t Ensemble::AddWorld(const EnsembleMember& member) {
+  worlds_.emplace_back(new World(0, 0, width_, height_, member.boid_num, member.pred_num,
+                                 member.parameters, member.seed));
+  return worlds_.size() - 1;
+}
+
+void Ensemble::Step(size_t steps) {
+  BOIDSIMULATION_PROFILE_SCOPE("Ensemble Step");
+  std::atomic<uint64_t> boid_updates(0);
+  auto task = [&](size_t begin, size_t end) {
+    uint64_t task_updates = 0;
+    for(size_t index = begin; index < end; ++index) {
+      World& world = *worlds_[index];
+      for(size_t step = 0; step < steps; ++step) {
+        task_updates += world.GetBoids().Size() + world.GetPredators().Size();
+        world.Update();
+      }
+    }
+    boid_updates += task_updates;
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  if(thread_pool_) {
+    //One World per chunk, so threads that draw quick Worlds take more of them
+    thread_pool_->ParallelFor(worlds_.size(), 1, task);
+  } else {
+    task(0, worlds_.size());
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  stats_.world_steps += worlds_.size() * steps;
+  stats_.boid_updates += boid_updates;
+  stats_.seconds += elapsed.count();
+}
+
+size_t Ensemble::Size() const {
+  return worlds_.size();
+}
+
+World& Ensemble::GetWorld(size_t index) {
+  return *worlds_[index];
+}
+const World& Ensemble::GetWorld(size_t index) const {
+  return *worlds_[index];
+}
+
+const EnsembleStats& Ensemble::GetStats() const {
+  return stats_;
+}
+void Ensemble::ResetStats() {
+  stats_ = EnsembleStats();
+}
+
+size_t Ensemble::GetThreadCount() const {
+  return thread_pool_ ? thread_pool_->GetThreadCount() : 1;
+}
+
+}  // namespace boidsimulation
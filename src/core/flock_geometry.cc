@@ -0,0 +1,105 @@
+#include <core/flock_geometry.h>
+
+#include <cmath>
+
+namespace boidsimulation {
+
+namespace {
+
+/**
+ * Converts an 8 bit Color to a VertexColor.
+ */
+FlockGeometry::VertexColor ToVertexColor(const Color& color) {
+  return FlockGeometry::VertexColor(color.r_ / 255.0f, color.g_ / 255.0f, color.b_ / 255.0f);
+}
+
+/**
+ * Points on the unit circle at the edges of each Obstacle segment, with the
+ * first point repeated at the end.
+ */
+const std::vector<Vector2f>& UnitCircle() {
+  static const std::vector<Vector2f> circle = [] {
+    std::vector<Vector2f> points;
+    const double kTau = 6.283185307179586;
+    for(size_t segment = 0; segment <= FlockGeometry::kCircleSegments; ++segment) {
+      double angle = kTau * segment / FlockGeometry::kCircleSegments;
+      points.push_back(Vector2f((float)std::cos(angle), (float)std::sin(angle)));
+    }
+    return points;
+  }();
+  return circle;
+}
+
+}  // namespace
+
+void FlockGeometry::Clear() {
+  vertex_count_ = 0;
+}
+
+size_t FlockGeometry::Reserve(size_t vertices) {
+  size_t first = vertex_count_;
+  vertex_count_ += vertices;
+  if(positions_.size() < vertex_count_) {
+    positions_.resize(vertex_count_);
+    colors_.resize(vertex_count_);
+  }
+  return first;
+}
+
+void FlockGeometry::AddFlock(const FlockState& flock) {
+  size_t vertex = Reserve(3 * flock.Size());
+  for(size_t index = 0; index < flock.Size(); ++index) {
+    const MathVector& position = flock.positions_[index];
+    const MathVector& velocity = flock.velocities_[index];
+    const Species& species = flock.SpeciesOf(index);
+
+    //Vertex that points in the direction the boid is moving. A still Boid
+    //has no direction and collapses to a point.
+    MathVector to_vertex = species.size * (velocity / velocity.Length());
+    MathVector head = position + 1.5 * to_vertex;
+    //Rotate to_vertex clockwise and counterclockwise to get other two vertices
+    MathVector perpendicular(to_vertex.y_, -to_vertex.x_, 0);
+    MathVector left_tail = position + 0.75 * perpendicular;
+    MathVector right_tail = position - 0.75 * perpendicular;
+
+    VertexColor color = ToVertexColor(species.color);
+    positions_[vertex] = Vector2f(head);
+    positions_[vertex + 1] = Vector2f(left_tail);
+    positions_[vertex + 2] = Vector2f(right_tail);
+    colors_[vertex] = colors_[vertex + 1] = colors_[vertex + 2] = color;
+    vertex += 3;
+  }
+}
+
+void FlockGeometry::AddObstacles(const std::vector<Obstacle>& obstacles) {
+  const std::vector<Vector2f>& circle = UnitCircle();
+  size_t vertex = Reserve(3 * kCircleSegments * obstacles.size());
+  for(auto& obstacle : obstacles) {
+    Vector2f center(obstacle.GetPosition());
+    float radius = (float)obstacle.GetSize();
+    VertexColor color = ToVertexColor(obstacle.GetColor());
+    for(size_t segment = 0; segment < kCircleSegments; ++segment) {
+      positions_[vertex] = center;
+      positions_[vertex + 1] = center + radius * circle[segment];
+      positions_[vertex + 2] = center + radius * circle[segment + 1];
+      colors_[vertex] = colors_[vertex + 1] = colors_[vertex + 2] = color;
+      vertex += 3;
+    }
+  }
+}
+
+size_t FlockGeometry::GetVertexCount() const {
+  return vertex_count_;
+}
+size_t FlockGeometry::GetTriangleCount() const {
+  return vertex_count_ / 3;
+}
+
+const std::vector<Vector2f>& FlockGeometry::GetPositions() const {
+  return positions_;
+}
+const std::vector<FlockGeometry::VertexColor>& FlockGeometry::GetColors() const {
+  return colors_;
+}
+
+}  // namespace boidsimulation
@@ -0,0 +1,339 @@
+#include <core/flock_state.h>
+#include <core/profiler.h>
+#include <core/spatial_grid.h>
+#include <algorithm>
+
+namespace boidsimulation {
+
+namespace {
+
+/**
+ * @return The tunables of boid.
+ */
+template <typename T, size_t N>
+BasicSpecies<T> BoidSpecies(const BasicBoid<T, N>& boid) {
+  BasicSpecies<T> species;
+  species.size = boid.GetSize();
+  species.vision = boid.GetVision();
+  species.max_speed = boid.GetMaxSpeed();
+  species.separation_scale = boid.GetSeparationScale();
+  species.alignment_scale = boid.GetAlignmentScale();
+  species.cohesion_scale = boid.GetCohesionScale();
+  species.chase_scale = boid.GetChaseScale();
+  species.obstacle_scale = boid.GetObstacleScale();
+  species.color = boid.GetColor();
+  species.predator = boid.IsPredator();
+  return species;
+}
+
+/**
+ * @return Whether every species in table is of the given type, so its Boids
+ * need no type check each.
+ */
+template <typename T>
+bool AllOfType(const std::vector<BasicSpecies<T>>& table, bool predator) {
+  return std::all_of(table.begin(), table.end(), [&](const BasicSpecies<T>& species) {
+    return species.predator == predator;
+  });
+}
+
+/**
+ * Removes the elements of values whose entry in marked is true, keeping order.
+ */
+template <typename Value>
+void Compact(std::vector<Value>& values, const std::vector<char>& marked) {
+  size_t kept = 0;
+  for(size_t index = 0; index < values.size(); ++index) {
+    if(!marked[index]) {
+      if(kept != index) {
+        values[kept] = values[index];
+      }
+      ++kept;
+    }
+  }
+  values.resize(kept);
+}
+
+}  // namespace
+
+template <typename T, size_t N>
+bool BasicFlockState<T, N>::Add(const BoidType& boid) {
+  return Add(boid, 1);
+}
+
+template <typename T, size_t N>
+bool BasicFlockState<T, N>::Add(const BoidType& boid, size_t count) {
+  uint8_t species;
+  if(!AddSpecies(BoidSpecies(boid), species)) {
+    return false;
+  }
+  Add(boid.GetPosition(), boid.GetVelocity(), species, count);
+  return true;
+}
+
+template <typename T, size_t N>
+void BasicFlockState<T, N>::Add(const VectorType& position, const VectorType& velocity,
+                                uint8_t species, size_t count) {
+  positions_.insert(positions_.end(), count, position);
+  velocities_.insert(velocities_.end(), count, velocity);
+  species_.insert(species_.end(), count, species);
+  packed_build_id_ = 0;
+}
+
+template <typename T, size_t N>
+bool BasicFlockState<T, N>::AddSpecies(const SpeciesType& species, uint8_t& index) {
+  for(size_t existing = 0; existing < species_table_.size(); ++existing) {
+    if(species_table_[existing] == species) {
+      index = (uint8_t)existing;
+      return true;
+    }
+  }
+  if(species_table_.size() == kMaxSpecies) {
+    return false;
+  }
+  species_table_.push_back(species);
+  index = (uint8_t)(species_table_.size() - 1);
+  return true;
+}
+
+template <typename T, size_t N>
+void BasicFlockState<T, N>::SetSpecies(uint8_t index, const SpeciesType& species) {
+  if(species_table_.size() <= index) {
+    species_table_.resize(index + 1);
+  }
+  species_table_[index] = species;
+}
+
+template <typename T, size_t N>
+typename BasicFlockState<T, N>::BoidType BasicFlockState<T, N>::GetBoid(size_t index) const {
+  const SpeciesType& species = SpeciesOf(index);
+  BoidType boid(positions_[index], velocities_[index], species.size, species.vision,
+                species.max_speed, species.predator, species.color);
+  boid.SetSeparationScale(species.separation_scale);
+  boid.SetAlignmentScale(species.alignment_scale);
+  boid.SetCohesionScale(species.cohesion_scale);
+  boid.SetChaseScale(species.chase_scale);
+  boid.SetObstacleScale(species.obstacle_scale);
+  return boid;
+}
+
+template <typename T, size_t N>
+void BasicFlockState<T, N>::RemoveMarked(const std::vector<char>& marked) {
+  Compact(positions_, marked);
+  Compact(velocities_, marked);
+  Compact(species_, marked);
+  packed_build_id_ = 0;
+}
+
+template <typename T, size_t N>
+void BasicFlockState<T, N>::Reserve(size_t capacity) {
+  positions_.reserve(capacity);
+  velocities_.reserve(capacity);
+  species_.reserve(capacity);
+}
+
+template <typename T, size_t N>
+void BasicFlockState<T, N>::Clear() {
+  positions_.clear();
+  velocities_.clear();
+  species_.clear();
+  packed_build_id_ = 0;
+}
+
+template <typename T, size_t N>
+void BasicFlockState<T, N>::SetSimdLevel(SimdLevel level) {
+  simd_level_ = level;
+  neighbor_kernel_ = GetNeighborKernel<T, N>(level);
+}
+template <typename T, size_t N>
+SimdLevel BasicFlockState<T, N>::GetSimdLevel() const {
+  return simd_level_;
+}
+
+template <typename T, size_t N>
+void BasicFlockState<T, N>::PackByCell(const SpatialGrid& grid) {
+  packed_build_id_ = 0;
+  const std::vector<size_t>& order = grid.GetCellOrder();
+  if(simd_level_ == SimdLevel::kScalar || order.size() != Size()) {
+    return;
+  }
+  for(size_t axis = 0; axis < N; ++axis) {
+    cell_neighbors_.positions_[axis].resize(order.size());
+    cell_neighbors_.velocities_[axis].resize(order.size());
+  }
+  for(size_t entry = 0; entry < order.size(); ++entry) {
+    const VectorType& position = positions_[order[entry]];
+    const VectorType& velocity = velocities_[order[entry]];
+    for(size_t axis = 0; axis < N; ++axis) {
+      cell_neighbors_.positions_[axis][entry] = position.Component(axis);
+      cell_neighbors_.velocities_[axis][entry] = velocity.Component(axis);
+    }
+  }
+  packed_build_id_ = grid.GetBuildId();
+}
+
+template <typename T, size_t N>
+size_t BasicFlockState<T, N>::Size() const {
+  return positions_.size();
+}
+template <typename T, size_t N>
+bool BasicFlockState<T, N>::Empty() const {
+  return positions_.empty();
+}
+
+template <typename T, size_t N>
+typename BasicFlockState<T, N>::VectorType BasicFlockState<T, N>::FlockingBehavior(
+    size_t index, const BasicFlockState& opponents, const SpatialGrid& grid,
+    const SpatialGrid& opponent_grid) const {
+  VectorType flocking;
+  const SpeciesType& species = SpeciesOf(index);
+  bool predator = species.predator;
+  if(predator) {
+    flocking += species.chase_scale * ClosestOpponentOffset(index, opponents, opponent_grid);
+    return flocking;
+  }
+
+  const VectorType& position = positions_[index];
+  const VectorType* positions = positions_.data();
+  const VectorType* velocities = velocities_.data();
+  const uint8_t* species_indices = species_.data();
+  const SpeciesType* species_table = species_table_.data();
+  T separation_radius = T(2.5) * species.size;
+  T vision = species.vision;
+  bool same_type = AllOfType(species_table_, predator);
+
+  NeighborSums<T, N> sums;
+  T radius = std::max(separation_radius, vision);
+  T separation_radius_sq = separation_radius * separation_radius;
+  T vision_sq = vision * vision;
+  size_t candidates = 0;
+  if(same_type && simd_level_ != SimdLevel::kScalar && packed_build_id_ != 0 &&
+     packed_build_id_ == grid.GetBuildId()) {
+    //Every candidate is a flockmate, so each row of cells is read in place
+    grid.ForEachCandidateRun(position, radius, [&](size_t begin, size_t end) {
+      candidates += end - begin;
+      neighbor_kernel_(cell_neighbors_.Range(begin, end), position, separation_radius_sq,
+                       vision_sq, sums);
+    });
+  } else {
+    //Pack flockmates of the same type (predator/prey) for the vectorized kernel
+    thread_local NeighborBatch<T, N> batch;
+    batch.Clear();
+    grid.ForEachCandidate(position, radius, [&](size_t boid_index) {
+      ++candidates;
+      if(same_type || species_table[species_indices[boid_index]].predator == predator) {
+        batch.Add(positions[boid_index], velocities[boid_index]);
+      }
+    });
+    neighbor_kernel_(batch.Range(), position, separation_radius_sq, vision_sq, sums);
+  }
+  BOIDSIMULATION_PROFILE_COUNT("Neighbor Candidates", candidates);
+  BOIDSIMULATION_PROFILE_COUNT("Neighbors Accepted", sums.count);
+
+  flocking += species.separation_scale * sums.separation;
+  if(sums.count > 0) {
+    VectorType heading = sums.heading / sums.count;
+    VectorType center = sums.center / sums.count;
+    flocking += species.alignment_scale * ((heading - velocities_[index]) / 4);
+    flocking += species.cohesion_scale * ((center - position) / 35);
+  }
+  flocking -= (species.chase_scale * 2) *
+              ClosestOpponentOffset(index, opponents, opponent_grid);
+  return flocking;
+}
+
+template <typename T, size_t N>
+typename BasicFlockState<T, N>::VectorType BasicFlockState<T, N>::ClosestOpponentOffset(
+    size_t index, const BasicFlockState& flock, const SpatialGrid& grid) const {
+  const VectorType& position = positions_[index];
+  const VectorType* positions = flock.positions_.data();
+  const uint8_t* species_indices = flock.species_.data();
+  const SpeciesType* species_table = flock.species_table_.data();
+  const SpeciesType& species = SpeciesOf(index);
+  bool predator = species.predator;
+  T vision = species.vision;
+  bool opponents_only = AllOfType(flock.species_table_, !predator);
+
+  size_t closest = flock.Size();
+  T closest_distance_sq = vision * vision;
+  grid.ForEachCandidate(position, vision, [&](size_t boid_index) {
+    if(!opponents_only && species_table[species_indices[boid_index]].predator == predator) {
+      return;
+    }
+    T distance_sq = positions[boid_index].DistanceSquared(position);
+    //Strictly closer so ties go to the lowest index, as in Boid::Chase
+    if(distance_sq > 0 && (distance_sq < closest_distance_sq ||
+        (closest == flock.Size() && distance_sq == closest_distance_sq))) {
+      closest_distance_sq = distance_sq;
+      closest = boid_index;
+    }
+  });
+  if(closest == flock.Size()) {
+    return VectorType();
+  }
+  return positions[closest] - position;
+}
+
+/* Same Potential Collision Detection Procedure as Boid::AvoidObstacles:
+ * http://www2.cs.uregina.ca/~anima/408/Notes/ControllingGroups/Flocking.htm */
+template <typename T, size_t N>
+typename BasicFlockState<T, N>::VectorType BasicFlockState<T, N>::AvoidObstacles(
+    size_t index, const VectorType& velocity, const std::vector<Obstacle>& obstacles,
+    const SpatialGrid& obstacle_grid) const {
+  VectorType avoidance;
+  T speed_sq = velocity.LengthSquared(); // |V|^2
+  if(speed_sq <= 0) {
+    return avoidance;
+  }
+
+  const VectorType& position = positions_[index];
+  T size = SpeciesOf(index).size;
+  obstacle_grid.ForEachOnLine(position, velocity, size, [&](size_t obstacle_index) {
+    const Obstacle& obstacle = obstacles[obstacle_index];
+    //Checking if Boid will collide
+    VectorType obstacle_position(obstacle.GetPosition());
+    VectorType difference = obstacle_position - position; // C-P
+    T s_sq = difference.LengthSquared(); // |C-P|^2
+    T k = difference * velocity; // (C-P) * V
+    T r = T(obstacle.GetSize()) + size;
+    //t^2 = s^2 - (k/|V|)^2 < r^2, multiplied through by |V|^2
+    bool will_collide = (s_sq - r * r) * speed_sq < k * k;
+
+    if(will_collide) {
+      VectorType force_away = obstacle_position - (velocity + position);
+      force_away /= T(AvoidanceFalloff(std::sqrt(s_sq)));
+      avoidance -= force_away;
+    }
+  });
+  return avoidance;
+}
+
+template <typename T, size_t N>
+void BasicFlockState<T, N>::UpdateBoid(size_t index, const BasicFlockState& opponents,
+                                        const std::vector<Obstacle>& obstacles,
+                                        const SpatialGrid& obstacle_grid,
+                                        const SpatialGrid& grid,
+                                        const SpatialGrid& opponent_grid,
+                                        VectorType& next_position,
+                                        VectorType& next_velocity) const {
+  const SpeciesType& species = SpeciesOf(index);
+  VectorType velocity = velocities_[index];
+  {
+    BOIDSIMULATION_PROFILE_TIME("Rules");
+    velocity += FlockingBehavior(index, opponents, grid, opponent_grid);
+  }
+  {
+    BOIDSIMULATION_PROFILE_TIME("Obstacle Avoidance");
+    velocity += species.obstacle_scale * AvoidObstacles(index, velocity, obstacles, obstacle_grid);
+  }
+  if(velocity.Length() > species.max_speed) {
+    velocity.ChangeMagnitude(species.max_speed);
+  }
+  next_position = positions_[index] + velocity;
+  next_velocity = velocity;
+}
+
+template class BasicFlockState<double, 3>;
+template class BasicFlockState<float, 2>;
+
+}  // namespace boidsimulation
@@ -0,0 +1,92 @@
+#include <core/mapped_file.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BOIDSIMULATION_HAS_MMAP 1
+#endif
+
+namespace boidsimulation {
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+#ifdef BOIDSIMULATION_HAS_MMAP
+
+bool MappedFile::OpenRead(const std::string& path) {
+  Close();
+  fd_ = open(path.c_str(), O_RDONLY);
+  struct stat status;
+  if(fd_ < 0 || fstat(fd_, &status) != 0 || status.st_size <= 0) {
+    Close();
+    return false;
+  }
+  return Map((size_t)status.st_size, false);
+}
+
+bool MappedFile::Create(const std::string& path, size_t size) {
+  Close();
+  fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if(fd_ < 0 || size == 0 || ftruncate(fd_, (off_t)size) != 0) {
+    Close();
+    return false;
+  }
+  return Map(size, true);
+}
+
+bool MappedFile::Map(size_t size, bool writable) {
+  void* data = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                    MAP_SHARED, fd_, 0);
+  if(data == MAP_FAILED) {
+    Close();
+    return false;
+  }
+  data_ = static_cast<uint8_t*>(data);
+  size_ = size;
+  return true;
+}
+
+void MappedFile::Close() {
+  if(data_ != nullptr) {
+    munmap(data_, size_);
+  }
+  if(fd_ >= 0) {
+    close(fd_);
+  }
+  fd_ = -1;
+  data_ = nullptr;
+  size_ = 0;
+}
+
+#else
+
+bool MappedFile::OpenRead(const std::string&) {
+  return false;
+}
+bool MappedFile::Create(const std::string&, size_t) {
+  return false;
+}
+bool MappedFile::Map(size_t, bool) {
+  return false;
+}
+void MappedFile::Close() {}
+
+#endif
+
+bool MappedFile::IsOpen() const {
+  return data_ != nullptr;
+}
+const uint8_t* MappedFile::GetData() const {
+  return data_;
+}
+uint8_t* MappedFile::GetData() {
+  return data_;
+}
+size_t MappedFile::GetSize() const {
+  return size_;
+}
+
+}  // namespace boidsimulation
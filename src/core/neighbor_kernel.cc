@@ -0,0 +1,349 @@
+#include <core/neighbor_kernel.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define BOIDSIMULATION_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+//Lets GCC and Clang compile single functions for instruction sets the rest of
+//the program is not built for. MSVC allows any intrinsic without this.
+#if defined(BOIDSIMULATION_X86) && (defined(__GNUC__) || defined(__clang__))
+#define BOIDSIMULATION_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BOIDSIMULATION_TARGET(isa)
+#endif
+
+namespace boidsimulation {
+
+template <typename T, size_t N>
+void NeighborBatch<T, N>::Clear() {
+  for(size_t axis = 0; axis < N; ++axis) {
+    positions_[axis].clear();
+    velocities_[axis].clear();
+  }
+}
+
+template <typename T, size_t N>
+void NeighborBatch<T, N>::Add(const BasicVector<T, N>& position,
+                              const BasicVector<T, N>& velocity) {
+  for(size_t axis = 0; axis < N; ++axis) {
+    positions_[axis].push_back(position.Component(axis));
+    velocities_[axis].push_back(velocity.Component(axis));
+  }
+}
+
+template <typename T, size_t N>
+size_t NeighborBatch<T, N>::Size() const {
+  return positions_[0].size();
+}
+
+template <typename T, size_t N>
+NeighborRange<T, N> NeighborBatch<T, N>::Range(size_t begin, size_t end) const {
+  NeighborRange<T, N> range;
+  for(size_t axis = 0; axis < N; ++axis) {
+    range.positions_[axis] = positions_[axis].data() + begin;
+    range.velocities_[axis] = velocities_[axis].data() + begin;
+  }
+  range.size_ = end - begin;
+  return range;
+}
+
+template <typename T, size_t N>
+NeighborRange<T, N> NeighborBatch<T, N>::Range() const {
+  return Range(0, Size());
+}
+
+namespace {
+
+/**
+ * Accumulates neighbors [begin, neighbors.size_) one at a time. Used as the
+ * scalar kernel and for the leftover neighbors of the vector kernels.
+ */
+template <typename T, size_t N>
+void AccumulateScalar(const NeighborRange<T, N>& neighbors, size_t begin,
+                      const BasicVector<T, N>& position, T separation_radius_sq,
+                      T vision_sq, NeighborSums<T, N>& sums) {
+  for(size_t index = begin; index < neighbors.size_; ++index) {
+    BasicVector<T, N> difference;
+    for(size_t axis = 0; axis < N; ++axis) {
+      difference.Component(axis) = neighbors.positions_[axis][index] - position.Component(axis);
+    }
+    T distance_sq = difference.LengthSquared();
+    if(distance_sq <= 0) {
+      continue;
+    }
+    if(distance_sq <= separation_radius_sq) {
+      sums.separation -= difference;
+    }
+    if(distance_sq <= vision_sq) {
+      for(size_t axis = 0; axis < N; ++axis) {
+        sums.heading.Component(axis) += neighbors.velocities_[axis][index];
+        sums.center.Component(axis) += neighbors.positions_[axis][index];
+      }
+      ++sums.count;
+    }
+  }
+}
+
+template <typename T, size_t N>
+void ScalarKernel(const NeighborRange<T, N>& neighbors, const BasicVector<T, N>& position,
+                  T separation_radius_sq, T vision_sq, NeighborSums<T, N>& sums) {
+  AccumulateScalar(neighbors, 0, position, separation_radius_sq, vision_sq, sums);
+}
+
+/**
+ * @return The number of set bits in the lane mask of a comparison.
+ */
+size_t CountLanes(int mask) {
+  size_t count = 0;
+  for(; mask != 0; mask >>= 1) {
+    count += mask & 1;
+  }
+  return count;
+}
+
+#if defined(BOIDSIMULATION_X86)
+
+/*
+ * Lanes wrap the intrinsics of one instruction set for one scalar type so the
+ * kernels below can be written once for both precisions. Each function carries
+ * the target of its instruction set so it can be inlined into the kernels.
+ */
+template <typename T>
+struct Sse2Lanes;
+
+template <>
+struct Sse2Lanes<double> {
+  typedef __m128d Type;
+  static const size_t kWidth = 2;
+
+  BOIDSIMULATION_TARGET("sse2") static Type Zero() { return _mm_setzero_pd(); }
+  BOIDSIMULATION_TARGET("sse2") static Type Set(double value) { return _mm_set1_pd(value); }
+  BOIDSIMULATION_TARGET("sse2") static Type Load(const double* values) { return _mm_loadu_pd(values); }
+  BOIDSIMULATION_TARGET("sse2") static Type Add(Type a, Type b) { return _mm_add_pd(a, b); }
+  BOIDSIMULATION_TARGET("sse2") static Type Sub(Type a, Type b) { return _mm_sub_pd(a, b); }
+  BOIDSIMULATION_TARGET("sse2") static Type Mul(Type a, Type b) { return _mm_mul_pd(a, b); }
+  BOIDSIMULATION_TARGET("sse2") static Type And(Type a, Type b) { return _mm_and_pd(a, b); }
+  BOIDSIMULATION_TARGET("sse2") static Type Greater(Type a, Type b) { return _mm_cmpgt_pd(a, b); }
+  BOIDSIMULATION_TARGET("sse2") static Type LessEqual(Type a, Type b) { return _mm_cmple_pd(a, b); }
+  BOIDSIMULATION_TARGET("sse2") static int Mask(Type a) { return _mm_movemask_pd(a); }
+  BOIDSIMULATION_TARGET("sse2") static double Sum(Type lanes) {
+    double values[2];
+    _mm_storeu_pd(values, lanes);
+    return values[0] + values[1];
+  }
+};
+
+template <>
+struct Sse2Lanes<float> {
+  typedef __m128 Type;
+  static const size_t kWidth = 4;
+
+  BOIDSIMULATION_TARGET("sse2") static Type Zero() { return _mm_setzero_ps(); }
+  BOIDSIMULATION_TARGET("sse2") static Type Set(float value) { return _mm_set1_ps(value); }
+  BOIDSIMULATION_TARGET("sse2") static Type Load(const float* values) { return _mm_loadu_ps(values); }
+  BOIDSIMULATION_TARGET("sse2") static Type Add(Type a, Type b) { return _mm_add_ps(a, b); }
+  BOIDSIMULATION_TARGET("sse2") static Type Sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+  BOIDSIMULATION_TARGET("sse2") static Type Mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+  BOIDSIMULATION_TARGET("sse2") static Type And(Type a, Type b) { return _mm_and_ps(a, b); }
+  BOIDSIMULATION_TARGET("sse2") static Type Greater(Type a, Type b) { return _mm_cmpgt_ps(a, b); }
+  BOIDSIMULATION_TARGET("sse2") static Type LessEqual(Type a, Type b) { return _mm_cmple_ps(a, b); }
+  BOIDSIMULATION_TARGET("sse2") static int Mask(Type a) { return _mm_movemask_ps(a); }
+  BOIDSIMULATION_TARGET("sse2") static float Sum(Type lanes) {
+    float values[4];
+    _mm_storeu_ps(values, lanes);
+    return (values[0] + values[1]) + (values[2] + values[3]);
+  }
+};
+
+template <typename T>
+struct Avx2Lanes;
+
+template <>
+struct Avx2Lanes<double> {
+  typedef __m256d Type;
+  static const size_t kWidth = 4;
+
+  BOIDSIMULATION_TARGET("avx2") static Type Zero() { return _mm256_setzero_pd(); }
+  BOIDSIMULATION_TARGET("avx2") static Type Set(double value) { return _mm256_set1_pd(value); }
+  BOIDSIMULATION_TARGET("avx2") static Type Load(const double* values) { return _mm256_loadu_pd(values); }
+  BOIDSIMULATION_TARGET("avx2") static Type Add(Type a, Type b) { return _mm256_add_pd(a, b); }
+  BOIDSIMULATION_TARGET("avx2") static Type Sub(Type a, Type b) { return _mm256_sub_pd(a, b); }
+  BOIDSIMULATION_TARGET("avx2") static Type Mul(Type a, Type b) { return _mm256_mul_pd(a, b); }
+  BOIDSIMULATION_TARGET("avx2") static Type And(Type a, Type b) { return _mm256_and_pd(a, b); }
+  BOIDSIMULATION_TARGET("avx2") static Type Greater(Type a, Type b) {
+    return _mm256_cmp_pd(a, b, _CMP_GT_OQ);
+  }
+  BOIDSIMULATION_TARGET("avx2") static Type LessEqual(Type a, Type b) {
+    return _mm256_cmp_pd(a, b, _CMP_LE_OQ);
+  }
+  BOIDSIMULATION_TARGET("avx2") static int Mask(Type a) { return _mm256_movemask_pd(a); }
+  BOIDSIMULATION_TARGET("avx2") static double Sum(Type lanes) {
+    double values[4];
+    _mm256_storeu_pd(values, lanes);
+    return (values[0] + values[1]) + (values[2] + values[3]);
+  }
+};
+
+template <>
+struct Avx2Lanes<float> {
+  typedef __m256 Type;
+  static const size_t kWidth = 8;
+
+  BOIDSIMULATION_TARGET("avx2") static Type Zero() { return _mm256_setzero_ps(); }
+  BOIDSIMULATION_TARGET("avx2") static Type Set(float value) { return _mm256_set1_ps(value); }
+  BOIDSIMULATION_TARGET("avx2") static Type Load(const float* values) { return _mm256_loadu_ps(values); }
+  BOIDSIMULATION_TARGET("avx2") static Type Add(Type a, Type b) { return _mm256_add_ps(a, b); }
+  BOIDSIMULATION_TARGET("avx2") static Type Sub(Type a, Type b) { return _mm256_sub_ps(a, b); }
+  BOIDSIMULATION_TARGET("avx2") static Type Mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+  BOIDSIMULATION_TARGET("avx2") static Type And(Type a, Type b) { return _mm256_and_ps(a, b); }
+  BOIDSIMULATION_TARGET("avx2") static Type Greater(Type a, Type b) {
+    return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+  }
+  BOIDSIMULATION_TARGET("avx2") static Type LessEqual(Type a, Type b) {
+    return _mm256_cmp_ps(a, b, _CMP_LE_OQ);
+  }
+  BOIDSIMULATION_TARGET("avx2") static int Mask(Type a) { return _mm256_movemask_ps(a); }
+  BOIDSIMULATION_TARGET("avx2") static float Sum(Type lanes) {
+    float values[8];
+    _mm256_storeu_ps(values, lanes);
+    return ((values[0] + values[1]) + (values[2] + values[3])) +
+           ((values[4] + values[5]) + (values[6] + values[7]));
+  }
+};
+
+/*
+ * The two kernels share one body. It is a macro rather than a template because
+ * each copy has to be compiled for its own instruction set.
+ */
+#define BOIDSIMULATION_LANE_KERNEL_BODY(Lanes)                                       \
+  typedef typename Lanes::Type Type;                                                 \
+  const Type zero = Lanes::Zero();                                                   \
+  const Type separation_limit = Lanes::Set(separation_radius_sq);                    \
+  const Type vision_limit = Lanes::Set(vision_sq);                                   \
+  Type center[N], separation[N], heading[N], origin[N];                              \
+  for(size_t axis = 0; axis < N; ++axis) {                                           \
+    origin[axis] = Lanes::Set(position.Component(axis));                             \
+    separation[axis] = heading[axis] = center[axis] = zero;                          \
+  }                                                                                  \
+  size_t count = 0;                                                                  \
+                                                                                     \
+  size_t index = 0;                                                                  \
+  for(; index + Lanes::kWidth <= neighbors.size_; index += Lanes::kWidth) {          \
+    Type coordinates[N], differences[N];                                             \
+    Type distance_sq = zero;                                                         \
+    for(size_t axis = 0; axis < N; ++axis) {                                         \
+      coordinates[axis] = Lanes::Load(&neighbors.positions_[axis][index]);           \
+      differences[axis] = Lanes::Sub(coordinates[axis], origin[axis]);               \
+      distance_sq = Lanes::Add(distance_sq,                                          \
+                               Lanes::Mul(differences[axis], differences[axis]));    \
+    }                                                                                \
+                                                                                     \
+    /* All-ones lanes for neighbors passing each radius test */                      \
+    Type not_self = Lanes::Greater(distance_sq, zero);                               \
+    Type separating = Lanes::And(not_self,                                           \
+                                 Lanes::LessEqual(distance_sq, separation_limit));   \
+    Type visible = Lanes::And(not_self, Lanes::LessEqual(distance_sq, vision_limit)); \
+                                                                                     \
+    for(size_t axis = 0; axis < N; ++axis) {                                         \
+      separation[axis] = Lanes::Sub(separation[axis],                                \
+                                    Lanes::And(differences[axis], separating));      \
+      heading[axis] = Lanes::Add(heading[axis],                                      \
+          Lanes::And(Lanes::Load(&neighbors.velocities_[axis][index]), visible));    \
+      center[axis] = Lanes::Add(center[axis], Lanes::And(coordinates[axis], visible)); \
+    }                                                                                \
+    count += CountLanes(Lanes::Mask(visible));                                       \
+  }                                                                                  \
+                                                                                     \
+  for(size_t axis = 0; axis < N; ++axis) {                                           \
+    sums.separation.Component(axis) += Lanes::Sum(separation[axis]);                 \
+    sums.heading.Component(axis) += Lanes::Sum(heading[axis]);                       \
+    sums.center.Component(axis) += Lanes::Sum(center[axis]);                         \
+  }                                                                                  \
+  sums.count += count;                                                               \
+  AccumulateScalar(neighbors, index, position, separation_radius_sq, vision_sq, sums);
+
+template <typename T, size_t N>
+BOIDSIMULATION_TARGET("sse2")
+void Sse2Kernel(const NeighborRange<T, N>& neighbors, const BasicVector<T, N>& position,
+                T separation_radius_sq, T vision_sq, NeighborSums<T, N>& sums) {
+  BOIDSIMULATION_LANE_KERNEL_BODY(Sse2Lanes<T>)
+}
+
+template <typename T, size_t N>
+BOIDSIMULATION_TARGET("avx2")
+void Avx2Kernel(const NeighborRange<T, N>& neighbors, const BasicVector<T, N>& position,
+                T separation_radius_sq, T vision_sq, NeighborSums<T, N>& sums) {
+  BOIDSIMULATION_LANE_KERNEL_BODY(Avx2Lanes<T>)
+}
+
+#undef BOIDSIMULATION_LANE_KERNEL_BODY
+
+/**
+ * Queries the CPU and operating system for SSE2 and AVX2 support.
+ */
+SimdLevel QuerySimdLevel() {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  int max_leaf = info[0];
+  __cpuid(info, 1);
+  bool sse2 = (info[3] & (1 << 26)) != 0;
+  bool os_saves_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 &&
+                      (_xgetbv(0) & 6) == 6;
+  bool avx2 = false;
+  if(max_leaf >= 7 && os_saves_avx) {
+    __cpuidex(info, 7, 0);
+    avx2 = (info[1] & (1 << 5)) != 0;
+  }
+#else
+  __builtin_cpu_init();
+  bool sse2 = __builtin_cpu_supports("sse2");
+  bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+  if(avx2) {
+    return SimdLevel::kAvx2;
+  }
+  return sse2 ? SimdLevel::kSse2 : SimdLevel::kScalar;
+}
+
+#else
+
+SimdLevel QuerySimdLevel() {
+  return SimdLevel::kScalar;
+}
+
+#endif
+
+}  // namespace
+
+SimdLevel DetectSimdLevel() {
+  static const SimdLevel level = QuerySimdLevel();
+  return level;
+}
+
+bool IsSimdLevelSupported(SimdLevel level) {
+  return (int)level <= (int)DetectSimdLevel();
+}
+
+template <typename T, size_t N>
+NeighborKernel<T, N> GetNeighborKernel(SimdLevel level) {
+#if defined(BOIDSIMULATION_X86)
+  if(level == SimdLevel::kAvx2) {
+    return Avx2Kernel<T, N>;
+  } else if(level == SimdLevel::kSse2) {
+    return Sse2Kernel<T, N>;
+  }
+#endif
+  return ScalarKernel<T, N>;
+}
+
+template struct NeighborBatch<double, 3>;
+template struct NeighborBatch<float, 2>;
+template NeighborKernel<double, 3> GetNeighborKernel<double, 3>(SimdLevel level);
+template NeighborKernel<float, 2> GetNeighborKernel<float, 2>(SimdLevel level);
+
+}  // namespace boidsimulation
@@ -1,21 +1,49 @@
 #include <core/obstacle.h>
+#include <cmath>
 
 namespace boidsimulation {
 
-void Obstacle::Draw() const {
-  ci::gl::color(color_);
-  ci::gl::drawSolidCircle(glm::vec2(position_.x_,position_.y_),(float)size_);
-}
-
 const boidsimulation::MathVector & Obstacle::GetPosition() const {
   return position_;
 }
 double Obstacle::GetSize() const {
   return size_;
 }
-const ci::Color8u & Obstacle::GetColor() const {
+const Color& Obstacle::GetColor() const {
   return color_;
 }
 
+namespace {
+
+//2^(0.35*part) for part in [0, 20)
+const double kFalloffPowers[] = {
+    1.0, 1.2745606273192622, 1.624504792712471, 2.0705298476827547,
+    2.6390158215457884, 3.363585661014858, 4.287093850145172, 5.464161027017581,
+    6.964404506368992, 8.876555776542759, 11.313708498984761, 14.42000740177328,
+    18.37917367995255, 23.425371135130003, 29.857055729177826, 38.05462768008707,
+    48.50293012833273, 61.81992505119008, 78.79324245407463, 100.42676453078406};
+
+}  // namespace
+
+double AvoidanceFalloff(double distance) {
+  if(distance <= 0) {
+    return 1;
+  }
+  //distance = mantissa * 2^exponent with mantissa in [0.5, 1)
+  int exponent;
+  double mantissa = std::frexp(distance, &exponent);
+
+  //mantissa^0.35 from a degree 5 fit over [0.5, 1], in t = 4*mantissa - 3
+  double t = 4 * mantissa - 3;
+  double root = ((((0.00012545892000268366 * t - 0.00051030493763174) * t +
+                   0.002090229912701329) * t - 0.01140996876811011) * t +
+                 0.10549196195037902) * t + 0.9042134273287551;
+
+  //2^(0.35*exponent) = 2^(7*whole) * 2^(0.35*part) with exponent = 20*whole + part
+  int whole = exponent >= 0 ? exponent / 20 : -((19 - exponent) / 20);
+  int part = exponent - 20 * whole;
+  return distance * std::ldexp(root * kFalloffPowers[part], 7 * whole) + 1;
+}
+
 }  // namespace idealgas
 
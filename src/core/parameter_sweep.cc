@@ -0,0 +1,511 @@
+#include <core/parameter_sweep.h>
+#include <core/profiler.h>
+#include <core/thread_pool.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctype.h>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdlib.h>
+
+namespace boidsimulation {
+
+namespace {
+
+const char* const kLayoutNames[] = {"none", "center", "grid", "ring"};
+
+//Most values one start:stop:step range may expand to
+const double kMaxRangeValues = 100000;
+//Whole numbers are read as doubles, which hold every integer up to 2^53
+const double kMaxInteger = 9007199254740992.0;
+
+const char* LayoutName(ObstacleLayout layout) {
+  return kLayoutNames[static_cast<size_t>(layout)];
+}
+
+/**
+ * @return text without leading and trailing whitespace.
+ */
+std::string Trim(const std::string& text) {
+  size_t begin = 0;
+  size_t end = text.size();
+  while(begin < end && isspace(static_cast<unsigned char>(text[begin]))) {
+    ++begin;
+  }
+  while(end > begin && isspace(static_cast<unsigned char>(text[end - 1]))) {
+    --end;
+  }
+  return text.substr(begin, end - begin);
+}
+
+/**
+ * @return The trimmed fields of text between separators.
+ */
+std::vector<std::string> Split(const std::string& text, char separator) {
+  std::vector<std::string> fields;
+  size_t begin = 0;
+  while(true) {
+    size_t end = text.find(separator, begin);
+    fields.push_back(Trim(text.substr(begin, end - begin)));
+    if(end == std::string::npos) {
+      return fields;
+    }
+    begin = end + 1;
+  }
+}
+
+/**
+ * Reads a whole field as a number.
+ * @return False if field is not a number.
+ */
+bool ParseNumber(const std::string& field, double& value) {
+  char* end = nullptr;
+  value = strtod(field.c_str(), &end);
+  return !field.empty() && *end == '\0' && std::isfinite(value);
+}
+
+/**
+ * Reads a comma separated list or inclusive start:stop:step range.
+ * @return False if a value is not a number or the range is empty.
+ */
+bool ParseNumbers(const std::string& text, std::vector<double>& values) {
+  values.clear();
+  std::vector<std::string> range = Split(text, ':');
+  if(range.size() == 3) {
+    double start;
+    double stop;
+    double step;
+    if(!ParseNumber(range[0], start) || !ParseNumber(range[1], stop) ||
+       !ParseNumber(range[2], step) || step <= 0 || stop < start) {
+      return false;
+    }
+    //Values are computed from the start rather than summed so steps such as
+    //0.1 do not drift, and stop is kept despite rounding
+    double steps = std::floor((stop - start) / step + 1e-9);
+    if(!(steps < kMaxRangeValues)) {
+      return false;
+    }
+    size_t count = static_cast<size_t>(steps) + 1;
+    for(size_t index = 0; index < count; ++index) {
+      values.push_back(start + index * step);
+    }
+    return true;
+  }
+  if(range.size() != 1) {
+    return false;
+  }
+  for(const std::string& field : Split(text, ',')) {
+    double value;
+    if(!ParseNumber(field, value)) {
+      return false;
+    }
+    values.push_back(value);
+  }
+  return true;
+}
+
+/**
+ * Converts number to a whole number.
+ * @return False if number is negative, has a fraction or is above 2^53.
+ */
+template <typename Integer>
+bool ToInteger(double number, Integer& value) {
+  if(number < 0 || number != std::floor(number) || number > kMaxInteger) {
+    return false;
+  }
+  value = static_cast<Integer>(number);
+  return true;
+}
+
+/**
+ * Reads a list or range of whole numbers.
+ * @return False if a value is not a whole number from 0 to 2^53.
+ */
+template <typename Integer>
+bool ParseIntegers(const std::string& text, std::vector<Integer>& values) {
+  std::vector<double> numbers;
+  if(!ParseNumbers(text, numbers)) {
+    return false;
+  }
+  values.assign(numbers.size(), 0);
+  for(size_t index = 0; index < numbers.size(); ++index) {
+    if(!ToInteger(numbers[index], values[index])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ParseLayouts(const std::string& text, std::vector<ObstacleLayout>& layouts) {
+  layouts.clear();
+  for(const std::string& field : Split(text, ',')) {
+    size_t layout = 0;
+    while(layout < 4 && field != kLayoutNames[layout]) {
+      ++layout;
+    }
+    if(layout == 4) {
+      return false;
+    }
+    layouts.push_back(static_cast<ObstacleLayout>(layout));
+  }
+  return true;
+}
+
+/**
+ * Reads a setting that takes one positive value.
+ */
+bool ParseSingle(const std::string& text, double& value) {
+  double number;
+  if(!ParseNumber(text, number) || number <= 0) {
+    return false;
+  }
+  value = number;
+  return true;
+}
+
+/**
+ * Reads a setting that takes one positive whole number.
+ */
+bool ParseSingle(const std::string& text, size_t& value) {
+  double number;
+  return ParseNumber(text, number) && number > 0 && ToInteger(number, value);
+}
+
+/**
+ * Adds the Obstacles of layout to world.
+ */
+void PlaceObstacles(ObstacleLayout layout, World& world) {
+  double center_x = world.GetMinX() + world.GetWidth() / 2;
+  double center_y = world.GetMinY() + world.GetHeight() / 2;
+  switch(layout) {
+    case ObstacleLayout::kNone:
+      break;
+    case ObstacleLayout::kCenter:
+      world.AddObstacle(MathVector(center_x, center_y, 0));
+      break;
+    case ObstacleLayout::kGrid:
+      for(size_t row = 1; row <= 3; ++row) {
+        for(size_t column = 1; column <= 3; ++column) {
+          world.AddObstacle(MathVector(world.GetMinX() + world.GetWidth() * column / 4,
+                                       world.GetMinY() + world.GetHeight() * row / 4, 0));
+        }
+      }
+      break;
+    case ObstacleLayout::kRing: {
+      const double kPi = 3.14159265358979323846;
+      double radius = std::min(world.GetWidth(), world.GetHeight()) / 3;
+      for(size_t index = 0; index < 8; ++index) {
+        double angle = 2 * kPi * index / 8;
+        world.AddObstacle(MathVector(center_x + radius * std::cos(angle),
+                                     center_y + radius * std::sin(angle), 0));
+      }
+      break;
+    }
+  }
+}
+
+/**
+ * @return The columns of a row that identify its run, comma separated.
+ */
+std::string ConfigColumns(const SweepConfig& config, size_t steps) {
+  const WorldParameters& parameters = config.parameters;
+  std::ostringstream row;
+  row << std::setprecision(10) << config.index << "," << config.seed << ","
+      << config.boid_num << "," << config.pred_num << ","
+      << LayoutName(config.obstacle_layout) << "," << parameters.separation << ","
+      << parameters.alignment << "," << parameters.cohesion << "," << parameters.chase << ","
+      << parameters.boid_max_speed << "," << parameters.pred_max_speed << "," << steps;
+  return row.str();
+}
+
+/**
+ * Reads the file at path into text.
+ * @return False if the file exists but cannot be read. Missing files are empty.
+ */
+bool ReadFile(const std::string& path, std::string& text) {
+  text.clear();
+  FILE* file = fopen(path.c_str(), "rb");
+  if(file == nullptr) {
+    return errno == ENOENT;
+  }
+  char buffer[1 << 16];
+  size_t read;
+  while((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    text.append(buffer, read);
+  }
+  bool failed = ferror(file) != 0;
+  fclose(file);
+  return !failed;
+}
+
+/**
+ * Replaces the file at path with text.
+ */
+bool WriteFile(const std::string& path, const std::string& text) {
+  //Written beside path and renamed over it so a failed write keeps the old rows
+  std::string temporary_path = path + ".tmp";
+  FILE* file = fopen(temporary_path.c_str(), "wb");
+  if(file == nullptr) {
+    return false;
+  }
+  bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+  if(fclose(file) != 0 || !written) {
+    return false;
+  }
+  return std::rename(temporary_path.c_str(), path.c_str()) == 0;
+}
+
+}  // namespace
+
+bool SweepSpec::Parse(const std::string& text, SweepSpec& spec, std::string& error) {
+  SweepSpec parsed;
+  std::istringstream lines(text);
+  std::string line;
+  while(std::getline(lines, line)) {
+    std::string content = Trim(line.substr(0, line.find('#')));
+    if(content.empty()) {
+      continue;
+    }
+    size_t equals = content.find('=');
+    std::string name = Trim(content.substr(0, equals));
+    std::string values = equals == std::string::npos ? "" : Trim(content.substr(equals + 1));
+
+    bool valid;
+    if(name == "width") {
+      valid = ParseSingle(values, parsed.width);
+    } else if(name == "height") {
+      valid = ParseSingle(values, parsed.height);
+    } else if(name == "steps") {
+      valid = ParseSingle(values, parsed.steps);
+    } else if(name == "boids") {
+      valid = ParseIntegers(values, parsed.boid_nums);
+    } else if(name == "predators") {
+      valid = ParseIntegers(values, parsed.pred_nums);
+    } else if(name == "obstacles") {
+      valid = ParseLayouts(values, parsed.obstacle_layouts);
+    } else if(name == "separation") {
+      valid = ParseNumbers(values, parsed.separations);
+    } else if(name == "alignment") {
+      valid = ParseNumbers(values, parsed.alignments);
+    } else if(name == "cohesion") {
+      valid = ParseNumbers(values, parsed.cohesions);
+    } else if(name == "chase") {
+      valid = ParseNumbers(values, parsed.chases);
+    } else if(name == "boid_max_speed") {
+      valid = ParseNumbers(values, parsed.boid_max_speeds);
+    } else if(name == "pred_max_speed") {
+      valid = ParseNumbers(values, parsed.pred_max_speeds);
+    } else if(name == "seeds") {
+      valid = ParseIntegers(values, parsed.seeds);
+    } else {
+      valid = false;
+    }
+    //The run count is a product of list lengths, which must not overflow
+    double runs = 1;
+    for(size_t length : {parsed.boid_nums.size(), parsed.pred_nums.size(),
+                         parsed.obstacle_layouts.size(), parsed.separations.size(),
+                         parsed.alignments.size(), parsed.cohesions.size(), parsed.chases.size(),
+                         parsed.boid_max_speeds.size(), parsed.pred_max_speeds.size(),
+                         parsed.seeds.size()}) {
+      runs *= length;
+    }
+    if(!valid || runs > kMaxInteger) {
+      error = line;
+      return false;
+    }
+  }
+  spec = parsed;
+  return true;
+}
+
+size_t SweepSpec::ConfigCount() const {
+  return boid_nums.size() * pred_nums.size() * obstacle_layouts.size() * separations.size() *
+         alignments.size() * cohesions.size() * chases.size() * boid_max_speeds.size() *
+         pred_max_speeds.size() * seeds.size();
+}
+
+SweepConfig SweepSpec::GetConfig(size_t index) const {
+  SweepConfig config;
+  config.index = index;
+  //Mixed radix digits of index, least significant first
+  size_t remaining = index;
+  auto digit = [&remaining](const auto& values) {
+    size_t value = remaining % values.size();
+    remaining /= values.size();
+    return values[value];
+  };
+  config.seed = digit(seeds);
+  config.parameters.pred_max_speed = digit(pred_max_speeds);
+  config.parameters.boid_max_speed = digit(boid_max_speeds);
+  config.parameters.chase = digit(chases);
+  config.parameters.cohesion = digit(cohesions);
+  config.parameters.alignment = digit(alignments);
+  config.parameters.separation = digit(separations);
+  config.obstacle_layout = digit(obstacle_layouts);
+  config.pred_num = digit(pred_nums);
+  config.boid_num = digit(boid_nums);
+  return config;
+}
+
+ParameterSweep::ParameterSweep(const SweepSpec& spec) : spec_(spec) {}
+
+SweepMetrics ParameterSweep::RunConfig(const SweepConfig& config) const {
+  BOIDSIMULATION_PROFILE_SCOPE("Sweep Run");
+  auto start = std::chrono::steady_clock::now();
+  World world(0, 0, spec_.width, spec_.height, config.boid_num, config.pred_num,
+              config.parameters, config.seed);
+  world.SetDeterministic(true);
+  PlaceObstacles(config.obstacle_layout, world);
+  for(size_t step = 0; step < spec_.steps; ++step) {
+    world.Update();
+  }
+
+  SweepMetrics metrics;
+  const World::FlockStateType& boids = world.GetBoids();
+  metrics.survivors = boids.Size();
+  metrics.caught = world.GetCatchStats().total_caught;
+  if(!boids.Empty()) {
+    World::VectorType center;
+    World::VectorType heading;
+    double speed_sum = 0;
+    for(size_t index = 0; index < boids.Size(); ++index) {
+      const World::VectorType& velocity = boids.velocities_[index];
+      double speed = velocity.Length();
+      speed_sum += speed;
+      if(speed > 0) {
+        heading += velocity / speed;
+      }
+      center += boids.positions_[index];
+    }
+    center /= static_cast<double>(boids.Size());
+    double squared_distance_sum = 0;
+    for(const World::VectorType& position : boids.positions_) {
+      squared_distance_sum += position.DistanceSquared(center);
+    }
+    metrics.mean_speed = speed_sum / boids.Size();
+    metrics.polarization = heading.Length() / boids.Size();
+    metrics.spread = std::sqrt(squared_distance_sum / boids.Size());
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  metrics.seconds = elapsed.count();
+  return metrics;
+}
+
+bool ParameterSweep::Run(const std::string& path, size_t thread_count) {
+  skipped_count_ = 0;
+  run_count_ = 0;
+
+  std::string text;
+  if(!ReadFile(path, text)) {
+    return false;
+  }
+  //Drop a row cut short by a killed sweep, so appended rows start on a new line
+  size_t complete = text.rfind('\n');
+  complete = complete == std::string::npos ? 0 : complete + 1;
+  if(complete == 0) {
+    //Only an empty file or a header cut short is restarted, never another file
+    if(CsvHeader().compare(0, text.size(), text) != 0) {
+      return false;
+    }
+    text = CsvHeader() + "\n";
+  } else {
+    text.resize(complete);
+  }
+  std::vector<char> done;
+  if(!ReadDone(text, done)) {
+    return false;
+  }
+  if(!WriteFile(path, text)) {
+    return false;
+  }
+
+  std::vector<size_t> pending;
+  for(size_t index = 0; index < done.size(); ++index) {
+    if(done[index]) {
+      ++skipped_count_;
+    } else {
+      pending.push_back(index);
+    }
+  }
+
+  FILE* file = fopen(path.c_str(), "ab");
+  if(file == nullptr) {
+    return false;
+  }
+  std::mutex file_mutex;
+  bool written = true;
+  auto task = [&](size_t begin, size_t end) {
+    for(size_t index = begin; index < end; ++index) {
+      SweepConfig config = spec_.GetConfig(pending[index]);
+      std::string row = CsvRow(config, spec_.steps, RunConfig(config)) + "\n";
+
+      //Flushed per row so an interrupted sweep loses at most the runs in flight
+      std::lock_guard<std::mutex> lock(file_mutex);
+      if(fwrite(row.data(), 1, row.size(), file) != row.size() || fflush(file) != 0) {
+        written = false;
+      }
+      ++run_count_;
+    }
+  };
+  if(thread_count != 1) {
+    //One run per chunk, so threads that draw quick runs take more of them
+    ThreadPool thread_pool(thread_count);
+    thread_pool.ParallelFor(pending.size(), 1, task);
+  } else {
+    task(0, pending.size());
+  }
+  return fclose(file) == 0 && written;
+}
+
+size_t ParameterSweep::GetSkippedCount() const {
+  return skipped_count_;
+}
+
+size_t ParameterSweep::GetRunCount() const {
+  return run_count_;
+}
+
+std::string ParameterSweep::CsvHeader() {
+  return "index,seed,boids,predators,obstacles,separation,alignment,cohesion,chase,"
+         "boid_max_speed,pred_max_speed,steps,survivors,caught,mean_speed,polarization,"
+         "spread,seconds";
+}
+
+std::string ParameterSweep::CsvRow(const SweepConfig& config, size_t steps,
+                                   const SweepMetrics& metrics) {
+  std::ostringstream row;
+  row << ConfigColumns(config, steps) << std::setprecision(10) << "," << metrics.survivors
+      << "," << metrics.caught << "," << metrics.mean_speed << "," << metrics.polarization
+      << "," << metrics.spread << "," << metrics.seconds;
+  return row.str();
+}
+
+bool ParameterSweep::ReadDone(const std::string& text, std::vector<char>& done) const {
+  done.assign(spec_.ConfigCount(), false);
+  std::istringstream lines(text);
+  std::string line;
+  if(!std::getline(lines, line) || line != CsvHeader()) {
+    return false;
+  }
+  while(std::getline(lines, line)) {
+    char* end = nullptr;
+    size_t index = strtoul(line.c_str(), &end, 10);
+    if(end == line.c_str() || *end != ',' || index >= done.size()) {
+      return false;
+    }
+    //Rows of a different spec at the same index would be silently mixed in
+    std::string columns = ConfigColumns(spec_.GetConfig(index), spec_.steps) + ",";
+    if(line.compare(0, columns.size(), columns) != 0) {
+      return false;
+    }
+    done[index] = true;
+  }
+  return true;
+}
+
+}  // namespace boidsimulation
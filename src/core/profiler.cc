@@ -0,0 +1,224 @@
+#include <core/profiler.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string.h>
+
+namespace boidsimulation {
+
+namespace {
+
+/**
+ * The same string literal may have a different address in each translation
+ * unit, so names that are not the same pointer are compared by contents.
+ */
+bool SameName(const char* name, const char* other) {
+  return name == other || strcmp(name, other) == 0;
+}
+
+}  // namespace
+
+Profiler::Profiler() : epoch_(Clock::now()) {}
+
+void Profiler::SetEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::AddTime(const char* name, Clock::time_point start, Clock::time_point end,
+                       bool trace) {
+  ThreadBuffer& buffer = GetThreadBuffer();
+  Total* total = FindTotal(buffer, name, true);
+  if(total) {
+    uint64_t nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    total->value.fetch_add(nanoseconds, std::memory_order_relaxed);
+    total->calls.fetch_add(1, std::memory_order_relaxed);
+  }
+  if(trace) {
+    double start_us = Microseconds(start);
+    AddEvent(buffer, {name, start_us, Microseconds(end) - start_us, 0});
+  }
+}
+
+void Profiler::AddCount(const char* name, uint64_t value) {
+  Total* total = FindTotal(GetThreadBuffer(), name, false);
+  if(total) {
+    total->value.fetch_add(value, std::memory_order_relaxed);
+    total->calls.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Profiler::EndFrame() {
+  double now = Microseconds(Clock::now());
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  //Merge every thread's totals by name, in order of first use
+  std::vector<FrameTotal> frame;
+  for(auto& buffer : buffers_) {
+    size_t count = buffer->total_count.load(std::memory_order_acquire);
+    for(size_t index = 0; index < count; ++index) {
+      Total& total = buffer->totals[index];
+      uint64_t value = total.value.exchange(0, std::memory_order_relaxed);
+      uint64_t calls = total.calls.exchange(0, std::memory_order_relaxed);
+      auto merged = std::find_if(frame.begin(), frame.end(), [&](const FrameTotal& entry) {
+        return SameName(entry.name, total.name);
+      });
+      if(merged == frame.end()) {
+        frame.push_back({total.name, total.timer, value, calls});
+      } else {
+        merged->value += value;
+        merged->calls += calls;
+      }
+    }
+  }
+
+  for(const FrameTotal& total : frame) {
+    if(!total.timer && total.calls > 0) {
+      if(counter_events_.size() == kMaxEvents) {
+        counter_events_.erase(counter_events_.begin());
+      }
+      counter_events_.push_back({total.name, now, -1, total.value});
+    }
+  }
+  frames_.push_back(std::move(frame));
+  if(frames_.size() > kSummaryFrames) {
+    frames_.pop_front();
+  }
+}
+
+std::vector<ProfileSummary> Profiler::GetSummary() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<ProfileSummary> summary;
+  std::vector<const char*> names;
+  for(auto& frame : frames_) {
+    for(const FrameTotal& total : frame) {
+      size_t index = std::find_if(names.begin(), names.end(), [&](const char* name) {
+        return SameName(name, total.name);
+      }) - names.begin();
+      if(index == names.size()) {
+        names.push_back(total.name);
+        summary.push_back(ProfileSummary());
+        summary.back().name = total.name;
+        summary.back().timer = total.timer;
+      }
+      //Timers are kept in nanoseconds and reported in milliseconds
+      summary[index].per_frame += total.timer ? total.value / 1e6 : total.value;
+      summary[index].calls_per_frame += total.calls;
+    }
+  }
+  for(ProfileSummary& entry : summary) {
+    entry.per_frame /= frames_.size();
+    entry.calls_per_frame /= frames_.size();
+  }
+  std::stable_partition(summary.begin(), summary.end(),
+                        [](const ProfileSummary& entry) { return entry.timer; });
+  return summary;
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path) const {
+  std::ofstream file(path);
+  if(!file) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  file << "{\"traceEvents\":[";
+  bool first = true;
+  auto separate = [&]() {
+    file << (first ? "\n" : ",\n");
+    first = false;
+  };
+  for(auto& buffer : buffers_) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    for(const Event& event : buffer->events) {
+      separate();
+      file << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+           << buffer->lane << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+    }
+  }
+  for(const Event& event : counter_events_) {
+    separate();
+    file << "{\"name\":\"" << event.name << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << event.start
+         << ",\"args\":{\"value\":" << event.value << "}}";
+  }
+  file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return (bool)file;
+}
+
+void Profiler::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for(auto& buffer : buffers_) {
+    size_t count = buffer->total_count.load(std::memory_order_acquire);
+    for(size_t index = 0; index < count; ++index) {
+      buffer->totals[index].value.store(0, std::memory_order_relaxed);
+      buffer->totals[index].calls.store(0, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    buffer->events.clear();
+    buffer->next_event = 0;
+  }
+  frames_.clear();
+  counter_events_.clear();
+}
+
+Profiler::ThreadRegistration::~ThreadRegistration() {
+  if(buffer) {
+    Profiler& profiler = Profiler::Get();
+    std::lock_guard<std::mutex> lock(profiler.mutex_);
+    profiler.free_buffers_.push_back(buffer);
+  }
+}
+
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer() {
+  thread_local ThreadRegistration registration;
+  if(!registration.buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(free_buffers_.empty()) {
+      buffers_.emplace_back(new ThreadBuffer());
+      buffers_.back()->lane = buffers_.size();
+      registration.buffer = buffers_.back().get();
+    } else {
+      registration.buffer = free_buffers_.back();
+      free_buffers_.pop_back();
+    }
+  }
+  return *registration.buffer;
+}
+
+Profiler::Total* Profiler::FindTotal(ThreadBuffer& buffer, const char* name, bool timer) {
+  size_t count = buffer.total_count.load(std::memory_order_relaxed);
+  for(size_t index = 0; index < count; ++index) {
+    if(buffer.totals[index].name == name) {
+      return &buffer.totals[index];
+    }
+  }
+  for(size_t index = 0; index < count; ++index) {
+    if(SameName(buffer.totals[index].name, name)) {
+      return &buffer.totals[index];
+    }
+  }
+  if(count == ThreadBuffer::kMaxTotals) {
+    return nullptr;
+  }
+  //Published to EndFrame by the release store of the new count
+  buffer.totals[count].name = name;
+  buffer.totals[count].timer = timer;
+  buffer.total_count.store(count + 1, std::memory_order_release);
+  return &buffer.totals[count];
+}
+
+void Profiler::AddEvent(ThreadBuffer& buffer, const Event& event) {
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  if(buffer.events.size() < kMaxEvents) {
+    buffer.events.push_back(event);
+  } else {
+    buffer.events[buffer.next_event] = event;
+  }
+  buffer.next_event = (buffer.next_event + 1) % kMaxEvents;
+}
+
+double Profiler::Microseconds(Clock::time_point time) const {
+  return std::chrono::duration<double, std::micro>(time - epoch_).count();
+}
+
+}  // namespace boidsimulation
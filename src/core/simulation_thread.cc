@@ -0,0 +1,138 @@
+#include <core/simulation_thread.h>
+#include <core/profiler.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace boidsimulation {
+
+SimulationThread::SimulationThread(World& world) : world_(world) {}
+
+SimulationThread::~SimulationThread() {
+  Stop();
+}
+
+void SimulationThread::Start(double steps_per_second) {
+  if(thread_.joinable()) {
+    return;
+  }
+  stopping_ = false;
+  thread_ = std::thread(&SimulationThread::Run, this, steps_per_second);
+}
+
+void SimulationThread::Stop() {
+  if(!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_condition_.notify_all();
+  thread_.join();
+  RunCommands();
+}
+
+bool SimulationThread::IsRunning() const {
+  return thread_.joinable();
+}
+
+void SimulationThread::Post(const std::function<void(World&)>& command) {
+  if(!thread_.joinable()) {
+    command(world_);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    commands_.push_back(command);
+  }
+  wake_condition_.notify_all();
+}
+
+void SimulationThread::SetPaused(bool paused) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    paused_ = paused;
+  }
+  wake_condition_.notify_all();
+}
+bool SimulationThread::IsPaused() const {
+  return paused_;
+}
+
+const SimulationFrame& SimulationThread::AcquireFrame() {
+  frames_.Acquire();
+  return frames_.GetReadBuffer();
+}
+
+void SimulationThread::Run(double steps_per_second) {
+  typedef std::chrono::steady_clock Clock;
+  Clock::duration tick = Clock::duration::zero();
+  if(steps_per_second > 0) {
+    tick = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1 / steps_per_second));
+  }
+
+  //Ticks are scheduled from the start rather than from the end of the last
+  //step, so the rate does not drift by the time each step takes
+  Clock::time_point next_tick = Clock::now();
+  PublishFrame();
+  while(true) {
+    bool changed = RunCommands();
+    if(!paused_) {
+      world_.Update();
+      ++step_;
+      changed = true;
+    }
+    if(changed) {
+      PublishFrame();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(paused_) {
+      //Nothing to do until there is a change to run
+      wake_condition_.wait(lock, [this]() {
+        return stopping_ || !paused_ || !commands_.empty();
+      });
+      next_tick = Clock::now();
+    } else {
+      //A step that overran its tick starts the next one immediately instead of
+      //trying to catch up
+      next_tick = std::max(next_tick + tick, Clock::now());
+      wake_condition_.wait_until(lock, next_tick, [this]() { return stopping_; });
+    }
+    if(stopping_) {
+      return;
+    }
+  }
+}
+
+bool SimulationThread::RunCommands() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_commands_.swap(commands_);
+  }
+  for(auto& command : running_commands_) {
+    command(world_);
+  }
+  bool ran = !running_commands_.empty();
+  running_commands_.clear();
+  return ran;
+}
+
+void SimulationThread::PublishFrame() {
+  BOIDSIMULATION_PROFILE_SCOPE("Publish Frame");
+  SimulationFrame& frame = frames_.GetWriteBuffer();
+  frame.step = step_;
+  frame.geometry.Clear();
+  frame.geometry.AddFlock(world_.GetBoids());
+  frame.geometry.AddFlock(world_.GetPredators());
+  frame.geometry.AddObstacles(world_.GetObstacles());
+  frame.obstacles = world_.GetObstacles();
+  frame.catch_stats = world_.GetCatchStats();
+  frame.boid_count = world_.GetBoids().Size();
+  frame.predator_count = world_.GetPredators().Size();
+  frames_.Publish();
+}
+
+}  // namespace boidsimulation
@@ -0,0 +1,323 @@
+#include <core/snapshot.h>
+#include <core/mapped_file.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+namespace boidsimulation {
+
+namespace {
+
+const char kMagic[8] = {'B', 'O', 'I', 'D', 'S', 'N', 'A', 'P'};
+
+/**
+ * Start of a snapshot file. The Boid, Predator and Obstacle arrays follow it,
+ * each padded to a multiple of 8 bytes. Each flock's species table comes
+ * before its arrays.
+ */
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t scalar_size;
+  uint32_t dimensions;
+  uint32_t double_buffered;
+
+  double min_x;
+  double min_y;
+  double width;
+  double height;
+  WorldParameters parameters;
+
+  uint64_t seed;
+  uint64_t spawn_draw;
+  uint64_t step;
+  uint64_t total_caught;
+  uint64_t boid_count;
+  uint64_t predator_count;
+  uint64_t obstacle_count;
+  uint64_t boid_species_count;
+  uint64_t predator_species_count;
+};
+
+/**
+ * A Species as stored in a file. Written field by field with its padding
+ * zeroed, so identical Worlds give identical files, and read back only once
+ * predator is checked to be 0 or 1.
+ */
+struct SpeciesRecord {
+  double size;
+  double vision;
+  double max_speed;
+  double separation_scale;
+  double alignment_scale;
+  double cohesion_scale;
+  double chase_scale;
+  double obstacle_scale;
+  uint8_t color[3];
+  uint8_t predator;
+  uint8_t padding[4];
+};
+
+static_assert(sizeof(Header) % 8 == 0, "Arrays after the Header must stay aligned");
+static_assert(sizeof(SpeciesRecord) == 9 * sizeof(double),
+              "SpeciesRecord must have no padding of its own");
+static_assert(sizeof(WorldParameters) == 9 * sizeof(double),
+              "Bump Snapshot::kVersion when WorldParameters changes");
+static_assert(std::is_trivially_copyable<MathVector>::value &&
+              std::is_trivially_copyable<Color>::value,
+              "Snapshot arrays are copied as raw bytes");
+
+size_t Padded(size_t bytes) {
+  return (bytes + 7) & ~(size_t)7;
+}
+
+/**
+ * Calls visit with every array of flock, in file order.
+ */
+template <typename Flock, typename Visitor>
+void ForEachArray(Flock& flock, Visitor visit) {
+  visit(flock.positions_);
+  visit(flock.velocities_);
+  visit(flock.species_);
+}
+
+/**
+ * Obstacles split into arrays so they are stored like a FlockState.
+ */
+struct ObstacleArrays {
+  std::vector<MathVector> positions_;
+  std::vector<double> sizes_;
+  std::vector<Color> colors_;
+};
+
+/**
+ * @return The bytes a flock of count Boids and species_count species takes in
+ * a file.
+ */
+size_t FlockBytes(size_t count, size_t species_count) {
+  size_t bytes = Padded(species_count * sizeof(SpeciesRecord));
+  static const FlockState layout;
+  ForEachArray(layout, [&](auto& values) {
+    bytes += Padded(count * sizeof(values[0]));
+  });
+  return bytes;
+}
+
+/**
+ * @return Whether every Boid of the flock stored at data, with count Boids and
+ * species_count species, refers to one of those species.
+ */
+bool SpeciesInRange(const uint8_t* data, size_t count, size_t species_count) {
+  //The species indices follow the species table, positions and velocities
+  const uint8_t* species = data + Padded(species_count * sizeof(SpeciesRecord)) +
+                           2 * Padded(count * sizeof(MathVector));
+  return std::all_of(species, species + count, [&](uint8_t index) {
+    return index < species_count;
+  });
+}
+
+/**
+ * @return Whether every species record stored at data holds a valid bool.
+ */
+bool SpeciesValid(const uint8_t* data, size_t species_count) {
+  for(size_t index = 0; index < species_count; ++index) {
+    SpeciesRecord record;
+    std::memcpy(&record, data + index * sizeof(record), sizeof(record));
+    if(record.predator > 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<SpeciesRecord> ToRecords(const std::vector<Species>& table) {
+  std::vector<SpeciesRecord> records;
+  for(const Species& species : table) {
+    SpeciesRecord record = SpeciesRecord();
+    record.size = species.size;
+    record.vision = species.vision;
+    record.max_speed = species.max_speed;
+    record.separation_scale = species.separation_scale;
+    record.alignment_scale = species.alignment_scale;
+    record.cohesion_scale = species.cohesion_scale;
+    record.chase_scale = species.chase_scale;
+    record.obstacle_scale = species.obstacle_scale;
+    record.color[0] = species.color.r_;
+    record.color[1] = species.color.g_;
+    record.color[2] = species.color.b_;
+    record.predator = species.predator ? 1 : 0;
+    records.push_back(record);
+  }
+  return records;
+}
+
+std::vector<Species> FromRecords(const std::vector<SpeciesRecord>& records) {
+  std::vector<Species> table;
+  for(const SpeciesRecord& record : records) {
+    Species species;
+    species.size = record.size;
+    species.vision = record.vision;
+    species.max_speed = record.max_speed;
+    species.separation_scale = record.separation_scale;
+    species.alignment_scale = record.alignment_scale;
+    species.cohesion_scale = record.cohesion_scale;
+    species.chase_scale = record.chase_scale;
+    species.obstacle_scale = record.obstacle_scale;
+    species.color = Color(record.color[0], record.color[1], record.color[2]);
+    species.predator = record.predator != 0;
+    table.push_back(species);
+  }
+  return table;
+}
+
+size_t ObstacleBytes(size_t count) {
+  return Padded(count * sizeof(MathVector)) + Padded(count * sizeof(double)) +
+         Padded(count * sizeof(Color));
+}
+
+}  // namespace
+
+bool Snapshot::Save(const World& world, const std::string& path) {
+  Header header = Header();
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.scalar_size = sizeof(double);
+  header.dimensions = 3;
+  header.double_buffered = world.double_buffered_;
+  header.min_x = world.min_x_;
+  header.min_y = world.min_y_;
+  header.width = world.width_;
+  header.height = world.height_;
+  header.parameters = world.parameters_;
+  header.seed = world.random_.GetSeed();
+  header.spawn_draw = world.spawn_draw_;
+  header.step = world.step_;
+  header.total_caught = world.catch_stats_.total_caught;
+  header.boid_count = world.boids_.Size();
+  header.predator_count = world.predators_.Size();
+  header.obstacle_count = world.obstacles_.size();
+  header.boid_species_count = world.boids_.species_table_.size();
+  header.predator_species_count = world.predators_.species_table_.size();
+
+  ObstacleArrays obstacles;
+  for(auto& obstacle : world.obstacles_) {
+    obstacles.positions_.push_back(obstacle.GetPosition());
+    obstacles.sizes_.push_back(obstacle.GetSize());
+    obstacles.colors_.push_back(obstacle.GetColor());
+  }
+
+  //Written beside path and renamed over it so a failed save keeps the old snapshot
+  std::string temporary_path = path + ".tmp";
+  size_t size = sizeof(Header) + FlockBytes(header.boid_count, header.boid_species_count) +
+                FlockBytes(header.predator_count, header.predator_species_count) +
+                ObstacleBytes(header.obstacle_count);
+  MappedFile file;
+  if(!file.Create(temporary_path, size)) {
+    return false;
+  }
+
+  uint8_t* data = file.GetData();
+  std::memcpy(data, &header, sizeof(header));
+  size_t offset = sizeof(Header);
+  auto write = [&](const auto& values) {
+    size_t bytes = values.size() * sizeof(values[0]);
+    if(bytes > 0) {
+      std::memcpy(data + offset, values.data(), bytes);
+    }
+    offset += Padded(bytes);
+  };
+  write(ToRecords(world.boids_.species_table_));
+  ForEachArray(world.boids_, write);
+  write(ToRecords(world.predators_.species_table_));
+  ForEachArray(world.predators_, write);
+  write(obstacles.positions_);
+  write(obstacles.sizes_);
+  write(obstacles.colors_);
+  file.Close();
+
+  return std::rename(temporary_path.c_str(), path.c_str()) == 0;
+}
+
+bool Snapshot::Load(const std::string& path, World& world) {
+  MappedFile file;
+  if(!file.OpenRead(path) || file.GetSize() < sizeof(Header)) {
+    return false;
+  }
+  Header header;
+  std::memcpy(&header, file.GetData(), sizeof(header));
+  if(std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+     header.scalar_size != sizeof(double) || header.dimensions != 3) {
+    return false;
+  }
+  //Every array is checked to fit before the World is touched. Counts larger
+  //than the file could overflow the size sum, so they are rejected first
+  uint64_t max_count = file.GetSize();
+  if(header.boid_count > max_count || header.predator_count > max_count ||
+     header.obstacle_count > max_count ||
+     header.boid_species_count > FlockState::kMaxSpecies ||
+     header.predator_species_count > FlockState::kMaxSpecies) {
+    return false;
+  }
+  size_t boid_bytes = FlockBytes(header.boid_count, header.boid_species_count);
+  size_t predator_bytes = FlockBytes(header.predator_count, header.predator_species_count);
+  const uint8_t* data = file.GetData();
+  if(sizeof(Header) + boid_bytes + predator_bytes + ObstacleBytes(header.obstacle_count) !=
+     file.GetSize() ||
+     !SpeciesInRange(data + sizeof(Header), header.boid_count, header.boid_species_count) ||
+     !SpeciesInRange(data + sizeof(Header) + boid_bytes, header.predator_count,
+                     header.predator_species_count) ||
+     !SpeciesValid(data + sizeof(Header), header.boid_species_count) ||
+     !SpeciesValid(data + sizeof(Header) + boid_bytes, header.predator_species_count)) {
+    return false;
+  }
+
+  size_t offset = sizeof(Header);
+  size_t count = 0;
+  auto read = [&](auto& values) {
+    typedef typename std::remove_reference<decltype(values[0])>::type Value;
+    const Value* first = reinterpret_cast<const Value*>(data + offset);
+    values.assign(first, first + count);
+    offset += Padded(count * sizeof(Value));
+  };
+  std::vector<SpeciesRecord> records;
+  count = header.boid_species_count;
+  read(records);
+  world.boids_.species_table_ = FromRecords(records);
+  count = header.boid_count;
+  ForEachArray(world.boids_, read);
+  count = header.predator_species_count;
+  read(records);
+  world.predators_.species_table_ = FromRecords(records);
+  count = header.predator_count;
+  ForEachArray(world.predators_, read);
+
+  ObstacleArrays obstacles;
+  count = header.obstacle_count;
+  read(obstacles.positions_);
+  read(obstacles.sizes_);
+  read(obstacles.colors_);
+  world.obstacles_.clear();
+  for(size_t index = 0; index < obstacles.positions_.size(); ++index) {
+    world.obstacles_.push_back(Obstacle(obstacles.positions_[index], obstacles.sizes_[index],
+                                        obstacles.colors_[index]));
+  }
+  world.obstacle_grid_.Rebuild(world.obstacles_);
+  world.ResetSchedule();
+
+  world.double_buffered_ = header.double_buffered != 0;
+  world.min_x_ = header.min_x;
+  world.min_y_ = header.min_y;
+  world.width_ = header.width;
+  world.height_ = header.height;
+  world.parameters_ = header.parameters;
+  world.random_ = CounterRandom(header.seed);
+  world.spawn_draw_ = header.spawn_draw;
+  world.step_ = header.step;
+  world.catch_stats_ = CatchStats();
+  world.catch_stats_.total_caught = header.total_caught;
+  return true;
+}
+
+}  // namespace boidsimulation
@@ -0,0 +1,233 @@
+#include <core/spatial_grid.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace boidsimulation {
+
+namespace {
+
+//Id of the next grid build, shared by every grid so ids are never reused
+std::atomic<uint64_t> next_build_id(1);
+
+}  // namespace
+
+template <typename T, size_t N>
+void SpatialGrid::Rebuild(const BasicFlockState<T, N>& flock, double padding) {
+  double cell_size = 1;
+  for(auto& species : flock.species_table_) {
+    cell_size = std::max(cell_size, (double)species.vision);
+  }
+  Build(flock.positions_, cell_size, padding);
+}
+
+template <typename T, size_t N>
+void SpatialGrid::Rebuild(const std::vector<BasicBoid<T, N>>& flock, double padding) {
+  std::vector<BasicVector<T, N>> positions;
+  positions.reserve(flock.size());
+  double cell_size = 1;
+  for(auto& boid : flock) {
+    positions.push_back(boid.GetPosition());
+    cell_size = std::max(cell_size, (double)boid.GetVision());
+  }
+  Build(positions, cell_size, padding);
+}
+
+void SpatialGrid::Rebuild(const std::vector<Obstacle>& obstacles) {
+  std::vector<MathVector> positions;
+  positions.reserve(obstacles.size());
+  double max_size = 0;
+  for(auto& obstacle : obstacles) {
+    positions.push_back(obstacle.GetPosition());
+    max_size = std::max(max_size, obstacle.GetSize());
+  }
+  Build(positions, std::max(1.0, 2 * max_size), max_size);
+}
+
+template <typename T, size_t N>
+void SpatialGrid::Build(const std::vector<BasicVector<T, N>>& positions, double cell_size,
+                        double padding) {
+  Clear();
+  padding_ = padding;
+  if(positions.empty()) {
+    return;
+  }
+
+  //Bounds of the flock
+  cell_size_ = cell_size;
+  double max_x = positions.front().x_;
+  double max_y = positions.front().y_;
+  min_x_ = max_x;
+  min_y_ = max_y;
+  for(auto& position : positions) {
+    min_x_ = std::min(min_x_, (double)position.x_);
+    min_y_ = std::min(min_y_, (double)position.y_);
+    max_x = std::max(max_x, (double)position.x_);
+    max_y = std::max(max_y, (double)position.y_);
+  }
+
+  //Grow cells if the flock is spread out so memory stays proportional to flock size
+  size_t max_cells = 4 * positions.size() + 16;
+  cells_x_ = (size_t)((max_x - min_x_) / cell_size_) + 1;
+  cells_y_ = (size_t)((max_y - min_y_) / cell_size_) + 1;
+  while(cells_x_ * cells_y_ > max_cells) {
+    cell_size_ *= 2;
+    cells_x_ = (size_t)((max_x - min_x_) / cell_size_) + 1;
+    cells_y_ = (size_t)((max_y - min_y_) / cell_size_) + 1;
+  }
+
+  //Counting sort of Boid indices by cell, keeping indices ascending within a cell.
+  //The scratch is shared by every grid built on the thread
+  thread_local std::vector<size_t> boid_cells;
+  thread_local std::vector<size_t> next;
+  boid_cells.resize(positions.size());
+  cell_start_.assign(cells_x_ * cells_y_ + 1, 0);
+  for(size_t boid_index = 0; boid_index < positions.size(); ++boid_index) {
+    const BasicVector<T, N>& position = positions[boid_index];
+    size_t cell = CellCoordinate(position.y_, min_y_, cells_y_) * cells_x_ +
+                  CellCoordinate(position.x_, min_x_, cells_x_);
+    boid_cells[boid_index] = cell;
+    ++cell_start_[cell + 1];
+  }
+  for(size_t cell = 0; cell < cells_x_ * cells_y_; ++cell) {
+    cell_start_[cell + 1] += cell_start_[cell];
+  }
+
+  indices_.resize(positions.size());
+  next.assign(cell_start_.begin(), cell_start_.end() - 1);
+  for(size_t boid_index = 0; boid_index < positions.size(); ++boid_index) {
+    indices_[next[boid_cells[boid_index]]++] = boid_index;
+  }
+  build_id_ = next_build_id++;
+}
+
+void SpatialGrid::Clear() {
+  cell_size_ = 0;
+  padding_ = 0;
+  cells_x_ = 0;
+  cells_y_ = 0;
+  build_id_ = 0;
+  cell_start_.clear();
+  indices_.clear();
+}
+
+void SpatialGrid::QueryCandidates(double x, double y, double radius,
+                                  std::vector<size_t>& candidates) const {
+  size_t first_x, last_x, first_y, last_y;
+  if(!CellRange(x, y, radius, first_x, last_x, first_y, last_y)) {
+    return;
+  }
+
+  size_t first_candidate = candidates.size();
+  for(size_t cell_y = first_y; cell_y <= last_y; ++cell_y) {
+    size_t row = cell_y * cells_x_;
+    candidates.insert(candidates.end(),
+                      indices_.begin() + cell_start_[row + first_x],
+                      indices_.begin() + cell_start_[row + last_x + 1]);
+  }
+  std::sort(candidates.begin() + first_candidate, candidates.end());
+}
+
+void SpatialGrid::QueryLine(double x, double y, double dx, double dy, double distance,
+                            std::vector<size_t>& candidates) const {
+  if(indices_.empty()) {
+    return;
+  }
+  if(dx == 0 && dy == 0) {
+    candidates.insert(candidates.end(), indices_.begin(), indices_.end());
+    std::sort(candidates.end() - indices_.size(), candidates.end());
+    return;
+  }
+
+  //Walk the grid along the line's longer axis. In each column (or row) the strip
+  //within reach of the line spans the line's extent across the column, widened
+  //by reach over the cosine of the line's angle to the axis
+  double reach = distance + padding_;
+  bool along_x = std::abs(dx) >= std::abs(dy);
+  double slope = along_x ? dy / dx : dx / dy;
+  double widening = reach * std::sqrt(1 + slope * slope);
+  double start = along_x ? min_x_ : min_y_, cross_start = along_x ? min_y_ : min_x_;
+  double origin = along_x ? x : y, cross_origin = along_x ? y : x;
+  size_t lines = along_x ? cells_x_ : cells_y_, cross_cells = along_x ? cells_y_ : cells_x_;
+
+  size_t first_candidate = candidates.size();
+  for(size_t line = 0; line < lines; ++line) {
+    double near = cross_origin + (start + line * cell_size_ - origin) * slope;
+    double far = near + cell_size_ * slope;
+    double low = std::min(near, far) - widening, high = std::max(near, far) + widening;
+    if(high < cross_start || low > cross_start + cross_cells * cell_size_) {
+      continue;
+    }
+    size_t first = CellCoordinate(low, cross_start, cross_cells);
+    size_t last = CellCoordinate(high, cross_start, cross_cells);
+    if(along_x) {
+      AppendColumn(line, first, last, candidates);
+    } else {
+      size_t row = line * cells_x_;
+      candidates.insert(candidates.end(),
+                        indices_.begin() + cell_start_[row + first],
+                        indices_.begin() + cell_start_[row + last + 1]);
+    }
+  }
+  std::sort(candidates.begin() + first_candidate, candidates.end());
+}
+
+void SpatialGrid::AppendColumn(size_t cell_x, size_t first_y, size_t last_y,
+                               std::vector<size_t>& candidates) const {
+  for(size_t cell_y = first_y; cell_y <= last_y; ++cell_y) {
+    size_t cell = cell_y * cells_x_ + cell_x;
+    candidates.insert(candidates.end(),
+                      indices_.begin() + cell_start_[cell],
+                      indices_.begin() + cell_start_[cell + 1]);
+  }
+}
+
+bool SpatialGrid::CellRange(double x, double y, double radius, size_t& first_x,
+                            size_t& last_x, size_t& first_y, size_t& last_y) const {
+  if(indices_.empty()) {
+    return false;
+  }
+
+  //Range of cells overlapping the query square, skipped if entirely off the grid
+  double reach = radius + padding_;
+  double grid_width = cells_x_ * cell_size_, grid_height = cells_y_ * cell_size_;
+  if(x + reach < min_x_ || x - reach > min_x_ + grid_width ||
+     y + reach < min_y_ || y - reach > min_y_ + grid_height) {
+    return false;
+  }
+  first_x = CellCoordinate(x - reach, min_x_, cells_x_);
+  last_x = CellCoordinate(x + reach, min_x_, cells_x_);
+  first_y = CellCoordinate(y - reach, min_y_, cells_y_);
+  last_y = CellCoordinate(y + reach, min_y_, cells_y_);
+  return true;
+}
+
+size_t SpatialGrid::CellCoordinate(double coordinate, double min, size_t cells) const {
+  double cell = (coordinate - min) / cell_size_;
+  if(cell <= 0) {
+    return 0;
+  }
+  return std::min((size_t)cell, cells - 1);
+}
+
+double SpatialGrid::GetCellSize() const {
+  return cell_size_;
+}
+size_t SpatialGrid::GetCellCount() const {
+  return cells_x_ * cells_y_;
+}
+
+const std::vector<size_t>& SpatialGrid::GetCellOrder() const {
+  return indices_;
+}
+
+uint64_t SpatialGrid::GetBuildId() const {
+  return build_id_;
+}
+
+template void SpatialGrid::Rebuild(const BasicFlockState<double, 3>&, double);
+template void SpatialGrid::Rebuild(const BasicFlockState<float, 2>&, double);
+template void SpatialGrid::Rebuild(const std::vector<BasicBoid<double, 3>>&, double);
+template void SpatialGrid::Rebuild(const std::vector<BasicBoid<float, 2>>&, double);
+
+}  // namespace boidsimulation
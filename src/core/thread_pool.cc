@@ -0,0 +1,93 @@
+#include <core/thread_pool.h>
+#include <algorithm>
+
+namespace boidsimulation {
+
+ThreadPool::ThreadPool(size_t thread_count) : next_chunk_(0) {
+  if(thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  //The calling thread is the remaining worker
+  for(size_t current = 1; current < thread_count; ++current) {
+    workers_.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  start_condition_.notify_all();
+  for(auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t chunk_size,
+                             const std::function<void(size_t, size_t)>& task) {
+  if(count == 0) {
+    return;
+  }
+  chunk_size = std::max<size_t>(chunk_size, 1);
+  //Not worth waking the workers for a single chunk
+  if(workers_.empty() || count <= chunk_size) {
+    task(0, count);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    count_ = count;
+    chunk_size_ = chunk_size;
+    next_chunk_ = 0;
+    busy_workers_ = workers_.size();
+    ++generation_;
+  }
+  start_condition_.notify_all();
+
+  RunChunks();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_condition_.wait(lock, [this] { return busy_workers_ == 0; });
+  task_ = nullptr;
+}
+
+size_t ThreadPool::GetThreadCount() const {
+  return workers_.size() + 1;
+}
+
+void ThreadPool::WorkerLoop() {
+  size_t seen_generation = 0;
+  while(true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_condition_.wait(lock, [&] {
+        return stopping_ || generation_ != seen_generation;
+      });
+      if(stopping_) {
+        return;
+      }
+      seen_generation = generation_;
+    }
+
+    RunChunks();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --busy_workers_;
+    }
+    done_condition_.notify_one();
+  }
+}
+
+void ThreadPool::RunChunks() {
+  size_t chunk_count = (count_ + chunk_size_ - 1) / chunk_size_;
+  for(size_t chunk = next_chunk_++; chunk < chunk_count; chunk = next_chunk_++) {
+    size_t begin = chunk * chunk_size_;
+    (*task_)(begin, std::min(begin + chunk_size_, count_));
+  }
+}
+
+}  // namespace boidsimulation
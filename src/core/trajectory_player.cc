@@ -0,0 +1,209 @@
+#include <core/trajectory_player.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace boidsimulation {
+
+bool TrajectoryPlayer::Open(const std::string& path) {
+  Close();
+  if(!file_.OpenRead(path) || file_.GetSize() < sizeof(TrajectoryHeader)) {
+    Close();
+    return false;
+  }
+  std::memcpy(&header_, file_.GetData(), sizeof(header_));
+  if(std::memcmp(header_.magic, kTrajectoryMagic, sizeof(kTrajectoryMagic)) != 0 ||
+     header_.version != kTrajectoryVersion) {
+    Close();
+    return false;
+  }
+
+  //Use the footer's index when the recording was closed, otherwise walk the frames
+  TrajectoryFooter footer = TrajectoryFooter();
+  size_t size = file_.GetSize();
+  if(size >= sizeof(TrajectoryHeader) + sizeof(TrajectoryFooter)) {
+    std::memcpy(&footer, file_.GetData() + size - sizeof(footer), sizeof(footer));
+  }
+  if(std::memcmp(footer.magic, kTrajectoryIndexMagic, sizeof(kTrajectoryIndexMagic)) == 0 &&
+     footer.index_offset <= size - sizeof(footer) &&
+     footer.frame_count == (size - sizeof(footer) - footer.index_offset) / sizeof(uint64_t)) {
+    index_offset_ = footer.index_offset;
+    frame_count_ = footer.frame_count;
+  } else {
+    ScanFrames();
+  }
+
+  if(frame_count_ > 0 && !SeekFrame(0)) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void TrajectoryPlayer::ScanFrames() {
+  size_t end = file_.GetSize();
+  uint64_t offset = sizeof(TrajectoryHeader);
+  TrajectoryFrameHeader frame_header;
+  uint64_t previous_step = 0;
+  while(offset + sizeof(frame_header) <= end) {
+    std::memcpy(&frame_header, file_.GetData() + offset, sizeof(frame_header));
+    //Stops at a partly written frame or at anything that does not follow on
+    if(offset + sizeof(frame_header) + frame_header.payload_bytes > end ||
+       frame_header.since_keyframe > scanned_offsets_.size() ||
+       (!scanned_offsets_.empty() && frame_header.step <= previous_step)) {
+      break;
+    }
+    previous_step = frame_header.step;
+    scanned_offsets_.push_back(offset);
+    offset += sizeof(frame_header) + frame_header.payload_bytes;
+  }
+  index_offset_ = 0;
+  frame_count_ = scanned_offsets_.size();
+}
+
+void TrajectoryPlayer::Close() {
+  file_.Close();
+  header_ = TrajectoryHeader();
+  index_offset_ = 0;
+  scanned_offsets_.clear();
+  frame_count_ = 0;
+  current_frame_ = 0;
+  decoded_ = false;
+  boids_.Clear();
+  predators_.Clear();
+}
+
+bool TrajectoryPlayer::IsOpen() const {
+  return file_.IsOpen();
+}
+
+size_t TrajectoryPlayer::GetFrameCount() const {
+  return frame_count_;
+}
+
+bool TrajectoryPlayer::SeekFrame(size_t frame) {
+  if(frame >= frame_count_) {
+    return false;
+  }
+  //The next frame is a delta from the current one unless it starts a keyframe
+  TrajectoryFrameHeader frame_header = ReadFrameHeader(frame);
+  bool next = decoded_ && frame == current_frame_ + 1 && frame_header.since_keyframe != 0;
+  size_t first = next ? frame : frame - std::min<size_t>(frame, frame_header.since_keyframe);
+  if(!next && ReadFrameHeader(first).since_keyframe != 0) {
+    return false;
+  }
+
+  decoded_ = false;
+  for(size_t current = first; current <= frame; ++current) {
+    if(!DecodeFrame(current)) {
+      return false;
+    }
+  }
+  decoded_ = true;
+  current_frame_ = frame;
+  return true;
+}
+
+bool TrajectoryPlayer::DecodeFrame(size_t frame) {
+  TrajectoryFrameHeader frame_header = ReadFrameHeader(frame);
+  size_t boid_count = frame_header.boid_count, predator_count = frame_header.predator_count;
+  size_t count = (boid_count + predator_count) * kTrajectoryValuesPerBoid;
+  uint64_t offset = FrameOffset(frame);
+  //Offsets come from the file, so they are checked without sums that could
+  //wrap. Every value takes at least one byte, which bounds the Boid counts
+  //before values_ is sized by them
+  size_t size = file_.GetSize();
+  if(offset > size || size - offset < sizeof(frame_header) ||
+     frame_header.payload_bytes > size - offset - sizeof(frame_header) ||
+     count > frame_header.payload_bytes) {
+    return false;
+  }
+  const uint8_t* data = file_.GetData() + offset + sizeof(frame_header);
+  const uint8_t* end = data + frame_header.payload_bytes;
+
+  //A payload ending mid varint could be read past, so it is rejected up front
+  bool keyframe = frame_header.since_keyframe == 0;
+  if((data < end && (end[-1] & 0x80)) || (!keyframe && values_.size() != count)) {
+    return false;
+  }
+  if(keyframe) {
+    values_.assign(count, 0);
+  }
+  for(auto& value : values_) {
+    if(data >= end) {
+      return false;
+    }
+    value += ReadVarint(data);
+  }
+
+  //Every Boid shares its type's species, so only the counts need rebuilding
+  Species boid_species, predator_species;
+  boid_species.size = boid_size_;
+  predator_species.size = predator_size_;
+  predator_species.color = Color(255,10,10);
+  predator_species.predator = true;
+  boids_.SetSpecies(0, boid_species);
+  predators_.SetSpecies(0, predator_species);
+  if(boids_.Size() != boid_count) {
+    boids_.Clear();
+    boids_.Add(MathVector(), MathVector(), 0, boid_count);
+  }
+  if(predators_.Size() != predator_count) {
+    predators_.Clear();
+    predators_.Add(MathVector(), MathVector(), 0, predator_count);
+  }
+  double position_resolution = header_.position_resolution;
+  double velocity_resolution = header_.velocity_resolution;
+  for(size_t index = 0; index < boid_count + predator_count; ++index) {
+    const int64_t* values = &values_[index * kTrajectoryValuesPerBoid];
+    FlockState& flock = index < boid_count ? boids_ : predators_;
+    size_t flock_index = index < boid_count ? index : index - boid_count;
+    flock.positions_[flock_index] = MathVector(values[0] * position_resolution,
+                                               values[1] * position_resolution, 0);
+    flock.velocities_[flock_index] = MathVector(values[2] * velocity_resolution,
+                                                values[3] * velocity_resolution, 0);
+  }
+  return true;
+}
+
+uint64_t TrajectoryPlayer::FrameOffset(size_t frame) const {
+  if(index_offset_ == 0) {
+    return scanned_offsets_[frame];
+  }
+  //The index follows variable length frames, so it may be unaligned
+  uint64_t offset;
+  std::memcpy(&offset, file_.GetData() + index_offset_ + frame * sizeof(uint64_t),
+              sizeof(offset));
+  return offset;
+}
+
+TrajectoryFrameHeader TrajectoryPlayer::ReadFrameHeader(size_t frame) const {
+  TrajectoryFrameHeader frame_header = TrajectoryFrameHeader();
+  uint64_t offset = FrameOffset(frame);
+  if(offset <= file_.GetSize() && file_.GetSize() - offset >= sizeof(frame_header)) {
+    std::memcpy(&frame_header, file_.GetData() + offset, sizeof(frame_header));
+  }
+  return frame_header;
+}
+
+size_t TrajectoryPlayer::GetCurrentFrame() const {
+  return current_frame_;
+}
+
+uint64_t TrajectoryPlayer::GetStep() const {
+  return decoded_ ? ReadFrameHeader(current_frame_).step : 0;
+}
+
+void TrajectoryPlayer::SetSizes(double boid_size, double predator_size) {
+  boid_size_ = boid_size;
+  predator_size_ = predator_size;
+}
+
+const FlockState& TrajectoryPlayer::GetBoids() const {
+  return boids_;
+}
+const FlockState& TrajectoryPlayer::GetPredators() const {
+  return predators_;
+}
+
+}  // namespace boidsimulation
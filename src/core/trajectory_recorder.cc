@@ -0,0 +1,208 @@
+#include <core/trajectory_recorder.h>
+#include <core/trajectory_format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace boidsimulation {
+
+TrajectoryRecorder::TrajectoryRecorder(const RecorderOptions& options) :
+      options_(options) {}
+
+TrajectoryRecorder::~TrajectoryRecorder() {
+  Close();
+}
+
+bool TrajectoryRecorder::Open(const std::string& path) {
+  Close();
+  file_ = fopen(path.c_str(), "wb");
+  if(file_ == nullptr) {
+    return false;
+  }
+  //Frames are small writes, so batch them into large ones
+  setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+
+  TrajectoryHeader header = TrajectoryHeader();
+  std::memcpy(header.magic, kTrajectoryMagic, sizeof(kTrajectoryMagic));
+  header.version = kTrajectoryVersion;
+  header.keyframe_interval = std::max<uint32_t>(1, options_.keyframe_interval);
+  header.position_resolution = options_.position_resolution;
+  header.velocity_resolution = options_.velocity_resolution;
+  write_failed_ = fwrite(&header, sizeof(header), 1, file_) != 1;
+  offset_ = write_failed_ ? 0 : sizeof(header);
+
+  stats_ = RecorderStats();
+  stats_.bytes_written = offset_;
+  stats_.write_failed = write_failed_;
+  frames_.assign(std::max<size_t>(1, options_.frame_buffers), Frame());
+  free_frames_.clear();
+  queued_frames_.clear();
+  for(size_t index = 0; index < frames_.size(); ++index) {
+    free_frames_.push_back(index);
+  }
+  frame_offsets_.clear();
+  since_keyframe_ = 0;
+  closing_ = false;
+  writer_ = std::thread(&TrajectoryRecorder::WriterLoop, this);
+  return true;
+}
+
+bool TrajectoryRecorder::Record(const World& world) {
+  size_t slot;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(file_ == nullptr || closing_) {
+      return false;
+    }
+    uint64_t step = stats_.steps++;
+    if(!free_frames_.empty()) {
+      slot = free_frames_.front();
+      free_frames_.pop_front();
+    } else if(options_.policy == BackpressurePolicy::kDropOldest && !queued_frames_.empty()) {
+      slot = queued_frames_.front();
+      queued_frames_.pop_front();
+      ++stats_.dropped;
+    } else {
+      ++stats_.dropped;
+      return false;
+    }
+    frames_[slot].step = step;
+  }
+
+  //Copied outside the lock; the slot belongs to this thread until it is queued
+  Frame& frame = frames_[slot];
+  const FlockState& boids = world.GetBoids();
+  const FlockState& predators = world.GetPredators();
+  frame.boid_count = boids.Size();
+  frame.positions.assign(boids.positions_.begin(), boids.positions_.end());
+  frame.positions.insert(frame.positions.end(), predators.positions_.begin(),
+                         predators.positions_.end());
+  frame.velocities.assign(boids.velocities_.begin(), boids.velocities_.end());
+  frame.velocities.insert(frame.velocities.end(), predators.velocities_.begin(),
+                          predators.velocities_.end());
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queued_frames_.push_back(slot);
+  }
+  queued_condition_.notify_one();
+  return true;
+}
+
+void TrajectoryRecorder::WriterLoop() {
+  while(true) {
+    size_t slot;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      queued_condition_.wait(lock, [this]() { return closing_ || !queued_frames_.empty(); });
+      if(queued_frames_.empty()) {
+        return;
+      }
+      slot = queued_frames_.front();
+      queued_frames_.pop_front();
+    }
+
+    WriteFrame(frames_[slot]);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_frames_.push_back(slot);
+  }
+}
+
+void TrajectoryRecorder::WriteFrame(const Frame& frame) {
+  if(write_failed_) {
+    return;
+  }
+  uint32_t boid_count = (uint32_t)frame.boid_count;
+  uint32_t predator_count = (uint32_t)(frame.positions.size() - frame.boid_count);
+
+  //Quantize every value to whole resolution steps
+  double position_scale = 1 / options_.position_resolution;
+  double velocity_scale = 1 / options_.velocity_resolution;
+  values_.resize(frame.positions.size() * kTrajectoryValuesPerBoid);
+  for(size_t index = 0; index < frame.positions.size(); ++index) {
+    int64_t* values = &values_[index * kTrajectoryValuesPerBoid];
+    values[0] = std::llround(frame.positions[index].x_ * position_scale);
+    values[1] = std::llround(frame.positions[index].y_ * position_scale);
+    values[2] = std::llround(frame.velocities[index].x_ * velocity_scale);
+    values[3] = std::llround(frame.velocities[index].y_ * velocity_scale);
+  }
+
+  //Keyframes at the interval and whenever the Boid counts change
+  bool keyframe = frame_offsets_.empty() || boid_count != previous_boid_count_ ||
+                  predator_count != previous_predator_count_ ||
+                  since_keyframe_ + 1 >= std::max<uint32_t>(1, options_.keyframe_interval);
+  since_keyframe_ = keyframe ? 0 : since_keyframe_ + 1;
+  payload_.clear();
+  for(size_t index = 0; index < values_.size(); ++index) {
+    AppendVarint(keyframe ? values_[index] : values_[index] - previous_values_[index],
+                 payload_);
+  }
+  previous_values_.swap(values_);
+  previous_boid_count_ = boid_count;
+  previous_predator_count_ = predator_count;
+
+  TrajectoryFrameHeader header = {frame.step, boid_count, predator_count, since_keyframe_,
+                                  (uint32_t)payload_.size()};
+  if(fwrite(&header, sizeof(header), 1, file_) != 1 ||
+     fwrite(payload_.data(), 1, payload_.size(), file_) != payload_.size()) {
+    //Later frames would be encoded against one missing from the file
+    write_failed_ = true;
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.write_failed = true;
+    return;
+  }
+  frame_offsets_.push_back(offset_);
+  offset_ += sizeof(header) + payload_.size();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.frames_written;
+  stats_.bytes_written = offset_;
+}
+
+bool TrajectoryRecorder::Close() {
+  if(file_ == nullptr) {
+    return true;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closing_ = true;
+  }
+  queued_condition_.notify_one();
+  writer_.join();
+
+  TrajectoryFooter footer = TrajectoryFooter();
+  footer.frame_count = frame_offsets_.size();
+  footer.index_offset = offset_;
+  std::memcpy(footer.magic, kTrajectoryIndexMagic, sizeof(kTrajectoryIndexMagic));
+  bool index_written =
+      !write_failed_ &&
+      fwrite(frame_offsets_.data(), sizeof(uint64_t), frame_offsets_.size(), file_) ==
+          frame_offsets_.size() &&
+      fwrite(&footer, sizeof(footer), 1, file_) == 1;
+  //Buffered writes may only fail here, when the last of them are flushed
+  bool closed = fclose(file_) == 0;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if(index_written && closed) {
+    stats_.bytes_written = offset_ + frame_offsets_.size() * sizeof(uint64_t) + sizeof(footer);
+  } else {
+    write_failed_ = true;
+    stats_.write_failed = true;
+  }
+  file_ = nullptr;
+  return !write_failed_;
+}
+
+bool TrajectoryRecorder::IsOpen() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return file_ != nullptr;
+}
+
+RecorderStats TrajectoryRecorder::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+}  // namespace boidsimulation
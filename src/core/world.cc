@@ -0,0 +1,542 @@
+#include <core/world.h>
+#include <core/profiler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace boidsimulation {
+
+namespace {
+
+//FNV-1a offset basis and prime
+const uint64_t kHashBasis = 14695981039346656037ull;
+const uint64_t kHashPrime = 1099511628211ull;
+
+/**
+ * Folds the bytes of count values into the FNV-1a hash.
+ */
+template <typename Value>
+void HashBytes(const Value* values, size_t count, uint64_t& hash) {
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+  for(size_t index = 0; index < count * sizeof(Value); ++index) {
+    hash = (hash ^ bytes[index]) * kHashPrime;
+  }
+}
+
+template <typename Value>
+void HashValue(const Value& value, uint64_t& hash) {
+  HashBytes(&value, 1, hash);
+}
+
+template <typename Value>
+void HashValues(const std::vector<Value>& values, uint64_t& hash) {
+  HashBytes(values.data(), values.size(), hash);
+}
+
+}  // namespace
+
+template <typename T, size_t N>
+BasicWorld<T, N>::BasicWorld(double min_x, double min_y, double width, double height,
+                             size_t boid_num, size_t pred_num,
+                             const WorldParameters& parameters, uint64_t seed) :
+      min_x_(min_x), min_y_(min_y), width_(width), height_(height),
+      random_(seed), parameters_(parameters) {
+  ApplyParameters();
+  //Spawn Boids based on initial specifications
+  InitializeBoids(boid_num, pred_num);
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::InitializeBoids(size_t boid_num, size_t pred_num) {
+  SpawnRegion region = {min_x_ + spawn_margin_, min_y_ + spawn_margin_,
+                        width_ - spawn_margin_, height_ - spawn_margin_};
+  SpawnBulk(boid_num, region);
+  SpawnBulk(pred_num, region, SpawnDistribution::kUniform, true);
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::SpawnBulk(size_t count, const SpawnRegion& region,
+                                 SpawnDistribution distribution, bool predator) {
+  FlockStateType& flock = predator ? predators_ : boids_;
+  double max_speed = predator ? parameters_.pred_max_speed : parameters_.boid_max_speed;
+  uint64_t first_draw = spawn_draw_;
+  spawn_draw_ += count * kDrawsPerBoid;
+  ResetSchedule();
+
+  //Every array grows once; the positions and velocities are then drawn in parallel
+  size_t first = flock.Size();
+  flock.Add(VectorType(), VectorType(), kSpecies, count);
+  ForEachChunk(count, [&](size_t begin, size_t end) {
+    for(size_t current = begin; current < end; ++current) {
+      uint64_t draw = first_draw + current * kDrawsPerBoid;
+      flock.positions_[first + current] = RandomPosition(region, distribution, draw);
+      flock.velocities_[first + current] = RandomVelocity(max_speed, draw + 2);
+    }
+  });
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::SetSeed(uint64_t seed) {
+  random_ = CounterRandom(seed);
+  spawn_draw_ = 0;
+}
+template <typename T, size_t N>
+uint64_t BasicWorld<T, N>::GetSeed() const {
+  return random_.GetSeed();
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::Update() {
+  BOIDSIMULATION_PROFILE_SCOPE("World Update");
+  ApplyParameters();
+  //Schedules assume Boids see and move no further than when they were made
+  const WorldParameters& scheduled = scheduled_parameters_;
+  if(parameters_.boid_size != scheduled.boid_size ||
+     parameters_.boid_max_speed != scheduled.boid_max_speed ||
+     parameters_.pred_size != scheduled.pred_size ||
+     parameters_.pred_max_speed != scheduled.pred_max_speed) {
+    ResetSchedule();
+    scheduled_parameters_ = parameters_;
+  }
+  dead_reckoned_ = 0;
+
+  if(double_buffered_ || thread_pool_ || deterministic_) {
+    //Every Boid reads the previous frame, so the grids need no padding
+    {
+      BOIDSIMULATION_PROFILE_SCOPE("Grid Rebuild");
+      boid_grid_.Rebuild(boids_);
+      predator_grid_.Rebuild(predators_);
+      //No Boid moves until the flock is stepped, so prey neighbors can be
+      //read in place from a copy in cell order
+      boids_.PackByCell(boid_grid_);
+    }
+
+    StepFlock(boids_, predators_, boid_grid_, predator_grid_,
+              next_boid_positions_, next_boid_velocities_, boid_quiet_until_);
+    StepFlock(predators_, boids_, predator_grid_, boid_grid_,
+              next_predator_positions_, next_predator_velocities_, predator_quiet_until_);
+    boids_.positions_.swap(next_boid_positions_);
+    boids_.velocities_.swap(next_boid_velocities_);
+    predators_.positions_.swap(next_predator_positions_);
+    predators_.velocities_.swap(next_predator_velocities_);
+  } else {
+    //Prey move during the prey loop before predators read them, so their grid
+    //queries are widened by how far a prey Boid can move in one step
+    {
+      BOIDSIMULATION_PROFILE_SCOPE("Grid Rebuild");
+      boid_grid_.Rebuild(boids_, parameters_.boid_max_speed);
+      predator_grid_.Rebuild(predators_);
+    }
+
+    StepFlock(boids_, predators_, boid_grid_, predator_grid_,
+              boids_.positions_, boids_.velocities_, boid_quiet_until_);
+    StepFlock(predators_, boids_, predator_grid_, boid_grid_,
+              predators_.positions_, predators_.velocities_, predator_quiet_until_);
+  }
+
+  //Check if Predators caught Prey
+  CheckPredatorCatch();
+  ++step_;
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::ApplyParameters() {
+  boids_.SetSpecies(kSpecies, MakeSpecies(false));
+  predators_.SetSpecies(kSpecies, MakeSpecies(true));
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::StepFlock(const FlockStateType& flock, const FlockStateType& opponents,
+                                 const SpatialGrid& grid, const SpatialGrid& opponent_grid,
+                                 std::vector<VectorType>& next_positions,
+                                 std::vector<VectorType>& next_velocities,
+                                 std::vector<uint64_t>& quiet_until) {
+  next_positions.resize(flock.Size());
+  next_velocities.resize(flock.Size());
+  quiet_until.resize(flock.Size(), 0);
+  bool adaptive = adaptive_interval_ > 1;
+  std::atomic<size_t> dead_reckoned(0);
+  ForEachChunk(flock.Size(), [&](size_t begin, size_t end) {
+    BOIDSIMULATION_PROFILE_SCOPE("Step Chunk");
+    size_t chunk_dead_reckoned = 0;
+    for(size_t index = begin; index < end; ++index) {
+      VectorType velocity = flock.velocities_[index];
+      double max_speed = flock.SpeciesOf(index).max_speed;
+      if(quiet_until[index] > step_ && velocity.Length() <= max_speed) {
+        //Nothing is in range, so a full update would keep the velocity too
+        next_positions[index] = flock.positions_[index] + velocity;
+        next_velocities[index] = velocity;
+        ++chunk_dead_reckoned;
+      } else {
+        //Update with flocking behavior
+        flock.UpdateBoid(index, opponents, obstacles_, obstacle_grid_, grid, opponent_grid,
+                         next_positions[index], next_velocities[index]);
+        //A Boid whose velocity changed had something in range, so only Boids
+        //the full update left alone pay for looking further
+        bool check = adaptive && next_velocities[index] == velocity;
+        size_t quiet_steps = check ? QuietSteps(flock, index, opponents, grid, opponent_grid,
+                                                next_velocities[index]) : 0;
+        quiet_until[index] = quiet_steps > 0 ? step_ + 1 + quiet_steps : 0;
+      }
+
+      //Checking if out of bounds
+      BOIDSIMULATION_PROFILE_TIME("Wall Bounding");
+      velocity = next_velocities[index];
+      WallBound(next_positions[index], next_velocities[index], max_speed);
+      if(!(next_velocities[index] == velocity)) {
+        quiet_until[index] = 0;
+      }
+    }
+    dead_reckoned += chunk_dead_reckoned;
+    BOIDSIMULATION_PROFILE_COUNT("Dead Reckoned", chunk_dead_reckoned);
+  });
+  dead_reckoned_ += dead_reckoned;
+}
+
+template <typename T, size_t N>
+size_t BasicWorld<T, N>::QuietSteps(const FlockStateType& flock, size_t index,
+                                    const FlockStateType& opponents, const SpatialGrid& grid,
+                                    const SpatialGrid& opponent_grid,
+                                    const VectorType& velocity) const {
+  const SpeciesType& species = flock.SpeciesOf(index);
+  double speed = velocity.Length();
+  if(speed > species.max_speed) {
+    return 0;
+  }
+
+  //Other Boids move at most sqrt(2) max speeds a step, the most a wall bounce
+  //gives them, while this one keeps its speed. Skipping steps steps is exact
+  //if the nearest Boid is more than steps + 1 closing steps outside sight; the
+  //extra step covers Boids updated in place seeing a mix of two frames
+  const double kSqrt2 = 1.4142135623730951;
+  double fastest = std::max(parameters_.boid_max_speed, parameters_.pred_max_speed);
+  double closing = speed + kSqrt2 * fastest;
+  double sight = std::max<double>(species.vision, 2.5 * species.size);
+  double reach = sight + (adaptive_interval_ + 1) * closing;
+  double too_close = sight + 2 * closing;
+  const VectorType& position = flock.positions_[index];
+
+  //Nearest Boid within reach, giving up once one is too close to skip any
+  //step. The grids were built before this step moved anything, so their
+  //queries are widened by one more step
+  double nearest_sq = reach * reach;
+  auto nearer = [&](const VectorType& other) {
+    nearest_sq = std::min<double>(nearest_sq, position.DistanceSquared(other));
+    return nearest_sq <= too_close * too_close;
+  };
+  if(grid.AnyCandidate(position, reach + 2 * fastest, [&](size_t other) {
+        return other != index && nearer(flock.positions_[other]);
+      }) ||
+     opponent_grid.AnyCandidate(position, reach + 2 * fastest, [&](size_t other) {
+        return nearer(opponents.positions_[other]);
+      })) {
+    return 0;
+  }
+  //Keeping its velocity keeps the Boid on one line, so an Obstacle that is not
+  //on its path now never will be
+  if(flock.AvoidObstacles(index, velocity, obstacles_, obstacle_grid_).LengthSquared() != 0) {
+    return 0;
+  }
+  //Nudged down so a Boid landing exactly on the edge of sight still counts
+  size_t steps = (size_t)((std::sqrt(nearest_sq) - sight) / closing - 1e-9) - 1;
+  return std::min(steps, adaptive_interval_ - 1);
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::SetAdaptiveInterval(size_t interval) {
+  adaptive_interval_ = std::max<size_t>(1, interval);
+  ResetSchedule();
+}
+template <typename T, size_t N>
+size_t BasicWorld<T, N>::GetAdaptiveInterval() const {
+  return adaptive_interval_;
+}
+
+template <typename T, size_t N>
+size_t BasicWorld<T, N>::GetDeadReckonedCount() const {
+  return dead_reckoned_;
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::ResetSchedule() {
+  boid_quiet_until_.clear();
+  predator_quiet_until_.clear();
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::SetDoubleBuffered(bool double_buffered) {
+  double_buffered_ = double_buffered;
+}
+template <typename T, size_t N>
+bool BasicWorld<T, N>::IsDoubleBuffered() const {
+  return double_buffered_;
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::SetDeterministic(bool deterministic) {
+  deterministic_ = deterministic;
+  SimdLevel level = deterministic ? SimdLevel::kScalar : DetectSimdLevel();
+  boids_.SetSimdLevel(level);
+  predators_.SetSimdLevel(level);
+}
+template <typename T, size_t N>
+bool BasicWorld<T, N>::IsDeterministic() const {
+  return deterministic_;
+}
+
+template <typename T, size_t N>
+uint64_t BasicWorld<T, N>::GetStateHash() const {
+  uint64_t hash = kHashBasis;
+  for(const FlockStateType* flock : {&boids_, &predators_}) {
+    HashValue((uint64_t)flock->Size(), hash);
+    HashValues(flock->positions_, hash);
+    HashValues(flock->velocities_, hash);
+    HashValues(flock->species_, hash);
+    //Field by field, as the struct's padding bytes are not set
+    HashValue((uint64_t)flock->species_table_.size(), hash);
+    for(const SpeciesType& species : flock->species_table_) {
+      for(T value : {species.size, species.vision, species.max_speed, species.separation_scale,
+                     species.alignment_scale, species.cohesion_scale, species.chase_scale,
+                     species.obstacle_scale}) {
+        HashValue(value, hash);
+      }
+      for(uint8_t value : {species.color.r_, species.color.g_, species.color.b_,
+                           (uint8_t)species.predator}) {
+        HashValue(value, hash);
+      }
+    }
+  }
+  for(auto& obstacle : obstacles_) {
+    HashValue(obstacle.GetPosition(), hash);
+    HashValue(obstacle.GetSize(), hash);
+  }
+  HashValue(step_, hash);
+  HashValue(spawn_draw_, hash);
+  return hash;
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::SetThreadCount(size_t thread_count) {
+  if(thread_count == 1) {
+    thread_pool_.reset();
+  } else {
+    thread_pool_.reset(new ThreadPool(thread_count));
+  }
+}
+template <typename T, size_t N>
+size_t BasicWorld<T, N>::GetThreadCount() const {
+  return thread_pool_ ? thread_pool_->GetThreadCount() : 1;
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::CheckPredatorCatch() {
+  BOIDSIMULATION_PROFILE_SCOPE("Catch Check");
+  catch_stats_.caught = 0;
+  catch_stats_.candidates = 0;
+  if(predators_.Empty() || boids_.Empty()) {
+    return;
+  }
+
+  //Prey have moved since Update built the grid, so index where they are now
+  boid_grid_.Rebuild(boids_);
+
+  //Mark every prey Boid within reach of a Predator, then remove them together
+  caught_.assign(boids_.Size(), false);
+  for(size_t pred = 0; pred < predators_.Size(); ++pred) {
+    const VectorType& pred_position = predators_.positions_[pred];
+    double reach = predators_.SpeciesOf(pred).size;
+    boid_grid_.ForEachCandidate(pred_position, reach, [&](size_t index) {
+      ++catch_stats_.candidates;
+      //checking if Boid is within reach of current Predator Boid
+      if(!caught_[index] &&
+         pred_position.DistanceSquared(boids_.positions_[index]) <= reach * reach) {
+        caught_[index] = true;
+        ++catch_stats_.caught;
+      }
+    });
+  }
+
+  BOIDSIMULATION_PROFILE_COUNT("Catch Candidates", catch_stats_.candidates);
+  if(catch_stats_.caught > 0) {
+    boids_.RemoveMarked(caught_);
+    //Removing prey only takes neighbors away, so the remaining schedule holds
+    if(boid_quiet_until_.size() == caught_.size()) {
+      size_t kept = 0;
+      for(size_t index = 0; index < caught_.size(); ++index) {
+        if(!caught_[index]) {
+          boid_quiet_until_[kept++] = boid_quiet_until_[index];
+        }
+      }
+      boid_quiet_until_.resize(kept);
+    }
+    catch_stats_.total_caught += catch_stats_.caught;
+  }
+}
+
+template <typename T, size_t N>
+const CatchStats& BasicWorld<T, N>::GetCatchStats() const {
+  return catch_stats_;
+}
+
+template <typename T, size_t N>
+template <typename Task>
+void BasicWorld<T, N>::ForEachChunk(size_t count, const Task& task) {
+  if(thread_pool_) {
+    thread_pool_->ParallelFor(count, kChunkSize, task);
+  } else {
+    task(0, count);
+  }
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::WallBound(const VectorType& position, VectorType& velocity,
+                                 double max_speed) const {
+  double left = min_x_, right = min_x_ + width_,
+      top = min_y_, bottom = min_y_ + height_;
+
+  if(position.x_ < left) {
+    velocity.x_ = T(max_speed);
+  } else if(position.x_ > right) {
+    velocity.x_ = T(-max_speed);
+  }
+
+  if(position.y_ < top) {
+    velocity.y_ = T(max_speed);
+  } else if(position.y_ > bottom) {
+    velocity.y_ = T(-max_speed);
+  }
+}
+
+template <typename T, size_t N>
+typename BasicWorld<T, N>::VectorType BasicWorld<T, N>::RandomVelocity(double max_speed,
+                                                                       uint64_t draw) const {
+  return MakeVector(random_.Uniform(draw, -max_speed, max_speed),
+                    random_.Uniform(draw + 1, -max_speed, max_speed));
+}
+
+template <typename T, size_t N>
+typename BasicWorld<T, N>::VectorType BasicWorld<T, N>::RandomPosition(
+    const SpawnRegion& region, SpawnDistribution distribution, uint64_t draw) const {
+  if(distribution == SpawnDistribution::kUniform) {
+    return MakeVector(random_.Uniform(draw, region.min_x, region.min_x + region.width),
+                      random_.Uniform(draw + 1, region.min_y, region.min_y + region.height));
+  }
+
+  //Box-Muller transform of two uniform draws into two standard normal values
+  const double kTwoPi = 6.283185307179586;
+  double radius = std::sqrt(-2 * std::log(1 - random_.Uniform(draw)));
+  double angle = kTwoPi * random_.Uniform(draw + 1);
+  double x = region.min_x + region.width * (0.5 + radius * std::cos(angle) / 6);
+  double y = region.min_y + region.height * (0.5 + radius * std::sin(angle) / 6);
+  return MakeVector(std::min(std::max(x, region.min_x), region.min_x + region.width),
+                    std::min(std::max(y, region.min_y), region.min_y + region.height));
+}
+
+template <typename T, size_t N>
+typename BasicWorld<T, N>::VectorType BasicWorld<T, N>::MakeVector(double x, double y) {
+  return VectorType(BasicVector<double, 2>(x, y));
+}
+
+template <typename T, size_t N>
+typename BasicWorld<T, N>::SpeciesType BasicWorld<T, N>::MakeSpecies(bool predator) const {
+  SpeciesType species;
+  if(predator) {
+    species.size = parameters_.pred_size;
+    species.max_speed = parameters_.pred_max_speed;
+    species.chase_scale = parameters_.chase;
+    species.color = Color(255,10,10);
+    species.predator = true;
+  } else {
+    species.size = parameters_.boid_size;
+    species.max_speed = parameters_.boid_max_speed;
+    species.separation_scale = parameters_.separation;
+    species.alignment_scale = parameters_.alignment;
+    species.cohesion_scale = parameters_.cohesion;
+  }
+  species.vision = 5 * species.size;
+  return species;
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::AddBoid(const VectorType& position, bool predator) {
+  double left = min_x_, right = min_x_ + width_,
+      top = min_y_, bottom = min_y_ + height_;
+  //Only spawn Boid if within World bounds
+  if(position.x_ > left && position.x_ < right &&
+     position.y_ > top && position.y_ < bottom) {
+    double max_speed = predator ? parameters_.pred_max_speed : parameters_.boid_max_speed;
+    VectorType velocity = RandomVelocity(max_speed, spawn_draw_ + 2);
+    spawn_draw_ += kDrawsPerBoid;
+    (predator ? predators_ : boids_).Add(position, velocity, kSpecies);
+    ResetSchedule();
+  }
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::AddObstacle(const VectorType& position) {
+  double size = parameters_.obstacle_size;
+  double left = min_x_ + size, right = min_x_ + width_ - size,
+      top = min_y_ + size, bottom = min_y_ + height_ - size;
+  //Only spawn Obstacle if within World bounds
+  if(position.x_ > left && position.x_ < right &&
+     position.y_ > top && position.y_ < bottom) {
+    obstacles_.push_back(Obstacle(MathVector(position), size));
+    obstacle_grid_.Rebuild(obstacles_);
+    ResetSchedule();
+  }
+}
+
+template <typename T, size_t N>
+void BasicWorld<T, N>::Clear() {
+  boids_.Clear();
+  predators_.Clear();
+  obstacles_.clear();
+  obstacle_grid_.Clear();
+  catch_stats_ = CatchStats();
+  ResetSchedule();
+}
+
+template <typename T, size_t N>
+WorldParameters& BasicWorld<T, N>::GetParameters() {
+  return parameters_;
+}
+template <typename T, size_t N>
+const WorldParameters& BasicWorld<T, N>::GetParameters() const {
+  return parameters_;
+}
+
+template <typename T, size_t N>
+const typename BasicWorld<T, N>::FlockStateType& BasicWorld<T, N>::GetBoids() const {
+  return boids_;
+}
+template <typename T, size_t N>
+const typename BasicWorld<T, N>::FlockStateType& BasicWorld<T, N>::GetPredators() const {
+  return predators_;
+}
+template <typename T, size_t N>
+const std::vector<Obstacle>& BasicWorld<T, N>::GetObstacles() const {
+  return obstacles_;
+}
+
+template <typename T, size_t N>
+double BasicWorld<T, N>::GetMinX() const {
+  return min_x_;
+}
+template <typename T, size_t N>
+double BasicWorld<T, N>::GetMinY() const {
+  return min_y_;
+}
+template <typename T, size_t N>
+double BasicWorld<T, N>::GetWidth() const {
+  return width_;
+}
+template <typename T, size_t N>
+double BasicWorld<T, N>::GetHeight() const {
+  return height_;
+}
+
+template class BasicWorld<double, 3>;
+template class BasicWorld<float, 2>;
+
+}  // namespace boidsimulation
@@ -1,4 +1,7 @@
 #include <visualizer/boid_simulation_app.h>
+#include <core/profiler.h>
+
+#include <algorithm>
 
 namespace boidsimulation {
 
@@ -12,32 +15,68 @@ BoidSimApp::BoidSimApp() : environment_(glm::vec2(0, 0),
 void BoidSimApp::setup() {
   ui = ci::params::InterfaceGl("Parameters", glm::vec2(175, 400));
 
+  WorldParameters& parameters = environment_.parameters_;
   ui.addParam("Spawn Predator", &environment_.spawn_predator_);
+  ui.addParam<bool>("Double Buffered",
+                    [this](bool double_buffered) {
+                      double_buffered_ = double_buffered;
+                      environment_.simulation_.Post([double_buffered](World& world) {
+                        world.SetDoubleBuffered(double_buffered);
+                      });
+                    },
+                    [this]() { return double_buffered_; });
+  ui.addParam<bool>("Simulation Thread",
+                    [this](bool threaded) {
+                      environment_.SetThreaded(threaded, kSimulationStepsPerSecond);
+                    },
+                    [this]() { return environment_.IsThreaded(); });
   ui.addText("Boid Parameters");
-  ui.addParam("Boid Size", &environment_.boid_size_,
+  ui.addParam("Boid Size", &parameters.boid_size,
               "min=5 max=15 step=0.5 keyIncr=s keyDecr=a");
-  ui.addParam("Boid Speed", &environment_.boid_max_speed_,
+  ui.addParam("Boid Speed", &parameters.boid_max_speed,
               "min=1 max=20 step=0.5 keyIncr=f keyDecr=d");
-  ui.addParam("Separation", &environment_.separation_,
+  ui.addParam("Separation", &parameters.separation,
               "min=0.1 max=5 step=0.2 keyIncr=x keyDecr=z");
-  ui.addParam("Alignment", &environment_.alignment_,
+  ui.addParam("Alignment", &parameters.alignment,
               "min=0.1 max=5 step=0.2 keyIncr=v keyDecr=c");
-  ui.addParam("Cohesion", &environment_.cohesion_,
+  ui.addParam("Cohesion", &parameters.cohesion,
               "min=0.1 max=5 step=0.2 keyIncr=n keyDecr=b");
   ui.addSeparator();
 
   ui.addText("Predator Parameters");
-  ui.addParam("Pred Size", &environment_.pred_size_,
+  ui.addParam("Pred Size", &parameters.pred_size,
               "min=5 max=25 step=0.5 keyIncr=w keyDecr=q");
-  ui.addParam("Predator Speed", &environment_.pred_max_speed_,
+  ui.addParam("Predator Speed", &parameters.pred_max_speed,
               "min=1 max=15 step=0.5 keyIncr=r keyDecr=e");
-  ui.addParam("Chase", &environment_.chase_,
+  ui.addParam("Chase", &parameters.chase,
               "min=1 max=50 step=0.5 keyIncr=y keyDecr=t");
   ui.addSeparator();
 
   ui.addText("Obstacle Parameters");
-  ui.addParam("Obstacle Size", &environment_.obstacle_size_,
+  ui.addParam("Obstacle Size", &parameters.obstacle_size,
               "min=5 max=50 step=0.5 keyIncr=l keyDecr=k");
+  ui.addSeparator();
+
+  ui.addButton("Save Snapshot", [this]() { environment_.SaveSnapshot(kSnapshotPath); });
+  ui.addButton("Load Snapshot", [this]() { environment_.LoadSnapshot(kSnapshotPath); });
+  ui.addButton("Replay Trajectory", [this]() { environment_.StartReplay(kTrajectoryPath); });
+  ui.addButton("Stop Replay", [this]() { environment_.StopReplay(); });
+  ui.addSeparator();
+
+  Profiler& profiler = Profiler::Get();
+  ui.addText("Profiling");
+  ui.addParam<bool>("Profile",
+                    [&profiler](bool enabled) { profiler.SetEnabled(enabled); },
+                    [&profiler]() { return profiler.IsEnabled(); });
+  ui.addButton("Export Trace", [this, &profiler]() { profiler.WriteChromeTrace(kTracePath); });
+  //Sized before any pointer into it is handed to the panel
+  profile_values_.assign(kProfiledTimers.size() + kProfiledCounters.size(), 0);
+  for(size_t index = 0; index < kProfiledTimers.size(); ++index) {
+    ui.addParam(kProfiledTimers[index] + " ms", &profile_values_[index], true);
+  }
+  for(size_t index = 0; index < kProfiledCounters.size(); ++index) {
+    ui.addParam(kProfiledCounters[index], &profile_values_[kProfiledTimers.size() + index], true);
+  }
 }
 
 void BoidSimApp::update() {
@@ -47,9 +86,26 @@ void BoidSimApp::update() {
 void BoidSimApp::draw() {
   ci::gl::clear(ci::Color("black"));
   environment_.Draw();
+  UpdateProfileSummary();
   ui.draw();
 }
 
+void BoidSimApp::UpdateProfileSummary() {
+  Profiler& profiler = Profiler::Get();
+  if(!profiler.IsEnabled()) {
+    return;
+  }
+  profiler.EndFrame();
+  std::fill(profile_values_.begin(), profile_values_.end(), 0.0f);
+  for(const ProfileSummary& entry : profiler.GetSummary()) {
+    const std::vector<std::string>& names = entry.timer ? kProfiledTimers : kProfiledCounters;
+    size_t index = std::find(names.begin(), names.end(), entry.name) - names.begin();
+    if(index < names.size()) {
+      profile_values_[(entry.timer ? 0 : kProfiledTimers.size()) + index] = (float)entry.per_frame;
+    }
+  }
+}
+
 void BoidSimApp::mouseDown(ci::app::MouseEvent event) {
   if(event.isLeftDown()) {
     environment_.AddBoid(event.getPos());
@@ -69,6 +125,11 @@ void BoidSimApp::mouseDrag(ci::app::MouseEvent event) {
 void BoidSimApp::keyDown(ci::app::KeyEvent event) {
   switch (event.getCode()) {
     case ci::app::KeyEvent::KEY_RIGHT:
+      environment_.SeekReplay(kReplaySeekFrames);
+      break;
+
+    case ci::app::KeyEvent::KEY_LEFT:
+      environment_.SeekReplay(-kReplaySeekFrames);
       break;
 
     case ci::app::KeyEvent::KEY_DELETE:
@@ -1,159 +1,127 @@
 #include <visualizer/environment.h>
+#include <core/profiler.h>
+#include <core/snapshot.h>
+
+#include <algorithm>
 
 namespace boidsimulation {
 
 namespace visualizer {
 
-using glm::vec2;
-
 Environment::Environment(const glm::vec2 &top_left_corner, double pixels_x, double pixels_y,
                          size_t boid_num, double boid_speed, double boid_size,
                          size_t pred_num, double pred_speed, double pred_size) :
-      top_left_corner_(top_left_corner), pixels_x_(pixels_x), pixels_y_(pixels_y),
-      boid_size_(boid_size), boid_max_speed_(boid_size),
-      pred_size_(pred_size), pred_max_speed_(pred_speed) {
-  //Spawn Boids based on initial specifications
-  InitializeBoids(boid_num, pred_num);
-}
-
-void Environment::InitializeBoids(size_t boid_num, size_t pred_num) {
-  for(size_t current = 0; current < boid_num; ++current) {
-    //Randomizing position and velocity
-    MathVector position(rand() % (int)(pixels_x_ + 1 - spawn_margin) + top_left_corner_.x + spawn_margin,
-                  rand() % (int)(pixels_y_ + 1 - spawn_margin) + top_left_corner_.y + spawn_margin, 0);
-    MathVector velocity(rand() % (2*(int)boid_max_speed_) - (int)boid_max_speed_,
-                                   rand() % (2*(int)boid_max_speed_) - (int)boid_max_speed_, 0);
-
-    boids_.push_back(boidsimulation::Boid(
-        position, velocity, boid_size_, 5*boid_size_, boid_max_speed_));
-  }
-
-  for(size_t current = 0; current < pred_num; ++current) {
-    //Randomizing position and velocity
-    MathVector position(rand() % (int)(pixels_x_ + 1 - spawn_margin) + top_left_corner_.x + spawn_margin,
-                        rand() % (int)(pixels_y_ + 1 - spawn_margin) + top_left_corner_.y + spawn_margin, 0);
-    MathVector velocity(rand() % (2*(int)pred_max_speed_) - (int)pred_max_speed_,
-                        rand() % (2*(int)pred_max_speed_) - (int)pred_max_speed_, 0);
-
-    predators_.push_back(boidsimulation::Boid(
-        position, velocity, pred_size_, 5*pred_size_,
-        pred_max_speed_, true, ci::Color8u(255,10,10)));
-  }
+      world_(top_left_corner.x, top_left_corner.y, pixels_x, pixels_y, boid_num, pred_num,
+             MakeParameters(boid_speed, boid_size, pred_speed, pred_size)),
+      parameters_(world_.GetParameters()), simulation_(world_) {}
+
+WorldParameters Environment::MakeParameters(double boid_speed, double boid_size,
+                                            double pred_speed, double pred_size) {
+  WorldParameters parameters;
+  parameters.boid_max_speed = boid_speed;
+  parameters.boid_size = boid_size;
+  parameters.pred_max_speed = pred_speed;
+  parameters.pred_size = pred_size;
+  return parameters;
 }
 
 void Environment::Update() {
-  for(auto& boid : boids_) {
-    //Updating parameters
-    boid.SetSize(boid_size_);
-    boid.SetMaxSpeed(boid_max_speed_);
-    boid.SetSeparationScale(separation_);
-    boid.SetAlignmentScale(alignment_);
-    boid.SetCohesionScale(cohesion_);
-    //Update with flocking behavior
-    boid.Update(boids_, predators_, obstacles_);
-    //Checking if out of bounds
-    WallBound(boid);
-  }
-  for(auto& pred : predators_) {
-    //Updating parameters
-    pred.SetSize(pred_size_);
-    pred.SetMaxSpeed(pred_max_speed_);
-    //Update with flocking behavior
-    pred.Update(boids_, predators_, obstacles_);
-    //Checking wall collisions
-    WallBound(pred);
+  BOIDSIMULATION_PROFILE_SCOPE("Environment Update");
+  if(simulation_.IsRunning()) {
+    //Only changes are posted; each post wakes a paused thread to publish a frame
+    if(parameters_ != posted_parameters_) {
+      WorldParameters parameters = parameters_;
+      simulation_.Post([parameters](World& world) { world.GetParameters() = parameters; });
+      posted_parameters_ = parameters_;
+    }
+  } else {
+    world_.GetParameters() = parameters_;
   }
 
-  //Check if Predators caught Prey
-  CheckPredatorCatch();
+  if(replay_.IsOpen()) {
+    size_t frame = replay_.GetCurrentFrame() + 1;
+    replay_.SeekFrame(frame < replay_.GetFrameCount() ? frame : 0);
+  } else if(!simulation_.IsRunning()) {
+    world_.Update();
+  }
 }
 
-void Environment::CheckPredatorCatch() {
-  for(auto& it : predators_) {
-    for(auto it2 = boids_.begin(); it2 != boids_.end();) {
-      //checking if other Boid is within reach of current Predator Boid
-      MathVector pred_position = it.GetPosition();
-      MathVector boid_position = it2->GetPosition();
-      double distance = pred_position.Distance(boid_position);
+void Environment::Draw() const {
+  BOIDSIMULATION_PROFILE_SCOPE("Draw");
+  //The simulation thread builds its frames' geometry itself
+  if(simulation_.IsRunning() && !replay_.IsOpen()) {
+    DrawGeometry(simulation_.AcquireFrame().geometry);
+    return;
+  }
 
-      //remove boid if caught or iterate forward
-      if(distance <= it.GetSize()) {
-        it2 = boids_.erase(it2);
-      } else {
-        ++it2;
-      }
-    }
+  //Boids, Predators and Obstacles are built into one vertex buffer on the CPU
+  {
+    BOIDSIMULATION_PROFILE_SCOPE("Build Geometry");
+    geometry_.Clear();
+    geometry_.AddFlock(replay_.IsOpen() ? replay_.GetBoids() : world_.GetBoids());
+    geometry_.AddFlock(replay_.IsOpen() ? replay_.GetPredators() : world_.GetPredators());
+    //The World belongs to the simulation thread while it runs, so its
+    //Obstacles are drawn from the latest frame
+    geometry_.AddObstacles(simulation_.IsRunning() ? simulation_.AcquireFrame().obstacles
+                                                   : world_.GetObstacles());
   }
+  DrawGeometry(geometry_);
 }
 
-void Environment::WallBound(boidsimulation::Boid &boid) {
-  double left = top_left_corner_.x, right = top_left_corner_.x + pixels_x_,
-      top = top_left_corner_.y, bottom = top_left_corner_.y + pixels_y_;
-
-  if(boid.GetPosition().x_ < left) {
-    boid.SetVelocity(boid.GetMaxSpeed(), boid.GetVelocity().y_, boid.GetVelocity().z_);
-  } else if(boid.GetPosition().x_ > right) {
-    boid.SetVelocity(-boid.GetMaxSpeed(), boid.GetVelocity().y_, boid.GetVelocity().z_);
+void Environment::DrawGeometry(const FlockGeometry& geometry) const {
+  size_t vertex_count = geometry.GetVertexCount();
+  if(vertex_count == 0) {
+    return;
   }
 
-  if(boid.GetPosition().y_ < top) {
-    boid.SetVelocity(boid.GetVelocity().x_, boid.GetMaxSpeed(), boid.GetVelocity().z_);
-  } else if(boid.GetPosition().y_ > bottom) {
-    boid.SetVelocity(boid.GetVelocity().x_, -boid.GetMaxSpeed(), boid.GetVelocity().z_);
+  //The GPU buffers only grow, so most frames just upload into them
+  if(!batch_ || mesh_->getNumVertices() < vertex_count) {
+    uint32_t capacity = std::max<uint32_t>(1024, 2 * (uint32_t)vertex_count);
+    std::vector<ci::gl::VboMesh::Layout> layouts = {
+        ci::gl::VboMesh::Layout().usage(GL_DYNAMIC_DRAW).attrib(ci::geom::POSITION, 2),
+        ci::gl::VboMesh::Layout().usage(GL_DYNAMIC_DRAW).attrib(ci::geom::COLOR, 3)};
+    mesh_ = ci::gl::VboMesh::create(capacity, GL_TRIANGLES, layouts);
+    batch_ = ci::gl::Batch::create(mesh_, ci::gl::getStockShader(ci::gl::ShaderDef().color()));
   }
+  mesh_->bufferAttrib(ci::geom::POSITION, vertex_count * sizeof(Vector2f),
+                      geometry.GetPositions().data());
+  mesh_->bufferAttrib(ci::geom::COLOR, vertex_count * sizeof(FlockGeometry::VertexColor),
+                      geometry.GetColors().data());
+  batch_->draw(0, (GLsizei)vertex_count);
 }
 
-void Environment::Draw() const {
-  //Drawing Boids
-  for(auto& boid : boids_) {
-    boid.Draw();
-  }
-  //Drawing Predators
-  for(auto& predator : predators_) {
-    predator.Draw();
-  }
-  //Drawing Obstacles
-  for(auto& obstacle : obstacles_) {
-    obstacle.Draw();
+void Environment::SetThreaded(bool threaded, double steps_per_second) {
+  if(threaded) {
+    world_.GetParameters() = parameters_;
+    posted_parameters_ = parameters_;
+    simulation_.SetPaused(replay_.IsOpen());
+    steps_per_second_ = steps_per_second;
+    simulation_.Start(steps_per_second_);
+  } else {
+    simulation_.Stop();
   }
 }
+bool Environment::IsThreaded() const {
+  return simulation_.IsRunning();
+}
 
 void Environment::AddBoid(const glm::vec2 &brush_screen_coords) {
-  double left = top_left_corner_.x, right = top_left_corner_.x + pixels_x_,
-      top = top_left_corner_.y, bottom = top_left_corner_.y + pixels_y_;
-  //Only spawn Boid if within environment bounds
-  if(brush_screen_coords.x > left && brush_screen_coords.x < right &&
-     brush_screen_coords.y > top && brush_screen_coords.y < bottom) {
-    MathVector position(brush_screen_coords.x, brush_screen_coords.y, 0);
-    //Randomizing velocity
-    if(!spawn_predator_) {
-      MathVector velocity(rand() % (2*(int)boid_max_speed_) - (int)boid_max_speed_,
-                          rand() % (2*(int)boid_max_speed_) - (int)boid_max_speed_, 0);
-
-      boids_.push_back(boidsimulation::Boid(position, velocity, boid_size_,
-                                            5*boid_size_, boid_max_speed_));
-    } else {
-      MathVector velocity(rand() % (2*(int)pred_max_speed_) - (int)pred_max_speed_,
-                          rand() % (2*(int)pred_max_speed_) - (int)pred_max_speed_, 0);
-
-      predators_.push_back(boidsimulation::Boid(
-          position, velocity, pred_size_, 5*pred_size_,
-          pred_max_speed_, true, ci::Color8u(255,10,10)));
-    }
-  }
+  MathVector position(brush_screen_coords.x, brush_screen_coords.y, 0);
+  bool predator = spawn_predator_;
+  simulation_.Post([position, predator](World& world) { world.AddBoid(position, predator); });
+}
+
+void Environment::SpawnBulk(size_t count, const SpawnRegion& region,
+                            SpawnDistribution distribution) {
+  bool predator = spawn_predator_;
+  simulation_.Post([count, region, distribution, predator](World& world) {
+    world.SpawnBulk(count, region, distribution, predator);
+  });
 }
 
 void Environment::AddObstacle(const glm::vec2& brush_screen_coords) {
-  double left = top_left_corner_.x + obstacle_size_ ,
-         right = top_left_corner_.x + pixels_x_ - obstacle_size_ ,
-         top = top_left_corner_.y + obstacle_size_,
-         bottom = top_left_corner_.y + pixels_y_ - obstacle_size_ ;
-  //Only spawn Obstacle if within tank bounds
-  if(brush_screen_coords.x > left && brush_screen_coords.x < right &&
-     brush_screen_coords.y > top && brush_screen_coords.y < bottom) {
-    MathVector position(brush_screen_coords.x, brush_screen_coords.y, 0);
-    obstacles_.push_back(Obstacle(position,obstacle_size_));
-  }
+  MathVector position(brush_screen_coords.x, brush_screen_coords.y, 0);
+  simulation_.Post([position](World& world) { world.AddObstacle(position); });
 }
 
 void Environment::SwitchBoidType() {
@@ -161,13 +129,71 @@ void Environment::SwitchBoidType() {
 }
 
 void Environment::Clear() {
-  boids_.clear();
-  predators_.clear();
-  obstacles_.clear();
+  simulation_.Post([](World& world) { world.Clear(); });
+}
+
+bool Environment::SaveSnapshot(const std::string& path) const {
+  //Snapshots are rare, so the simulation thread is simply stopped around them
+  bool threaded = simulation_.IsRunning();
+  simulation_.Stop();
+  bool saved = Snapshot::Save(world_, path);
+  if(threaded) {
+    simulation_.Start(steps_per_second_);
+  }
+  return saved;
 }
 
-const std::vector<boidsimulation::Boid> & Environment::GetBoids() const {
-  return boids_;
+bool Environment::LoadSnapshot(const std::string& path) {
+  bool threaded = simulation_.IsRunning();
+  simulation_.Stop();
+  bool loaded = Snapshot::Load(path, world_);
+  parameters_ = world_.GetParameters();
+  posted_parameters_ = parameters_;
+  if(threaded) {
+    simulation_.Start(steps_per_second_);
+  }
+  return loaded;
+}
+
+bool Environment::StartReplay(const std::string& path) {
+  replay_.SetSizes(parameters_.boid_size, parameters_.pred_size);
+  if(!replay_.Open(path)) {
+    return false;
+  }
+  simulation_.SetPaused(true);
+  return true;
+}
+
+void Environment::StopReplay() {
+  replay_.Close();
+  simulation_.SetPaused(false);
+}
+
+bool Environment::IsReplaying() const {
+  return replay_.IsOpen();
+}
+
+void Environment::SeekReplay(long frames) {
+  if(!replay_.IsOpen() || replay_.GetFrameCount() == 0) {
+    return;
+  }
+  long last = (long)replay_.GetFrameCount() - 1;
+  long frame = std::min(std::max((long)replay_.GetCurrentFrame() + frames, 0L), last);
+  replay_.SeekFrame((size_t)frame);
+}
+
+World& Environment::GetWorld() {
+  return world_;
+}
+const World& Environment::GetWorld() const {
+  return world_;
+}
+
+const CatchStats& Environment::GetCatchStats() const {
+  if(simulation_.IsRunning()) {
+    return simulation_.AcquireFrame().catch_stats;
+  }
+  return world_.GetCatchStats();
 }
 
 }  // namespace visualizer
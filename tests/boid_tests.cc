@@ -0,0 +1,270 @@
+#include <core/boid.h>
+#include <core/spatial_grid.h>
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cmath>
+
+using boidsimulation::Boid;
+using boidsimulation::Boid2f;
+using boidsimulation::MathVector;
+using boidsimulation::Obstacle;
+using boidsimulation::SpatialGrid;
+using boidsimulation::Vector2f;
+
+namespace {
+
+/**
+ * Creates a flock of boid_num Boids spread over a width x height area.
+ */
+std::vector<Boid> MakeFlock(size_t boid_num, double width, double height,
+                            bool is_pred = false, unsigned seed = 1) {
+  srand(seed);
+  std::vector<Boid> flock;
+  double size = is_pred ? 15 : 10;
+  for(size_t current = 0; current < boid_num; ++current) {
+    MathVector position(rand() % (int)width, rand() % (int)height, 0);
+    MathVector velocity(rand() % 16 - 8, rand() % 16 - 8, 0);
+    flock.push_back(Boid(position, velocity, size, 5*size, 8, is_pred));
+  }
+  return flock;
+}
+
+/**
+ * Copies flock into 2D single precision Boids.
+ */
+std::vector<Boid2f> Narrow(const std::vector<Boid>& flock) {
+  std::vector<Boid2f> narrowed;
+  for(auto& boid : flock) {
+    narrowed.push_back(Boid2f(Vector2f(boid.GetPosition()), Vector2f(boid.GetVelocity()),
+                              boid.GetSize(), boid.GetVision(), boid.GetMaxSpeed(),
+                              boid.IsPredator()));
+  }
+  return narrowed;
+}
+
+}  // namespace
+
+TEST_CASE("Spatial Grid") {
+  std::vector<Boid> flock = MakeFlock(300, 1000, 900);
+  SpatialGrid grid;
+  grid.Rebuild(flock);
+
+  SECTION("Cell size from vision") {
+    REQUIRE(grid.GetCellSize() == Approx(50));
+    REQUIRE(grid.GetCellCount() > 0);
+  }
+
+  SECTION("Candidates contain every neighbor in ascending order") {
+    for(auto& boid : flock) {
+      std::vector<size_t> candidates;
+      grid.QueryCandidates(boid.GetPosition(), 50, candidates);
+      REQUIRE(std::is_sorted(candidates.begin(), candidates.end()));
+
+      MathVector position = boid.GetPosition();
+      for(size_t other = 0; other < flock.size(); ++other) {
+        if(position.Distance(flock[other].GetPosition()) <= 50) {
+          REQUIRE(std::binary_search(candidates.begin(), candidates.end(), other));
+        }
+      }
+    }
+  }
+
+  SECTION("Empty flock") {
+    grid.Rebuild(std::vector<Boid>());
+    std::vector<size_t> candidates;
+    grid.QueryCandidates(MathVector(10, 10, 0), 50, candidates);
+    REQUIRE(candidates.empty());
+  }
+}
+
+TEST_CASE("Grid rules match brute force rules") {
+  std::vector<Boid> flock = MakeFlock(400, 600, 600);
+  std::vector<Boid> preds = MakeFlock(10, 600, 600, true, 2);
+  SpatialGrid flock_grid, pred_grid;
+  flock_grid.Rebuild(flock);
+  pred_grid.Rebuild(preds);
+
+  SECTION("Prey rules") {
+    for(auto& boid : flock) {
+      bool separation = boid.Separation(flock) == boid.Separation(flock, &flock_grid);
+      bool alignment = boid.Alignment(flock) == boid.Alignment(flock, &flock_grid);
+      bool cohesion = boid.Cohesion(flock) == boid.Cohesion(flock, &flock_grid);
+      bool chase = boid.Chase(preds) == boid.Chase(preds, &pred_grid);
+      REQUIRE(separation);
+      REQUIRE(alignment);
+      REQUIRE(cohesion);
+      REQUIRE(chase);
+    }
+  }
+
+  SECTION("Predator rules") {
+    for(auto& pred : preds) {
+      bool chase = pred.Chase(flock) == pred.Chase(flock, &flock_grid);
+      REQUIRE(chase);
+    }
+  }
+
+  SECTION("In place updates over several steps") {
+    std::vector<Boid> brute_flock = flock, brute_preds = preds;
+    std::vector<Obstacle> obstacles;
+    for(size_t step = 0; step < 20; ++step) {
+      flock_grid.Rebuild(flock, 8);
+      pred_grid.Rebuild(preds);
+      for(auto& boid : flock) {
+        boid.Update(flock, preds, obstacles, &flock_grid, &pred_grid);
+      }
+      for(auto& pred : preds) {
+        pred.Update(flock, preds, obstacles, &flock_grid, &pred_grid);
+      }
+      for(auto& boid : brute_flock) {
+        boid.Update(brute_flock, brute_preds, obstacles);
+      }
+      for(auto& pred : brute_preds) {
+        pred.Update(brute_flock, brute_preds, obstacles);
+      }
+    }
+
+    for(size_t index = 0; index < flock.size(); ++index) {
+      MathVector position = flock[index].GetPosition();
+      bool same = position == brute_flock[index].GetPosition();
+      REQUIRE(same);
+    }
+  }
+}
+
+TEST_CASE("Obstacle avoidance") {
+  std::vector<Boid> flock = MakeFlock(400, 600, 600);
+  std::vector<Obstacle> obstacles;
+  for(size_t current = 0; current < 60; ++current) {
+    //Off the whole number positions of the Boids so no Boid passes exactly r away
+    obstacles.push_back(Obstacle(MathVector(rand() % 600 + 0.3, rand() % 600 + 0.6, 0),
+                                 10 + rand() % 30));
+  }
+  SpatialGrid obstacle_grid;
+  obstacle_grid.Rebuild(obstacles);
+
+  SECTION("Falloff matches pow") {
+    for(double distance = 0.01; distance < 1e6; distance *= 1.7) {
+      REQUIRE(boidsimulation::AvoidanceFalloff(distance) ==
+              Approx(std::pow(distance, 1.35) + 1).epsilon(2e-6));
+    }
+    REQUIRE(boidsimulation::AvoidanceFalloff(0) == 1);
+  }
+
+  SECTION("Grid finds every Obstacle near the line of motion") {
+    size_t total_candidates = 0;
+    for(auto& boid : flock) {
+      if(boid.GetVelocity().LengthSquared() == 0) {
+        continue;
+      }
+      std::vector<size_t> candidates;
+      obstacle_grid.QueryLine(boid.GetPosition(), boid.GetVelocity(), boid.GetSize(),
+                              candidates);
+      REQUIRE(std::is_sorted(candidates.begin(), candidates.end()));
+      total_candidates += candidates.size();
+
+      MathVector direction = boid.GetVelocity() / boid.GetVelocity().Length();
+      for(size_t index = 0; index < obstacles.size(); ++index) {
+        MathVector difference = obstacles[index].GetPosition() - boid.GetPosition();
+        MathVector across = difference - (difference * direction) * direction;
+        if(across.Length() < obstacles[index].GetSize() + boid.GetSize()) {
+          REQUIRE(std::binary_search(candidates.begin(), candidates.end(), index));
+        }
+      }
+    }
+    REQUIRE(total_candidates < flock.size() * obstacles.size() / 2);
+  }
+
+  SECTION("Grid avoidance matches scanning every Obstacle") {
+    for(auto& boid : flock) {
+      bool same = boid.AvoidObstacles(obstacles) == boid.AvoidObstacles(obstacles, &obstacle_grid);
+      REQUIRE(same);
+    }
+  }
+
+  SECTION("Avoidance matches pow based force") {
+    for(auto& boid : flock) {
+      MathVector position = boid.GetPosition(), velocity = boid.GetVelocity();
+      MathVector reference;
+      for(auto& obstacle : obstacles) {
+        MathVector difference = obstacle.GetPosition() - position;
+        double s = difference.Length();
+        double k = (difference * velocity) / velocity.Length();
+        if(std::sqrt(std::pow(s, 2) - std::pow(k, 2)) < obstacle.GetSize() + boid.GetSize()) {
+          reference -= (obstacle.GetPosition() - (velocity + position)) /
+                       (std::pow(s, 1.35) + 1);
+        }
+      }
+      MathVector avoidance = boid.AvoidObstacles(obstacles, &obstacle_grid);
+      REQUIRE(avoidance.x_ == Approx(reference.x_).margin(1e-5));
+      REQUIRE(avoidance.y_ == Approx(reference.y_).margin(1e-5));
+    }
+  }
+}
+
+TEST_CASE("Fused flocking matches reference rules") {
+  std::vector<Boid> flock = MakeFlock(400, 600, 600);
+  std::vector<Boid> preds = MakeFlock(10, 600, 600, true, 2);
+  SpatialGrid flock_grid, pred_grid;
+  flock_grid.Rebuild(flock);
+  pred_grid.Rebuild(preds);
+
+  SECTION("Prey") {
+    for(auto& boid : flock) {
+      MathVector fused = boid.FlockingBehavior(flock, preds, &flock_grid, &pred_grid);
+      MathVector reference = boid.FlockingBehaviorReference(flock, preds);
+      REQUIRE(fused.x_ == Approx(reference.x_).margin(1e-9));
+      REQUIRE(fused.y_ == Approx(reference.y_).margin(1e-9));
+      REQUIRE(fused.z_ == Approx(reference.z_).margin(1e-9));
+    }
+  }
+
+  SECTION("Predators") {
+    for(auto& pred : preds) {
+      MathVector fused = pred.FlockingBehavior(flock, preds, &flock_grid, &pred_grid);
+      MathVector reference = pred.FlockingBehaviorReference(flock, preds);
+      REQUIRE(fused.x_ == Approx(reference.x_).margin(1e-9));
+      REQUIRE(fused.y_ == Approx(reference.y_).margin(1e-9));
+      REQUIRE(fused.z_ == Approx(reference.z_).margin(1e-9));
+    }
+  }
+}
+
+TEST_CASE("2D float Boids match 3D double Boids") {
+  std::vector<Boid> flock = MakeFlock(400, 600, 600);
+  std::vector<Boid> preds = MakeFlock(10, 600, 600, true, 2);
+  std::vector<Boid2f> flock_2f = Narrow(flock);
+  std::vector<Boid2f> preds_2f = Narrow(preds);
+  SpatialGrid flock_grid, pred_grid;
+  flock_grid.Rebuild(flock_2f);
+  pred_grid.Rebuild(preds_2f);
+
+  SECTION("Fused flocking matches reference rules") {
+    for(auto& boid : flock_2f) {
+      Vector2f fused = boid.FlockingBehavior(flock_2f, preds_2f, &flock_grid, &pred_grid);
+      Vector2f reference = boid.FlockingBehaviorReference(flock_2f, preds_2f);
+      REQUIRE(fused.x_ == Approx(reference.x_).margin(1e-3));
+      REQUIRE(fused.y_ == Approx(reference.y_).margin(1e-3));
+    }
+  }
+
+  SECTION("Flocking matches double precision") {
+    for(size_t index = 0; index < flock.size(); ++index) {
+      Vector2f single = flock_2f[index].FlockingBehavior(flock_2f, preds_2f,
+                                                         &flock_grid, &pred_grid);
+      MathVector reference = flock[index].FlockingBehavior(flock, preds);
+      REQUIRE(single.x_ == Approx(reference.x_).margin(1e-3));
+      REQUIRE(single.y_ == Approx(reference.y_).margin(1e-3));
+    }
+  }
+
+  SECTION("Walls only flip existing axes") {
+    Boid2f boid = flock_2f.front();
+    Vector2f velocity = boid.GetVelocity();
+    boid.WallCollide(1);
+    REQUIRE(boid.GetVelocity().y_ == -velocity.y_);
+    boid.WallCollide(2);
+    bool unchanged = boid.GetVelocity() == Vector2f(velocity.x_, -velocity.y_);
+    REQUIRE(unchanged);
+  }
+}
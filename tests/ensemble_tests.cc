@@ -0,0 +1,69 @@
+#include <core/ensemble.h>
+#include <catch2/catch.hpp>
+
+using boidsimulation::Ensemble;
+using boidsimulation::EnsembleMember;
+using boidsimulation::World;
+
+namespace {
+
+/**
+ * @return The settings of World index of a small parameter study.
+ */
+EnsembleMember MakeMember(size_t index) {
+  EnsembleMember member;
+  member.seed = 100 + index;
+  member.boid_num = 200;
+  member.parameters.separation = 0.5 + 0.25 * (index % 4);
+  member.parameters.cohesion = 0.5 + 0.5 * (index / 4);
+  member.parameters.chase = 10 + index;
+  return member;
+}
+
+}  // namespace
+
+TEST_CASE("Ensemble") {
+  const size_t kWorlds = 12;
+  Ensemble ensemble(500, 400, 4);
+  REQUIRE(ensemble.GetThreadCount() == 4);
+  for(size_t index = 0; index < kWorlds; ++index) {
+    REQUIRE(ensemble.AddWorld(MakeMember(index)) == index);
+  }
+  REQUIRE(ensemble.Size() == kWorlds);
+
+  SECTION("Worlds step as if they ran alone") {
+    ensemble.Step(30);
+    for(size_t index = 0; index < kWorlds; ++index) {
+      EnsembleMember member = MakeMember(index);
+      World alone(0, 0, 500, 400, member.boid_num, member.pred_num, member.parameters,
+                  member.seed);
+      for(size_t step = 0; step < 30; ++step) {
+        alone.Update();
+      }
+      REQUIRE(ensemble.GetWorld(index).GetStateHash() == alone.GetStateHash());
+    }
+    REQUIRE(ensemble.GetWorld(0).GetStateHash() != ensemble.GetWorld(1).GetStateHash());
+  }
+
+  SECTION("Each World keeps its own parameters") {
+    ensemble.Step();
+    for(size_t index = 0; index < kWorlds; ++index) {
+      const World& world = ensemble.GetWorld(index);
+      REQUIRE(world.GetBoids().SpeciesOf(0).separation_scale ==
+              MakeMember(index).parameters.separation);
+      REQUIRE(world.GetPredators().SpeciesOf(0).chase_scale == 10 + index);
+    }
+  }
+
+  SECTION("Throughput counts every World step") {
+    ensemble.Step(3);
+    ensemble.Step(2);
+    const boidsimulation::EnsembleStats& stats = ensemble.GetStats();
+    REQUIRE(stats.world_steps == 5 * kWorlds);
+    REQUIRE(stats.boid_updates >= 5 * kWorlds * 200);
+    REQUIRE(stats.boid_updates <= 5 * kWorlds * 202);
+    REQUIRE(stats.WorldStepsPerSecond() > 0);
+    ensemble.ResetStats();
+    REQUIRE(ensemble.GetStats().world_steps == 0);
+  }
+}
@@ -0,0 +1,68 @@
+#include <core/flock_geometry.h>
+#include <catch2/catch.hpp>
+
+using boidsimulation::Boid;
+using boidsimulation::Color;
+using boidsimulation::FlockGeometry;
+using boidsimulation::FlockState;
+using boidsimulation::MathVector;
+using boidsimulation::Obstacle;
+using boidsimulation::Vector2f;
+
+TEST_CASE("Flock geometry") {
+  FlockState flock;
+  flock.Add(Boid(MathVector(100, 200, 0), MathVector(3, 0, 0), 10, 50, 8, false,
+                 Color(255, 0, 51)));
+  flock.Add(Boid(MathVector(50, 50, 0), MathVector(0, -4, 0), 20));
+  FlockGeometry geometry;
+  geometry.AddFlock(flock);
+
+  SECTION("One triangle per Boid pointing along its velocity") {
+    REQUIRE(geometry.GetTriangleCount() == 2);
+    REQUIRE(geometry.GetVertexCount() == 6);
+    const std::vector<Vector2f>& positions = geometry.GetPositions();
+    bool head = positions[0] == Vector2f(115, 200);
+    bool left_tail = positions[1] == Vector2f(100, 192.5f);
+    bool right_tail = positions[2] == Vector2f(100, 207.5f);
+    bool second_head = positions[3] == Vector2f(50, 20);
+    REQUIRE(head);
+    REQUIRE(left_tail);
+    REQUIRE(right_tail);
+    REQUIRE(second_head);
+  }
+
+  SECTION("Colors are per vertex and normalized") {
+    const std::vector<FlockGeometry::VertexColor>& colors = geometry.GetColors();
+    for(size_t vertex = 0; vertex < 3; ++vertex) {
+      REQUIRE(colors[vertex].x_ == Approx(1));
+      REQUIRE(colors[vertex].y_ == Approx(0));
+      REQUIRE(colors[vertex].z_ == Approx(0.2));
+    }
+    REQUIRE(colors[3].x_ == Approx(1));
+  }
+
+  SECTION("Obstacles are triangle fans") {
+    std::vector<Obstacle> obstacles;
+    obstacles.push_back(Obstacle(MathVector(300, 300, 0), 25));
+    geometry.AddObstacles(obstacles);
+    REQUIRE(geometry.GetTriangleCount() == 2 + FlockGeometry::kCircleSegments);
+    const std::vector<Vector2f>& positions = geometry.GetPositions();
+    for(size_t vertex = 6; vertex < geometry.GetVertexCount(); vertex += 3) {
+      bool centered = positions[vertex] == Vector2f(300, 300);
+      REQUIRE(centered);
+      REQUIRE(positions[vertex + 1].Distance(Vector2f(300, 300)) == Approx(25));
+      REQUIRE(positions[vertex + 2].Distance(Vector2f(300, 300)) == Approx(25));
+    }
+  }
+
+  SECTION("Rebuilding reuses the buffers") {
+    const Vector2f* data = geometry.GetPositions().data();
+    for(size_t frame = 0; frame < 5; ++frame) {
+      geometry.Clear();
+      REQUIRE(geometry.GetVertexCount() == 0);
+      geometry.AddFlock(flock);
+    }
+    REQUIRE(geometry.GetVertexCount() == 6);
+    REQUIRE(geometry.GetPositions().data() == data);
+  }
+}
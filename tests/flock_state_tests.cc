@@ -0,0 +1,258 @@
+#include <core/flock_state.h>
+#include <core/spatial_grid.h>
+#include <catch2/catch.hpp>
+
+using boidsimulation::Boid;
+using boidsimulation::Boid2f;
+using boidsimulation::FlockState;
+using boidsimulation::FlockState2f;
+using boidsimulation::MathVector;
+using boidsimulation::Obstacle;
+using boidsimulation::SpatialGrid;
+using boidsimulation::Vector2f;
+
+namespace {
+
+/**
+ * Creates boid_num Boids spread over a size x size area and stores them in flock.
+ */
+std::vector<Boid> MakeFlock(size_t boid_num, double size, FlockState& flock,
+                            bool is_pred = false) {
+  std::vector<Boid> boids;
+  double boid_size = is_pred ? 15 : 10;
+  for(size_t current = 0; current < boid_num; ++current) {
+    MathVector position(rand() % (int)size, rand() % (int)size, 0);
+    MathVector velocity(rand() % 16 - 8, rand() % 16 - 8, 0);
+    boids.push_back(Boid(position, velocity, boid_size, 5*boid_size, 8, is_pred));
+    flock.Add(boids.back());
+  }
+  return boids;
+}
+
+}  // namespace
+
+TEST_CASE("FlockState storage") {
+  srand(3);
+  FlockState flock;
+  std::vector<Boid> boids = MakeFlock(20, 300, flock);
+  REQUIRE(flock.Size() == 20);
+
+  SECTION("GetBoid copies state back out") {
+    Boid boid = flock.GetBoid(7);
+    MathVector position = boid.GetPosition();
+    bool same = position == boids[7].GetPosition();
+    REQUIRE(same);
+    REQUIRE(boid.GetSize() == boids[7].GetSize());
+    REQUIRE(boid.GetVision() == boids[7].GetVision());
+    REQUIRE(boid.IsPredator() == boids[7].IsPredator());
+  }
+
+  SECTION("RemoveMarked keeps order") {
+    std::vector<char> marked(flock.Size(), false);
+    marked[0] = true;
+    marked[5] = true;
+    flock.RemoveMarked(marked);
+    REQUIRE(flock.Size() == 18);
+    bool first = flock.positions_[0] == boids[1].GetPosition();
+    bool shifted = flock.positions_[4] == boids[6].GetPosition();
+    REQUIRE(first);
+    REQUIRE(shifted);
+    REQUIRE(flock.species_.size() == 18);
+  }
+
+  SECTION("Boids with the same tunables share a species") {
+    REQUIRE(flock.species_table_.size() == 1);
+    Boid pred(MathVector(), MathVector(), 15, 75, 5, true);
+    flock.Add(pred);
+    REQUIRE(flock.species_table_.size() == 2);
+    REQUIRE(flock.species_.back() == 1);
+    REQUIRE(flock.GetBoid(20).IsPredator());
+
+    //Writing a species changes every Boid of it at once
+    FlockState::SpeciesType species = flock.species_table_[0];
+    species.max_speed = 3;
+    flock.SetSpecies(0, species);
+    REQUIRE(flock.GetBoid(4).GetMaxSpeed() == 3);
+    REQUIRE(flock.GetBoid(19).GetMaxSpeed() == 3);
+    REQUIRE(flock.GetBoid(20).GetMaxSpeed() == 5);
+  }
+
+  SECTION("Boids needing a species past the last are refused") {
+    //A copy, as REQUIRE binds its operands to references
+    const size_t kMaxSpecies = FlockState::kMaxSpecies;
+    //The flock already holds the species of size 10
+    for(size_t size = 11; size < 10 + kMaxSpecies; ++size) {
+      REQUIRE(flock.Add(Boid(MathVector(), MathVector(), (double)size)));
+    }
+    REQUIRE(flock.species_table_.size() == kMaxSpecies);
+    size_t count = flock.Size();
+
+    Boid extra(MathVector(), MathVector(), 10.0 + kMaxSpecies);
+    REQUIRE_FALSE(flock.Add(extra));
+    REQUIRE_FALSE(flock.Add(extra, 5));
+    FlockState::SpeciesType species;
+    species.size = 1000;
+    uint8_t index;
+    REQUIRE_FALSE(flock.AddSpecies(species, index));
+    REQUIRE(flock.AddSpecies(flock.species_table_[3], index));
+    REQUIRE(index == 3);
+    REQUIRE(flock.Size() == count);
+    REQUIRE(flock.species_table_.size() == kMaxSpecies);
+
+    //Existing species still take more Boids
+    REQUIRE(flock.Add(Boid(MathVector(), MathVector(), 11)));
+    REQUIRE(flock.species_.back() == 1);
+  }
+
+  SECTION("Clear") {
+    flock.Clear();
+    REQUIRE(flock.Empty());
+  }
+}
+
+TEST_CASE("FlockState rules match Boid rules") {
+  srand(4);
+  FlockState flock, preds;
+  std::vector<Boid> boids = MakeFlock(400, 600, flock);
+  std::vector<Boid> pred_boids = MakeFlock(10, 600, preds, true);
+  std::vector<Obstacle> obstacles;
+  obstacles.push_back(Obstacle(MathVector(300, 300, 0), 25));
+  obstacles.push_back(Obstacle(MathVector(100, 450, 0), 40));
+  SpatialGrid grid, pred_grid, obstacle_grid;
+  grid.Rebuild(flock);
+  pred_grid.Rebuild(preds);
+  obstacle_grid.Rebuild(obstacles);
+
+  SECTION("Flocking behavior") {
+    for(size_t index = 0; index < flock.Size(); ++index) {
+      MathVector soa = flock.FlockingBehavior(index, preds, grid, pred_grid);
+      MathVector reference = boids[index].FlockingBehaviorReference(boids, pred_boids);
+      REQUIRE(soa.x_ == Approx(reference.x_).margin(1e-9));
+      REQUIRE(soa.y_ == Approx(reference.y_).margin(1e-9));
+    }
+    for(size_t index = 0; index < preds.Size(); ++index) {
+      MathVector soa = preds.FlockingBehavior(index, flock, pred_grid, grid);
+      MathVector reference = pred_boids[index].FlockingBehaviorReference(boids, pred_boids);
+      REQUIRE(soa.x_ == Approx(reference.x_).margin(1e-9));
+      REQUIRE(soa.y_ == Approx(reference.y_).margin(1e-9));
+    }
+  }
+
+  SECTION("Update matches Boid::Update") {
+    for(size_t index = 0; index < flock.Size(); ++index) {
+      MathVector position, velocity;
+      flock.UpdateBoid(index, preds, obstacles, obstacle_grid, grid, pred_grid,
+                       position, velocity);
+      Boid boid = boids[index];
+      boid.Update(boids, pred_boids, obstacles);
+      REQUIRE(position.x_ == Approx(boid.GetPosition().x_).margin(1e-9));
+      REQUIRE(position.y_ == Approx(boid.GetPosition().y_).margin(1e-9));
+      REQUIRE(velocity.x_ == Approx(boid.GetVelocity().x_).margin(1e-9));
+      REQUIRE(velocity.y_ == Approx(boid.GetVelocity().y_).margin(1e-9));
+    }
+  }
+}
+
+TEST_CASE("Vectorized neighbor kernels match scalar Boid path") {
+  srand(5);
+  FlockState flock, preds;
+  std::vector<Boid> boids = MakeFlock(800, 500, flock);
+  std::vector<Boid> pred_boids = MakeFlock(8, 500, preds, true);
+  SpatialGrid grid, pred_grid;
+  grid.Rebuild(flock);
+  pred_grid.Rebuild(preds);
+
+  boidsimulation::SimdLevel levels[] = {boidsimulation::SimdLevel::kScalar,
+                                        boidsimulation::SimdLevel::kSse2,
+                                        boidsimulation::SimdLevel::kAvx2};
+  for(auto level : levels) {
+    if(!boidsimulation::IsSimdLevelSupported(level)) {
+      continue;
+    }
+    flock.SetSimdLevel(level);
+    REQUIRE(flock.GetSimdLevel() == level);
+    //Neighbors packed per Boid, then read in place from a copy in cell order
+    for(bool in_place : {false, true}) {
+      if(in_place) {
+        flock.PackByCell(grid);
+      }
+      for(size_t index = 0; index < flock.Size(); ++index) {
+        MathVector simd = flock.FlockingBehavior(index, preds, grid, pred_grid);
+        MathVector scalar = boids[index].FlockingBehavior(boids, pred_boids);
+        REQUIRE(simd.x_ == Approx(scalar.x_).margin(1e-9));
+        REQUIRE(simd.y_ == Approx(scalar.y_).margin(1e-9));
+        REQUIRE(simd.z_ == Approx(scalar.z_).margin(1e-9));
+      }
+    }
+  }
+
+  SECTION("A copy in cell order is dropped when the grid is rebuilt") {
+    flock.SetSimdLevel(boidsimulation::DetectSimdLevel());
+    flock.PackByCell(grid);
+    //Moving a Boid without repacking must not leave its old position in use
+    flock.positions_[0] += MathVector(7, -3, 0);
+    boids[0] = flock.GetBoid(0);
+    grid.Rebuild(flock);
+    for(size_t index = 0; index < flock.Size(); ++index) {
+      MathVector simd = flock.FlockingBehavior(index, preds, grid, pred_grid);
+      MathVector scalar = boids[index].FlockingBehavior(boids, pred_boids);
+      REQUIRE(simd.x_ == Approx(scalar.x_).margin(1e-9));
+      REQUIRE(simd.y_ == Approx(scalar.y_).margin(1e-9));
+    }
+  }
+}
+
+TEST_CASE("FlockState2f matches Boid2f") {
+  srand(6);
+  FlockState flock_3d, preds_3d;
+  MakeFlock(800, 500, flock_3d);
+  MakeFlock(8, 500, preds_3d, true);
+  FlockState2f flock, preds;
+  std::vector<Boid2f> boids, pred_boids;
+  for(size_t index = 0; index < flock_3d.Size(); ++index) {
+    Boid boid = flock_3d.GetBoid(index);
+    boids.push_back(Boid2f(Vector2f(boid.GetPosition()), Vector2f(boid.GetVelocity()),
+                           boid.GetSize(), boid.GetVision(), boid.GetMaxSpeed()));
+    flock.Add(boids.back());
+  }
+  for(size_t index = 0; index < preds_3d.Size(); ++index) {
+    Boid pred = preds_3d.GetBoid(index);
+    pred_boids.push_back(Boid2f(Vector2f(pred.GetPosition()), Vector2f(pred.GetVelocity()),
+                                pred.GetSize(), pred.GetVision(), pred.GetMaxSpeed(), true));
+    preds.Add(pred_boids.back());
+  }
+  REQUIRE(sizeof(flock.positions_[0]) == 2 * sizeof(float));
+
+  SpatialGrid grid, pred_grid;
+  grid.Rebuild(flock);
+  pred_grid.Rebuild(preds);
+  std::vector<Obstacle> obstacles;
+  obstacles.push_back(Obstacle(MathVector(250, 250, 0), 30));
+  SpatialGrid obstacle_grid;
+  obstacle_grid.Rebuild(obstacles);
+
+  boidsimulation::SimdLevel levels[] = {boidsimulation::SimdLevel::kScalar,
+                                        boidsimulation::SimdLevel::kSse2,
+                                        boidsimulation::SimdLevel::kAvx2};
+  for(auto level : levels) {
+    if(!boidsimulation::IsSimdLevelSupported(level)) {
+      continue;
+    }
+    flock.SetSimdLevel(level);
+    flock.PackByCell(grid);
+    for(size_t index = 0; index < flock.Size(); ++index) {
+      Vector2f simd = flock.FlockingBehavior(index, preds, grid, pred_grid);
+      Vector2f scalar = boids[index].FlockingBehavior(boids, pred_boids);
+      REQUIRE(simd.x_ == Approx(scalar.x_).margin(1e-3));
+      REQUIRE(simd.y_ == Approx(scalar.y_).margin(1e-3));
+
+      Vector2f position, velocity;
+      flock.UpdateBoid(index, preds, obstacles, obstacle_grid, grid, pred_grid,
+                       position, velocity);
+      Boid2f boid = boids[index];
+      boid.Update(boids, pred_boids, obstacles);
+      REQUIRE(position.x_ == Approx(boid.GetPosition().x_).margin(1e-3));
+      REQUIRE(position.y_ == Approx(boid.GetPosition().y_).margin(1e-3));
+    }
+  }
+}
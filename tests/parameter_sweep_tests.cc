@@ -0,0 +1,212 @@
+#include <core/parameter_sweep.h>
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using boidsimulation::ObstacleLayout;
+using boidsimulation::ParameterSweep;
+using boidsimulation::SweepConfig;
+using boidsimulation::SweepMetrics;
+using boidsimulation::SweepSpec;
+
+namespace {
+
+const char* kPath = "parameter_sweep_tests.csv";
+
+const char* kSpec =
+    "# A small sweep\n"
+    "width = 400\n"
+    "height = 300\n"
+    "steps = 20\n"
+    "boids = 60, 120\n"
+    "predators = 4\n"
+    "obstacles = none, ring\n"
+    "separation = 0.5:1.5:0.5   # three values\n"
+    "seeds = 1:2:1\n";
+
+std::string ReadText(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  std::stringstream text;
+  text << file.rdbuf();
+  return text.str();
+}
+
+void WriteText(const std::string& path, const std::string& text) {
+  std::ofstream file(path, std::ios::binary);
+  file << text;
+}
+
+/**
+ * @return The rows of a sweep's output sorted by run, without the header or
+ * the timing column, which differs between runs.
+ */
+std::vector<std::string> SortedRows(const std::string& text) {
+  std::istringstream lines(text);
+  std::string line;
+  std::vector<std::pair<size_t, std::string>> rows;
+  std::getline(lines, line);
+  while(std::getline(lines, line)) {
+    rows.emplace_back(std::stoul(line), line.substr(0, line.rfind(',')));
+  }
+  std::sort(rows.begin(), rows.end());
+  std::vector<std::string> sorted;
+  for(auto& row : rows) {
+    sorted.push_back(row.second);
+  }
+  return sorted;
+}
+
+}  // namespace
+
+TEST_CASE("Sweep specs") {
+  SweepSpec spec;
+  std::string error;
+  REQUIRE(SweepSpec::Parse(kSpec, spec, error));
+
+  SECTION("Lists and ranges are read") {
+    REQUIRE(spec.width == 400);
+    REQUIRE(spec.steps == 20);
+    REQUIRE(spec.boid_nums == std::vector<size_t>{60, 120});
+    REQUIRE(spec.obstacle_layouts ==
+            std::vector<ObstacleLayout>{ObstacleLayout::kNone, ObstacleLayout::kRing});
+    REQUIRE(spec.separations == std::vector<double>{0.5, 1, 1.5});
+    REQUIRE(spec.seeds == std::vector<uint64_t>{1, 2});
+    //Left out of the spec
+    REQUIRE(spec.cohesions == std::vector<double>{1});
+  }
+
+  SECTION("Ranges keep their stop despite rounding") {
+    REQUIRE(SweepSpec::Parse("chase = 0.1:0.3:0.1", spec, error));
+    REQUIRE(spec.chases.size() == 3);
+    REQUIRE(spec.chases[2] == Approx(0.3));
+  }
+
+  SECTION("Every combination is one run") {
+    REQUIRE(spec.ConfigCount() == 2 * 2 * 3 * 2);
+    SweepConfig first = spec.GetConfig(0);
+    REQUIRE(first.index == 0);
+    REQUIRE(first.seed == 1);
+    REQUIRE(first.boid_num == 60);
+    REQUIRE(first.parameters.separation == 0.5);
+
+    //Seeds vary fastest, boids slowest
+    REQUIRE(spec.GetConfig(1).seed == 2);
+    REQUIRE(spec.GetConfig(1).parameters.separation == 0.5);
+    REQUIRE(spec.GetConfig(2).parameters.separation == 1);
+    SweepConfig last = spec.GetConfig(spec.ConfigCount() - 1);
+    REQUIRE(last.boid_num == 120);
+    REQUIRE(last.obstacle_layout == ObstacleLayout::kRing);
+    REQUIRE(last.parameters.separation == 1.5);
+    REQUIRE(last.seed == 2);
+  }
+
+  SECTION("Sweeps too large to count are rejected") {
+    std::string text;
+    for(const char* name : {"separation", "alignment", "cohesion", "chase"}) {
+      text += std::string(name) + " = 1:100000:1\n";
+    }
+    //The fourth range takes the count past 2^53
+    REQUIRE_FALSE(SweepSpec::Parse(text, spec, error));
+    REQUIRE(error == "chase = 1:100000:1");
+  }
+
+  SECTION("Invalid specs are rejected and leave the spec unchanged") {
+    const char* kInvalid[] = {"boids = 10, many", "predators = 2.5", "obstacles = maze",
+                              "separation = 2:1:0.5", "separation =", "steps = 0",
+                              "steps = 2.5", "boids = 1e30", "seeds = 1:1e300:1",
+                              "chase = 0:1:1e-12", "speed = 3", "width"};
+    for(const char* invalid : kInvalid) {
+      std::string text = std::string("alignment = 3\n") + invalid + "\n";
+      REQUIRE_FALSE(SweepSpec::Parse(text, spec, error));
+      REQUIRE(error == invalid);
+      REQUIRE(spec.alignments == std::vector<double>{1});
+    }
+  }
+}
+
+TEST_CASE("Parameter sweeps") {
+  SweepSpec spec;
+  std::string error;
+  REQUIRE(SweepSpec::Parse(kSpec, spec, error));
+  std::remove(kPath);
+
+  SECTION("Metrics summarize the prey left") {
+    ParameterSweep sweep(spec);
+    SweepConfig config = spec.GetConfig(spec.ConfigCount() - 1);
+    SweepMetrics metrics = sweep.RunConfig(config);
+    REQUIRE(metrics.survivors + metrics.caught == config.boid_num);
+    REQUIRE(metrics.mean_speed > 0);
+    REQUIRE(metrics.mean_speed <= config.parameters.boid_max_speed + 1e-9);
+    REQUIRE(metrics.polarization >= 0);
+    REQUIRE(metrics.polarization <= 1 + 1e-9);
+    REQUIRE(metrics.spread > 0);
+  }
+
+  SECTION("Every run writes one row") {
+    ParameterSweep sweep(spec);
+    REQUIRE(sweep.Run(kPath, 3));
+    REQUIRE(sweep.GetRunCount() == spec.ConfigCount());
+    REQUIRE(sweep.GetSkippedCount() == 0);
+
+    std::string text = ReadText(kPath);
+    REQUIRE(text.compare(0, ParameterSweep::CsvHeader().size() + 1,
+                         ParameterSweep::CsvHeader() + "\n") == 0);
+    std::vector<std::string> rows = SortedRows(text);
+    REQUIRE(rows.size() == spec.ConfigCount());
+
+    SECTION("Rows do not depend on the thread count") {
+      std::remove(kPath);
+      REQUIRE(sweep.Run(kPath, 1));
+      REQUIRE(SortedRows(ReadText(kPath)) == rows);
+    }
+
+    SECTION("Finished sweeps are not run again") {
+      REQUIRE(sweep.Run(kPath, 3));
+      REQUIRE(sweep.GetRunCount() == 0);
+      REQUIRE(sweep.GetSkippedCount() == spec.ConfigCount());
+      REQUIRE(ReadText(kPath) == text);
+    }
+
+    SECTION("Interrupted sweeps resume where they stopped") {
+      //Keep the header and 5 rows, then half of the next row
+      size_t cut = 0;
+      for(size_t line = 0; line < 6; ++line) {
+        cut = text.find('\n', cut) + 1;
+      }
+      cut += 10;
+      WriteText(kPath, text.substr(0, cut));
+
+      REQUIRE(sweep.Run(kPath, 2));
+      REQUIRE(sweep.GetSkippedCount() == 5);
+      REQUIRE(sweep.GetRunCount() == spec.ConfigCount() - 5);
+      REQUIRE(SortedRows(ReadText(kPath)) == rows);
+    }
+
+    SECTION("Rows of another sweep are not mixed in") {
+      SweepSpec other = spec;
+      other.separations = {0.75, 1, 1.5};
+      ParameterSweep other_sweep(other);
+      REQUIRE_FALSE(other_sweep.Run(kPath, 1));
+      REQUIRE(ReadText(kPath) == text);
+
+      other = spec;
+      other.steps = 30;
+      REQUIRE_FALSE(ParameterSweep(other).Run(kPath, 1));
+    }
+
+    SECTION("Other files are left alone") {
+      WriteText(kPath, "notes without a line break");
+      REQUIRE_FALSE(sweep.Run(kPath, 1));
+      REQUIRE(ReadText(kPath) == "notes without a line break");
+
+      //A header cut short is restarted
+      WriteText(kPath, ParameterSweep::CsvHeader().substr(0, 20));
+      REQUIRE(sweep.Run(kPath, 3));
+      REQUIRE(SortedRows(ReadText(kPath)) == rows);
+    }
+  }
+
+  std::remove(kPath);
+}
@@ -0,0 +1,93 @@
+#include <core/profiler.h>
+#include <catch2/catch.hpp>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <thread>
+
+using boidsimulation::ProfileSummary;
+using boidsimulation::Profiler;
+
+namespace {
+
+/**
+ * @return The summary entry called name, or an empty one if there is none.
+ */
+ProfileSummary FindSummary(const std::vector<ProfileSummary>& summary, const std::string& name) {
+  for(const ProfileSummary& entry : summary) {
+    if(entry.name == name) {
+      return entry;
+    }
+  }
+  return ProfileSummary();
+}
+
+}  // namespace
+
+TEST_CASE("Profiler") {
+  Profiler& profiler = Profiler::Get();
+  profiler.Clear();
+  profiler.SetEnabled(true);
+
+  SECTION("Nothing is recorded while disabled") {
+    profiler.SetEnabled(false);
+    {
+      BOIDSIMULATION_PROFILE_SCOPE("Disabled Scope");
+      BOIDSIMULATION_PROFILE_COUNT("Disabled Count", 3);
+    }
+    profiler.EndFrame();
+    REQUIRE(profiler.GetSummary().empty());
+  }
+
+  SECTION("Counters are averaged over frames and threads") {
+    for(size_t frame = 0; frame < 4; ++frame) {
+      std::thread worker([]() { BOIDSIMULATION_PROFILE_COUNT("Test Count", 10); });
+      BOIDSIMULATION_PROFILE_COUNT("Test Count", 2 * frame);
+      worker.join();
+      profiler.EndFrame();
+    }
+    ProfileSummary count = FindSummary(profiler.GetSummary(), "Test Count");
+    REQUIRE(!count.timer);
+    //(10 + 0) + (10 + 2) + (10 + 4) + (10 + 6) over four frames
+    REQUIRE(count.per_frame == Approx(13));
+    REQUIRE(count.calls_per_frame == Approx(2));
+  }
+
+  SECTION("Timers measure their scope") {
+    {
+      BOIDSIMULATION_PROFILE_SCOPE("Test Scope");
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    profiler.EndFrame();
+    std::vector<ProfileSummary> summary = profiler.GetSummary();
+    ProfileSummary scope = FindSummary(summary, "Test Scope");
+    REQUIRE(scope.timer);
+    REQUIRE(scope.per_frame >= 5);
+    REQUIRE(scope.calls_per_frame == 1);
+  }
+
+  SECTION("Chrome trace export") {
+    {
+      BOIDSIMULATION_PROFILE_SCOPE("Traced Scope");
+      BOIDSIMULATION_PROFILE_TIME("Untraced Scope");
+      BOIDSIMULATION_PROFILE_COUNT("Traced Count", 7);
+    }
+    profiler.EndFrame();
+    const std::string kPath = "profiler_test.trace.json";
+    REQUIRE(profiler.WriteChromeTrace(kPath));
+
+    std::ifstream file(kPath);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string trace = contents.str();
+    REQUIRE(trace.find("{\"traceEvents\":[") == 0);
+    REQUIRE(trace.find("\"name\":\"Traced Scope\",\"ph\":\"X\"") != std::string::npos);
+    REQUIRE(trace.find("Untraced Scope") == std::string::npos);
+    REQUIRE(trace.find("\"name\":\"Traced Count\",\"ph\":\"C\"") != std::string::npos);
+    REQUIRE(trace.find("\"args\":{\"value\":7}") != std::string::npos);
+    remove(kPath.c_str());
+  }
+
+  profiler.SetEnabled(false);
+  profiler.Clear();
+}
@@ -0,0 +1,118 @@
+#include <core/simulation_thread.h>
+#include <core/triple_buffer.h>
+#include <catch2/catch.hpp>
+#include <thread>
+
+using boidsimulation::FlockGeometry;
+using boidsimulation::MathVector;
+using boidsimulation::SimulationFrame;
+using boidsimulation::SimulationThread;
+using boidsimulation::TripleBuffer;
+using boidsimulation::World;
+
+namespace {
+
+//Two copies of a counter, which only differ if a read sees a half written value
+struct Pair {
+  size_t first = 0;
+  size_t second = 0;
+};
+
+}  // namespace
+
+TEST_CASE("Triple buffer") {
+  TripleBuffer<Pair> buffer;
+
+  SECTION("Nothing to acquire before a publish") {
+    REQUIRE(!buffer.Acquire());
+    REQUIRE(buffer.GetReadBuffer().first == 0);
+  }
+
+  SECTION("Acquire returns the newest value once") {
+    for(size_t value = 1; value <= 3; ++value) {
+      buffer.GetWriteBuffer().first = value;
+      buffer.Publish();
+    }
+    REQUIRE(buffer.Acquire());
+    REQUIRE(buffer.GetReadBuffer().first == 3);
+    REQUIRE(!buffer.Acquire());
+    REQUIRE(buffer.GetReadBuffer().first == 3);
+  }
+
+  SECTION("Reads never see a partly written value") {
+    const size_t kValues = 200000;
+    std::thread writer([&]() {
+      for(size_t value = 1; value <= kValues; ++value) {
+        Pair& pair = buffer.GetWriteBuffer();
+        pair.first = value;
+        pair.second = value;
+        buffer.Publish();
+      }
+    });
+
+    size_t last = 0;
+    bool consistent = true, ordered = true;
+    while(last < kValues) {
+      if(buffer.Acquire()) {
+        const Pair& pair = buffer.GetReadBuffer();
+        consistent = consistent && pair.first == pair.second;
+        ordered = ordered && pair.first > last;
+        last = pair.first;
+      }
+    }
+    writer.join();
+    REQUIRE(consistent);
+    REQUIRE(ordered);
+  }
+}
+
+TEST_CASE("Simulation thread") {
+  World world(0, 0, 800, 600, 100, 2);
+  SimulationThread simulation(world);
+
+  SECTION("Posting runs right away when stopped") {
+    simulation.Post([](World& world) { world.Clear(); });
+    REQUIRE(world.GetBoids().Empty());
+  }
+
+  SECTION("Steps and publishes frames") {
+    simulation.Start(0);
+    REQUIRE(simulation.IsRunning());
+    while(simulation.AcquireFrame().step < 5) {
+      std::this_thread::yield();
+    }
+    simulation.Stop();
+    REQUIRE(!simulation.IsRunning());
+
+    const SimulationFrame& frame = simulation.AcquireFrame();
+    REQUIRE(frame.step >= 5);
+    REQUIRE(frame.boid_count == world.GetBoids().Size());
+    REQUIRE(frame.predator_count == world.GetPredators().Size());
+    REQUIRE(frame.geometry.GetTriangleCount() == frame.boid_count + frame.predator_count);
+  }
+
+  SECTION("Posted changes run between steps") {
+    simulation.Start(1000);
+    simulation.Post([](World& world) { world.AddObstacle(MathVector(400, 300, 0)); });
+    simulation.Stop();
+    REQUIRE(world.GetObstacles().size() == 1);
+  }
+
+  SECTION("Paused threads only run posted changes") {
+    simulation.SetPaused(true);
+    simulation.Start(0);
+    simulation.Post([](World& world) { world.Clear(); });
+    while(simulation.AcquireFrame().boid_count != 0) {
+      std::this_thread::yield();
+    }
+    REQUIRE(simulation.AcquireFrame().step == 0);
+
+    simulation.Post([](World& world) { world.AddObstacle(MathVector(400, 300, 0)); });
+    while(simulation.AcquireFrame().obstacles.empty()) {
+      std::this_thread::yield();
+    }
+    REQUIRE(simulation.AcquireFrame().obstacles[0].GetPosition() == MathVector(400, 300, 0));
+    REQUIRE(simulation.AcquireFrame().step == 0);
+    simulation.Stop();
+  }
+}
@@ -0,0 +1,107 @@
+#include <core/snapshot.h>
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <fstream>
+
+using boidsimulation::FlockState;
+using boidsimulation::MathVector;
+using boidsimulation::Snapshot;
+using boidsimulation::World;
+
+namespace {
+
+const char* kPath = "snapshot_tests.snapshot";
+
+/**
+ * @return True if every array of first and second holds the same values.
+ */
+bool SameFlock(const FlockState& first, const FlockState& second) {
+  return first.positions_ == second.positions_ && first.velocities_ == second.velocities_ &&
+         first.species_ == second.species_ && first.species_table_ == second.species_table_;
+}
+
+/**
+ * @return The bytes of the file at path.
+ */
+std::string ReadText(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+TEST_CASE("Snapshots") {
+  World world(0, 0, 700, 600, 400, 5);
+  world.GetParameters().separation = 2.5;
+  world.GetParameters().chase = 30;
+  world.AddObstacle(MathVector(300, 300, 0));
+  world.AddObstacle(MathVector(500, 200, 0));
+  for(size_t step = 0; step < 5; ++step) {
+    world.Update();
+  }
+  REQUIRE(Snapshot::Save(world, kPath));
+
+  SECTION("Loading restores the whole World") {
+    World restored(50, 50, 100, 100, 3, 1);
+    REQUIRE(Snapshot::Load(kPath, restored));
+    REQUIRE(SameFlock(restored.GetBoids(), world.GetBoids()));
+    REQUIRE(SameFlock(restored.GetPredators(), world.GetPredators()));
+    REQUIRE(restored.GetObstacles().size() == 2);
+    REQUIRE(restored.GetObstacles()[1].GetPosition() == MathVector(500, 200, 0));
+    REQUIRE(restored.GetParameters().separation == 2.5);
+    REQUIRE(restored.GetParameters().chase == 30);
+    REQUIRE(restored.GetWidth() == 700);
+    REQUIRE(restored.GetCatchStats().total_caught == world.GetCatchStats().total_caught);
+    REQUIRE(restored.GetStateHash() == world.GetStateHash());
+
+    //The restored World carries on exactly like the original
+    for(size_t step = 0; step < 5; ++step) {
+      world.Update();
+      restored.Update();
+    }
+    world.AddBoid(MathVector(100, 100, 0));
+    restored.AddBoid(MathVector(100, 100, 0));
+    REQUIRE(SameFlock(restored.GetBoids(), world.GetBoids()));
+    REQUIRE(restored.GetStateHash() == world.GetStateHash());
+  }
+
+  SECTION("Damaged files are rejected without changing the World") {
+    World restored(50, 50, 100, 100, 3, 1);
+    REQUIRE_FALSE(Snapshot::Load("missing.snapshot", restored));
+
+    std::ifstream in(kPath, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ofstream(kPath, std::ios::binary).write(bytes.data(), bytes.size() - 8);
+    REQUIRE_FALSE(Snapshot::Load(kPath, restored));
+
+    bytes[0] = 'X';
+    std::ofstream(kPath, std::ios::binary).write(bytes.data(), bytes.size());
+    REQUIRE_FALSE(Snapshot::Load(kPath, restored));
+    REQUIRE(restored.GetBoids().Size() == 3);
+    REQUIRE(restored.GetWidth() == 100);
+  }
+
+  SECTION("Species are stored without padding and checked when loaded") {
+    //Identical Worlds save identical files
+    std::string second_path = std::string(kPath) + ".second";
+    REQUIRE(Snapshot::Save(world, second_path));
+    std::string bytes = ReadText(kPath);
+    REQUIRE(bytes == ReadText(second_path));
+    std::remove(second_path.c_str());
+
+    //The prey species' vision only appears in its species record, which
+    //holds predator 59 bytes after it
+    double vision = world.GetBoids().species_table_[0].vision;
+    size_t vision_offset =
+        bytes.find(std::string(reinterpret_cast<const char*>(&vision), sizeof(vision)));
+    REQUIRE(vision_offset != std::string::npos);
+    REQUIRE(bytes[vision_offset + 59] == 0);
+    bytes[vision_offset + 59] = 2;
+    std::ofstream(kPath, std::ios::binary).write(bytes.data(), bytes.size());
+    World restored(50, 50, 100, 100, 3, 1);
+    REQUIRE_FALSE(Snapshot::Load(kPath, restored));
+    REQUIRE(restored.GetBoids().Size() == 3);
+  }
+
+  std::remove(kPath);
+}
@@ -0,0 +1,38 @@
+#include <core/thread_pool.h>
+#include <catch2/catch.hpp>
+#include <algorithm>
+
+using boidsimulation::ThreadPool;
+
+TEST_CASE("Thread Pool") {
+  ThreadPool pool(4);
+  REQUIRE(pool.GetThreadCount() == 4);
+
+  SECTION("Every item processed once") {
+    std::vector<int> visits(10007, 0);
+    pool.ParallelFor(visits.size(), 64, [&](size_t begin, size_t end) {
+      for(size_t index = begin; index < end; ++index) {
+        ++visits[index];
+      }
+    });
+    REQUIRE(std::count(visits.begin(), visits.end(), 1) == (long)visits.size());
+  }
+
+  SECTION("Reused across loops") {
+    std::atomic<size_t> total(0);
+    for(size_t loop = 0; loop < 100; ++loop) {
+      pool.ParallelFor(1000, 10, [&](size_t begin, size_t end) {
+        total += end - begin;
+      });
+    }
+    REQUIRE(total == 100000);
+  }
+
+  SECTION("Empty loop") {
+    bool called = false;
+    pool.ParallelFor(0, 10, [&](size_t begin, size_t end) {
+      called = true;
+    });
+    REQUIRE(!called);
+  }
+}
@@ -0,0 +1,154 @@
+#include <core/trajectory_player.h>
+#include <core/trajectory_recorder.h>
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+using boidsimulation::BackpressurePolicy;
+using boidsimulation::FlockState;
+using boidsimulation::MathVector;
+using boidsimulation::RecorderOptions;
+using boidsimulation::TrajectoryPlayer;
+using boidsimulation::TrajectoryRecorder;
+using boidsimulation::World;
+
+namespace {
+
+const char* kPath = "trajectory_tests.trajectory";
+
+std::string ReadFile(const char* path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+TEST_CASE("Trajectory recording") {
+  SECTION("Played back frames match the recorded World") {
+    World world(0, 0, 600, 600, 300, 4);
+    RecorderOptions options;
+    options.frame_buffers = 64;
+    options.keyframe_interval = 10;
+    TrajectoryRecorder recorder(options);
+    REQUIRE(recorder.Open(kPath));
+
+    std::vector<std::vector<MathVector>> positions, velocities;
+    for(size_t step = 0; step < 40; ++step) {
+      world.Update();
+      REQUIRE(recorder.Record(world));
+      positions.push_back(world.GetBoids().positions_);
+      velocities.push_back(world.GetBoids().velocities_);
+    }
+    REQUIRE(recorder.Close());
+    REQUIRE_FALSE(recorder.GetStats().write_failed);
+    REQUIRE(recorder.GetStats().frames_written == 40);
+    REQUIRE(recorder.GetStats().dropped == 0);
+
+    std::string file = ReadFile(kPath);
+    REQUIRE(file.size() == recorder.GetStats().bytes_written);
+    //Far smaller than the raw doubles of the prey alone
+    REQUIRE(file.size() < 40 * 300 * 4 * sizeof(double) / 3);
+
+    TrajectoryPlayer player;
+    REQUIRE(player.Open(kPath));
+    REQUIRE(player.GetFrameCount() == 40);
+
+    //Forward steps, backward jumps and jumps across keyframes
+    for(size_t frame : {0, 1, 2, 37, 3, 4, 19, 20, 21, 39, 38}) {
+      REQUIRE(player.SeekFrame(frame));
+      REQUIRE(player.GetStep() == frame);
+      const FlockState& boids = player.GetBoids();
+      REQUIRE(boids.Size() == positions[frame].size());
+      for(size_t boid = 0; boid < boids.Size(); ++boid) {
+        REQUIRE(boids.positions_[boid].x_ == Approx(positions[frame][boid].x_).margin(0.01));
+        REQUIRE(boids.positions_[boid].y_ == Approx(positions[frame][boid].y_).margin(0.01));
+        REQUIRE(boids.velocities_[boid].x_ == Approx(velocities[frame][boid].x_).margin(0.01));
+      }
+      REQUIRE(player.GetPredators().Size() == 4);
+    }
+    REQUIRE_FALSE(player.SeekFrame(40));
+    player.Close();
+
+    SECTION("Recordings that were not closed are indexed by their frames") {
+      //Cuts off the index and the end of the last frame
+      size_t index_bytes = 40 * sizeof(uint64_t) + sizeof(boidsimulation::TrajectoryFooter);
+      std::ofstream(kPath, std::ios::binary).write(file.data(), file.size() - index_bytes - 10);
+      REQUIRE(player.Open(kPath));
+      REQUIRE(player.GetFrameCount() == 39);
+      REQUIRE(player.SeekFrame(38));
+      REQUIRE(player.GetBoids().positions_[0].x_ ==
+              Approx(positions[38][0].x_).margin(0.01));
+    }
+
+    SECTION("Other files are rejected") {
+      std::ofstream(kPath, std::ios::binary).write("BOIDSNAP and more", 17);
+      REQUIRE_FALSE(player.Open(kPath));
+    }
+
+    SECTION("Index entries past the end of the file are rejected") {
+      boidsimulation::TrajectoryFooter footer;
+      std::memcpy(&footer, file.data() + file.size() - sizeof(footer), sizeof(footer));
+      auto write_entry = [&](size_t frame, uint64_t offset) {
+        std::string damaged = file;
+        std::memcpy(&damaged[footer.index_offset + frame * sizeof(uint64_t)], &offset,
+                    sizeof(offset));
+        std::ofstream(kPath, std::ios::binary).write(damaged.data(), damaged.size());
+      };
+      //Large enough that adding the frame's size wraps around
+      write_entry(0, ~(uint64_t)0 - 8);
+      REQUIRE_FALSE(player.Open(kPath));
+
+      write_entry(39, file.size() - 4);
+      REQUIRE(player.Open(kPath));
+      REQUIRE(player.SeekFrame(38));
+      REQUIRE_FALSE(player.SeekFrame(39));
+    }
+  }
+
+  SECTION("A full ring drops frames instead of waiting") {
+    World world(0, 0, 2000, 2000, 5000, 0);
+    RecorderOptions options;
+    options.frame_buffers = 1;
+    options.policy = BackpressurePolicy::kDropOldest;
+    TrajectoryRecorder recorder(options);
+    REQUIRE(recorder.Open(kPath));
+    for(size_t step = 0; step < 200; ++step) {
+      recorder.Record(world);
+    }
+    recorder.Close();
+    REQUIRE_FALSE(recorder.Record(world));
+    REQUIRE(recorder.GetStats().steps == 200);
+    REQUIRE(recorder.GetStats().frames_written + recorder.GetStats().dropped == 200);
+  }
+
+  SECTION("Varints are read no further than 10 bytes") {
+    std::vector<uint8_t> bytes(16, 0xFF);
+    const uint8_t* data = bytes.data();
+    boidsimulation::ReadVarint(data);
+    REQUIRE(data == bytes.data() + 10);
+  }
+
+  SECTION("Failed writes are reported") {
+    TrajectoryRecorder recorder;
+    REQUIRE_FALSE(recorder.Open("no_such_directory/trajectory_tests.trajectory"));
+    REQUIRE(recorder.Close());
+
+    //Every write to /dev/full fails as if the disk were full
+    FILE* full = fopen("/dev/full", "wb");
+    if(full != nullptr) {
+      fclose(full);
+      World world(0, 0, 600, 600, 300, 4);
+      REQUIRE(recorder.Open("/dev/full"));
+      for(size_t step = 0; step < 20; ++step) {
+        world.Update();
+        recorder.Record(world);
+      }
+      REQUIRE_FALSE(recorder.Close());
+      REQUIRE(recorder.GetStats().write_failed);
+    }
+  }
+
+  std::remove(kPath);
+}
@@ -1,7 +1,10 @@
 #include <core/math_vector.h>
 #include <catch2/catch.hpp>
+#include <cstring>
+#include <type_traits>
 
 using boidsimulation::MathVector;
+using boidsimulation::Vector2f;
 
 TEST_CASE("Constructors") {
   SECTION("Default Constructor") {
@@ -35,7 +38,10 @@ TEST_CASE("Setter Methods") {
   }
 }
 
-TEST_CASE("Rule of 5") {
+TEST_CASE("Copy and Move") {
+  static_assert(std::is_trivially_copyable<MathVector>::value,
+                "MathVector should be trivially copyable");
+
   MathVector vec(1,2,3);
   MathVector copy_vec(vec);
   SECTION("Copy Constructor") {
@@ -47,10 +53,9 @@ TEST_CASE("Rule of 5") {
 
   MathVector move_vec(std::move(vec));
   SECTION("Move Constructor") {
+    //Moving copies the components and leaves the source unchanged
     bool same = move_vec == vec;
-    bool different = move_vec != vec;
-    REQUIRE(!same);
-    REQUIRE(different);
+    REQUIRE(same);
 
     REQUIRE(move_vec.x_ == Approx(1.0));
     REQUIRE(move_vec.y_ == Approx(2.0));
@@ -71,14 +76,69 @@ TEST_CASE("Rule of 5") {
   move_vector = std::move(vector);
   SECTION("Move Assignment") {
     bool same = move_vector == vector;
-    bool different = move_vector != vector;
-    REQUIRE(!same);
-    REQUIRE(different);
+    REQUIRE(same);
 
     REQUIRE(move_vector.x_ == Approx(4.0));
     REQUIRE(move_vector.y_ == Approx(5.0));
     REQUIRE(move_vector.z_ == Approx(6.0));
   }
+
+  SECTION("memcpy") {
+    MathVector destination;
+    std::memcpy(&destination, &copy_vector, sizeof(MathVector));
+    bool same = destination == copy_vector;
+    REQUIRE(same);
+  }
+}
+
+TEST_CASE("Constant Expressions") {
+  constexpr MathVector vect(1,2,3);
+  constexpr MathVector other(4,5,6);
+
+  static_assert((vect + other) == MathVector(5,7,9), "constexpr addition");
+  static_assert((other - vect) == MathVector(3,3,3), "constexpr subtraction");
+  static_assert((2 * vect) == MathVector(2,4,6), "constexpr scalar multiplication");
+  static_assert((other / 2) == MathVector(2,2.5,3), "constexpr scalar division");
+  static_assert(-vect == MathVector(-1,-2,-3), "constexpr negation");
+  static_assert(vect * other == 32, "constexpr dot product");
+  static_assert((vect % other) == MathVector(-3,6,-3), "constexpr cross product");
+  static_assert(vect.LengthSquared() == 14, "constexpr squared length");
+  static_assert(vect.DistanceSquared(other) == 27, "constexpr squared distance");
+  static_assert(vect[2] == 3, "constexpr index");
+
+  REQUIRE(vect.LengthSquared() == Approx(vect.Length() * vect.Length()));
+  REQUIRE(vect.DistanceSquared(other) == Approx(vect.Distance(other) * vect.Distance(other)));
+}
+
+TEST_CASE("2D Single Precision") {
+  constexpr Vector2f vect(3,4);
+  constexpr Vector2f other(1,2);
+
+  SECTION("No z component") {
+    REQUIRE(sizeof(Vector2f) == 2 * sizeof(float));
+    REQUIRE(std::is_trivially_copyable<Vector2f>::value);
+    REQUIRE_THROWS_AS(Vector2f()[2], std::out_of_range);
+  }
+
+  SECTION("Operators") {
+    static_assert((vect + other) == Vector2f(4,6), "constexpr 2D addition");
+    static_assert((vect - other) == Vector2f(2,2), "constexpr 2D subtraction");
+    static_assert((vect * 2) == Vector2f(6,8), "constexpr 2D scalar multiplication");
+    static_assert(vect * other == 11, "constexpr 2D dot product");
+    static_assert(vect.LengthSquared() == 25, "constexpr 2D squared length");
+    REQUIRE(vect.Length() == Approx(5.0f));
+    REQUIRE(vect.Distance(other) == Approx(std::sqrt(8.0f)));
+  }
+
+  SECTION("Conversion") {
+    Vector2f narrowed(MathVector(1.5,-2,7));
+    bool same = narrowed == Vector2f(1.5f,-2);
+    REQUIRE(same);
+
+    MathVector widened(vect);
+    bool padded = widened == MathVector(3,4,0);
+    REQUIRE(padded);
+  }
 }
 
 TEST_CASE("Magnitude and Direction") {
@@ -183,6 +243,15 @@ TEST_CASE("Operator Overloads") {
     REQUIRE(second);
   }
 
+  SECTION("Negation") {
+    MathVector negated = -vect;
+    MathVector product(-1,-2,-3);
+    bool same = negated == product;
+    bool unchanged = vect == MathVector(1,2,3);
+    REQUIRE(same);
+    REQUIRE(unchanged);
+  }
+
   SECTION("Scalar Division") {
     other /= 2;
     MathVector divided(2,2.5,3);
@@ -194,6 +263,10 @@ TEST_CASE("Operator Overloads") {
     MathVector product(0.5,1,1.5);
     bool same = div == product;
     REQUIRE(same);
+
+    MathVector by_zero = vect / 0;
+    bool unchanged = by_zero == vect;
+    REQUIRE(unchanged);
   }
 
   SECTION("Dot Product") {
@@ -0,0 +1,373 @@
+#include <core/world.h>
+#include <catch2/catch.hpp>
+#include <cmath>
+
+using boidsimulation::FlockState;
+using boidsimulation::MathVector;
+using boidsimulation::SpawnDistribution;
+using boidsimulation::SpawnRegion;
+using boidsimulation::World;
+using boidsimulation::World2f;
+
+TEST_CASE("World spawning") {
+  World world(100, 50, 400, 300, 20, 3);
+  REQUIRE(world.GetBoids().Size() == 20);
+  REQUIRE(world.GetPredators().Size() == 3);
+  for(auto& position : world.GetBoids().positions_) {
+    REQUIRE(position.x_ >= 100);
+    REQUIRE(position.x_ <= 500);
+    REQUIRE(position.y_ >= 50);
+    REQUIRE(position.y_ <= 350);
+  }
+
+  SECTION("AddBoid ignores positions outside the World") {
+    world.AddBoid(MathVector(50, 100, 0));
+    world.AddBoid(MathVector(200, 100, 0));
+    world.AddBoid(MathVector(200, 100, 0), true);
+    REQUIRE(world.GetBoids().Size() == 21);
+    REQUIRE(world.GetPredators().Size() == 4);
+    REQUIRE(world.GetPredators().SpeciesOf(3).predator);
+  }
+
+  SECTION("AddObstacle keeps Obstacles inside the World") {
+    world.AddObstacle(MathVector(110, 200, 0));
+    world.AddObstacle(MathVector(300, 200, 0));
+    REQUIRE(world.GetObstacles().size() == 1);
+  }
+
+  SECTION("Clear") {
+    world.AddObstacle(MathVector(300, 200, 0));
+    world.Clear();
+    REQUIRE(world.GetBoids().Empty());
+    REQUIRE(world.GetPredators().Empty());
+    REQUIRE(world.GetObstacles().empty());
+  }
+}
+
+TEST_CASE("Bulk spawning") {
+  SpawnRegion region = {100, 200, 300, 150};
+
+  SECTION("Boids stay inside the region") {
+    World world(0, 0, 800, 800, 0, 0);
+    world.SpawnBulk(2000, region);
+    world.SpawnBulk(2000, region, SpawnDistribution::kNormal, true);
+    REQUIRE(world.GetBoids().Size() == 2000);
+    REQUIRE(world.GetPredators().Size() == 2000);
+    REQUIRE(world.GetPredators().SpeciesOf(1999).predator);
+    for(auto* flock : {&world.GetBoids(), &world.GetPredators()}) {
+      for(size_t index = 0; index < flock->Size(); ++index) {
+        REQUIRE(flock->positions_[index].x_ >= 100);
+        REQUIRE(flock->positions_[index].x_ <= 400);
+        REQUIRE(flock->positions_[index].y_ >= 200);
+        REQUIRE(flock->positions_[index].y_ <= 350);
+        REQUIRE(std::abs(flock->velocities_[index].x_) <= flock->SpeciesOf(index).max_speed);
+      }
+    }
+  }
+
+  SECTION("The same seed spawns the same Boids on any thread count") {
+    World single(0, 0, 800, 800, 0, 0, boidsimulation::WorldParameters(), 42);
+    World threaded(0, 0, 800, 800, 0, 0, boidsimulation::WorldParameters(), 42);
+    threaded.SetThreadCount(4);
+    for(World* world : {&single, &threaded}) {
+      world->SpawnBulk(3000, region);
+      world->AddBoid(MathVector(300, 300, 0));
+      world->SpawnBulk(3000, region, SpawnDistribution::kNormal);
+    }
+    bool same = single.GetBoids().positions_ == threaded.GetBoids().positions_ &&
+                single.GetBoids().velocities_ == threaded.GetBoids().velocities_;
+    REQUIRE(same);
+
+    World reseeded(0, 0, 800, 800, 0, 0, boidsimulation::WorldParameters(), 7);
+    reseeded.SetSeed(42);
+    reseeded.SpawnBulk(3000, region);
+    REQUIRE(reseeded.GetSeed() == 42);
+    REQUIRE(reseeded.GetBoids().positions_[2999] == single.GetBoids().positions_[2999]);
+
+    World other(0, 0, 800, 800, 0, 0, boidsimulation::WorldParameters(), 43);
+    other.SpawnBulk(3000, region);
+    REQUIRE(other.GetBoids().positions_[0] != single.GetBoids().positions_[0]);
+  }
+}
+
+TEST_CASE("World update") {
+  SECTION("Parameters apply to every Boid") {
+    World world(0, 0, 600, 600, 50, 2);
+    world.GetParameters().boid_max_speed = 3;
+    world.GetParameters().separation = 2;
+    world.GetParameters().pred_size = 20;
+    world.Update();
+    //Every Boid of a type shares one species
+    REQUIRE(world.GetBoids().species_table_.size() == 1);
+    REQUIRE(world.GetPredators().species_table_.size() == 1);
+    REQUIRE(world.GetPredators().SpeciesOf(1).size == 20);
+    REQUIRE(world.GetPredators().SpeciesOf(1).vision == 100);
+    for(size_t index = 0; index < world.GetBoids().Size(); ++index) {
+      REQUIRE(world.GetBoids().SpeciesOf(index).max_speed == 3);
+      REQUIRE(world.GetBoids().SpeciesOf(index).separation_scale == 2);
+      REQUIRE(world.GetBoids().velocities_[index].Length() <= Approx(3));
+    }
+  }
+
+  SECTION("Predators catch prey within reach") {
+    World world(0, 0, 600, 600, 0, 0);
+    world.AddBoid(MathVector(300, 300, 0));
+    world.AddBoid(MathVector(100, 100, 0));
+    world.AddBoid(MathVector(300, 305, 0), true);
+    world.Update();
+    REQUIRE(world.GetBoids().Size() == 1);
+    REQUIRE(world.GetCatchStats().caught == 1);
+    REQUIRE(world.GetCatchStats().total_caught == 1);
+
+    world.Update();
+    REQUIRE(world.GetCatchStats().caught == 0);
+    REQUIRE(world.GetCatchStats().total_caught == 1);
+    world.Clear();
+    REQUIRE(world.GetCatchStats().total_caught == 0);
+  }
+
+  SECTION("Grid catch detection matches checking every Predator") {
+    World world(0, 0, 500, 500, 800, 40);
+    const FlockState& boids = world.GetBoids();
+    const FlockState& preds = world.GetPredators();
+    std::vector<MathVector> expected;
+    for(size_t index = 0; index < boids.Size(); ++index) {
+      bool caught = false;
+      for(size_t pred = 0; pred < preds.Size(); ++pred) {
+        caught = caught || preds.positions_[pred].Distance(boids.positions_[index]) <=
+                           preds.SpeciesOf(pred).size;
+      }
+      if(!caught) {
+        expected.push_back(boids.positions_[index]);
+      }
+    }
+
+    world.CheckPredatorCatch();
+    REQUIRE(expected.size() < 800);
+    REQUIRE(world.GetCatchStats().caught == 800 - expected.size());
+    REQUIRE(world.GetCatchStats().candidates < 800 * 40);
+    bool same = boids.positions_ == expected;
+    REQUIRE(same);
+  }
+
+  SECTION("Double buffered results do not depend on Boid order") {
+    //Each Boid's velocity is drawn from its own seed, whatever order it is added in
+    auto spawn = [](World& world, size_t index, bool predator) {
+      world.SetSeed(100 + index);
+      world.AddBoid(MathVector(20 + (index * 37) % 760, 20 + (index * 53) % 760, 0), predator);
+    };
+    const size_t kPrey = 400;
+    const size_t kPredators = 4;
+    World forward(0, 0, 800, 800, 0, 0);
+    World reversed(0, 0, 800, 800, 0, 0);
+    for(size_t index = 0; index < kPrey + kPredators; ++index) {
+      spawn(forward, index, index >= kPrey);
+      size_t reversed_index = kPrey + kPredators - 1 - index;
+      spawn(reversed, reversed_index, reversed_index >= kPrey);
+    }
+    forward.SetDoubleBuffered(true);
+    reversed.SetDoubleBuffered(true);
+    for(size_t step = 0; step < 20; ++step) {
+      forward.Update();
+      reversed.Update();
+    }
+
+    //Neighbors are summed in another order, so results may differ by rounding
+    for(auto flocks : {std::make_pair(&forward.GetBoids(), &reversed.GetBoids()),
+                       std::make_pair(&forward.GetPredators(), &reversed.GetPredators())}) {
+      size_t size = flocks.first->Size();
+      REQUIRE(flocks.second->Size() == size);
+      bool same = true;
+      for(size_t index = 0; index < size; ++index) {
+        const MathVector& position = flocks.first->positions_[index];
+        const MathVector& other = flocks.second->positions_[size - 1 - index];
+        same = same && position.Distance(other) < 1e-6;
+      }
+      REQUIRE(same);
+    }
+  }
+
+  SECTION("Double buffered results do not depend on thread count") {
+    World single(0, 0, 800, 800, 600, 4);
+    World threaded(0, 0, 800, 800, 600, 4);
+    single.SetDoubleBuffered(true);
+    threaded.SetThreadCount(3);
+    for(size_t step = 0; step < 10; ++step) {
+      single.Update();
+      threaded.Update();
+    }
+    REQUIRE(single.GetBoids().Size() == threaded.GetBoids().Size());
+    bool same = single.GetBoids().positions_ == threaded.GetBoids().positions_ &&
+                single.GetPredators().positions_ == threaded.GetPredators().positions_;
+    REQUIRE(same);
+  }
+}
+
+TEST_CASE("Adaptive update interval") {
+  //Spread out enough that most Boids are alone most of the time
+  auto make_world = [](bool double_buffered, size_t interval) {
+    World world(0, 0, 3000, 3000, 60, 3);
+    world.SetDoubleBuffered(double_buffered);
+    world.SetAdaptiveInterval(interval);
+    world.AddObstacle(MathVector(1000.3, 1200.6, 0));
+    world.AddObstacle(MathVector(2200.3, 700.6, 0));
+    return world;
+  };
+
+  for(bool double_buffered : {false, true}) {
+    World every_step = make_world(double_buffered, 1);
+    World adaptive = make_world(double_buffered, 4);
+    REQUIRE(adaptive.GetAdaptiveInterval() == 4);
+
+    size_t dead_reckoned = 0;
+    for(size_t step = 0; step < 300; ++step) {
+      every_step.Update();
+      adaptive.Update();
+      REQUIRE(every_step.GetDeadReckonedCount() == 0);
+      dead_reckoned += adaptive.GetDeadReckonedCount();
+    }
+    //Skipped steps are the ones a full update would not have changed
+    REQUIRE(dead_reckoned > 300 * 60 / 4);
+    REQUIRE(adaptive.GetBoids().positions_ == every_step.GetBoids().positions_);
+    REQUIRE(adaptive.GetPredators().positions_ == every_step.GetPredators().positions_);
+  }
+
+  SECTION("Faster Boids are fully updated again") {
+    World adaptive = make_world(true, 8);
+    for(size_t step = 0; step < 20; ++step) {
+      adaptive.Update();
+    }
+    REQUIRE(adaptive.GetDeadReckonedCount() > 0);
+    adaptive.GetParameters().pred_max_speed += 1;
+    adaptive.Update();
+    REQUIRE(adaptive.GetDeadReckonedCount() == 0);
+  }
+}
+
+namespace {
+
+/**
+ * Mean speed of a flock and root mean square distance of its Boids from their center.
+ */
+struct FlockStatistics {
+  double speed = 0;
+  double spread = 0;
+};
+
+template <typename Flock>
+FlockStatistics MeasureFlock(const Flock& flock) {
+  FlockStatistics statistics;
+  double center_x = 0, center_y = 0;
+  for(size_t index = 0; index < flock.Size(); ++index) {
+    statistics.speed += flock.velocities_[index].Length();
+    center_x += flock.positions_[index].x_;
+    center_y += flock.positions_[index].y_;
+  }
+  center_x /= flock.Size();
+  center_y /= flock.Size();
+  for(auto& position : flock.positions_) {
+    double x = position.x_ - center_x, y = position.y_ - center_y;
+    statistics.spread += x * x + y * y;
+  }
+  statistics.speed /= flock.Size();
+  statistics.spread = std::sqrt(statistics.spread / flock.Size());
+  return statistics;
+}
+
+}  // namespace
+
+TEST_CASE("Single precision World tracks the double precision World") {
+  SECTION("Boids spawn at the same positions") {
+    World world(0, 0, 600, 600, 200, 4);
+    World2f world_2f(0, 0, 600, 600, 200, 4);
+    for(size_t index = 0; index < world.GetBoids().Size(); ++index) {
+      const MathVector& position = world.GetBoids().positions_[index];
+      REQUIRE(world_2f.GetBoids().positions_[index].x_ == Approx(position.x_));
+      REQUIRE(world_2f.GetBoids().positions_[index].y_ == Approx(position.y_));
+    }
+  }
+
+  SECTION("Sparse trajectories stay within a tenth of a pixel") {
+    World world(0, 0, 3000, 3000, 400, 4);
+    World2f world_2f(0, 0, 3000, 3000, 400, 4);
+    //Double buffered so neither World's result depends on the order of its Boids
+    world.SetDoubleBuffered(true);
+    world_2f.SetDoubleBuffered(true);
+    for(size_t step = 0; step < 50; ++step) {
+      world.Update();
+      world_2f.Update();
+    }
+    REQUIRE(world_2f.GetBoids().Size() == world.GetBoids().Size());
+    for(size_t index = 0; index < world.GetBoids().Size(); ++index) {
+      MathVector position(world_2f.GetBoids().positions_[index]);
+      REQUIRE(position.Distance(world.GetBoids().positions_[index]) < 0.1);
+    }
+  }
+
+  SECTION("Dense flocks keep the same statistics over many steps") {
+    //Single Boids diverge once rounding tips a neighbor in or out of sight,
+    //so only the flock as a whole is compared
+    World world(0, 0, 600, 600, 400, 4);
+    World2f world_2f(0, 0, 600, 600, 400, 4);
+    FlockStatistics totals, totals_2f;
+    const size_t kSteps = 600;
+    for(size_t step = 0; step < kSteps; ++step) {
+      world.Update();
+      world_2f.Update();
+      if(step >= kSteps / 2) {
+        FlockStatistics statistics = MeasureFlock(world.GetBoids());
+        FlockStatistics statistics_2f = MeasureFlock(world_2f.GetBoids());
+        totals.speed += statistics.speed;
+        totals.spread += statistics.spread;
+        totals_2f.speed += statistics_2f.speed;
+        totals_2f.spread += statistics_2f.spread;
+      }
+    }
+    REQUIRE(totals_2f.speed == Approx(totals.speed).epsilon(0.03));
+    REQUIRE(totals_2f.spread == Approx(totals.spread).epsilon(0.05));
+  }
+}
+
+TEST_CASE("Deterministic Updates do not depend on the thread count") {
+  auto run = [](size_t thread_count, size_t adaptive_interval) {
+    World world(0, 0, 1200, 900, 0, 0, boidsimulation::WorldParameters(), 11);
+    world.SetThreadCount(thread_count);
+    world.SetDeterministic(true);
+    world.SetAdaptiveInterval(adaptive_interval);
+    world.SpawnBulk(1000, {0, 0, 1200, 900}, SpawnDistribution::kNormal);
+    world.SpawnBulk(30, {0, 0, 1200, 900}, SpawnDistribution::kUniform, true);
+    world.AddObstacle(MathVector(400, 400, 0));
+    world.AddObstacle(MathVector(800, 300, 0));
+    for(size_t step = 0; step < 60; ++step) {
+      world.Update();
+    }
+    REQUIRE(world.GetCatchStats().total_caught > 0);
+    return world.GetStateHash();
+  };
+
+  SECTION("Same hash on 1, 4, 7 and one thread per core") {
+    for(size_t adaptive_interval : {1, 4}) {
+      uint64_t hash = run(1, adaptive_interval);
+      REQUIRE(run(4, adaptive_interval) == hash);
+      REQUIRE(run(7, adaptive_interval) == hash);
+      REQUIRE(run(0, adaptive_interval) == hash);
+    }
+  }
+
+  SECTION("The hash changes with the state") {
+    World world(0, 0, 600, 600, 100, 2);
+    world.SetDeterministic(true);
+    uint64_t hash = world.GetStateHash();
+    world.Update();
+    REQUIRE(world.GetStateHash() != hash);
+    REQUIRE(world.IsDeterministic());
+
+    //Same Boids, different rule scales
+    boidsimulation::WorldParameters parameters;
+    parameters.separation = 2;
+    World other(0, 0, 600, 600, 100, 2, parameters);
+    World same(0, 0, 600, 600, 100, 2);
+    REQUIRE(other.GetBoids().positions_ == same.GetBoids().positions_);
+    REQUIRE(other.GetStateHash() != same.GetStateHash());
+  }
+}